@@ -0,0 +1,237 @@
+/* bench_c_mapping.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * UpsfMapping::map() per item type, C++ to C and C to C++
+ */
+
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "upsf.h"
+#include "upsf_c_mapping.hpp"
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+using namespace wt474_messages::v1;
+
+namespace {
+
+void fill_metadata(MetaData* metadata)
+{
+    metadata->set_description("benchmark item");
+    metadata->mutable_created()->set_seconds(1700000000);
+    metadata->mutable_last_updated()->set_seconds(1700000100);
+    metadata->set_derived_state(DerivedState::active);
+}
+
+void fill_endpoint(NetworkConnection::Spec::Endpoint* endpoint, const std::string& name)
+{
+    endpoint->set_endpoint_name(name);
+    endpoint->mutable_vtep()->set_ip_address("192.168.0.1");
+    endpoint->mutable_vtep()->set_udp_port(4789);
+    endpoint->mutable_vtep()->set_vni(1000);
+}
+
+struct service_gateway {
+    typedef ServiceGateway msg_t;
+    typedef upsf_service_gateway_t c_t;
+    static msg_t make()
+    {
+        msg_t sg;
+        sg.set_name("sg-0001");
+        fill_metadata(sg.mutable_metadata());
+        return sg;
+    }
+};
+
+struct service_gateway_user_plane {
+    typedef ServiceGatewayUserPlane msg_t;
+    typedef upsf_service_gateway_user_plane_t c_t;
+    static msg_t make()
+    {
+        msg_t up;
+        up.set_name("up-0001");
+        up.set_service_gateway_name("sg-0001");
+        fill_metadata(up.mutable_metadata());
+        up.mutable_spec()->set_max_session_count(65536);
+        up.mutable_spec()->set_max_shards(16);
+        for (int i = 0; i < 4; i++) {
+            up.mutable_spec()->add_supported_service_group("service-group-" + std::to_string(i));
+        }
+        fill_endpoint(up.mutable_spec()->mutable_default_endpoint(), "up-0001-ep");
+        up.mutable_status()->set_allocated_session_count(1024);
+        up.mutable_status()->set_allocated_shards(4);
+        return up;
+    }
+};
+
+struct traffic_steering_function {
+    typedef TrafficSteeringFunction msg_t;
+    typedef upsf_traffic_steering_function_t c_t;
+    static msg_t make()
+    {
+        msg_t tsf;
+        tsf.set_name("tsf-0001");
+        fill_metadata(tsf.mutable_metadata());
+        fill_endpoint(tsf.mutable_spec()->mutable_default_endpoint(), "tsf-0001-ep");
+        return tsf;
+    }
+};
+
+struct network_connection {
+    typedef NetworkConnection msg_t;
+    typedef upsf_network_connection_t c_t;
+    static msg_t make()
+    {
+        msg_t nc;
+        nc.set_name("nc-0001");
+        fill_metadata(nc.mutable_metadata());
+        nc.mutable_spec()->set_maximum_supported_quality(100);
+        fill_endpoint(nc.mutable_spec()->mutable_ms_mptp()->mutable_sgup_endpoint(), "up-0001-ep");
+        for (int i = 0; i < 4; i++) {
+            fill_endpoint(nc.mutable_spec()->mutable_ms_mptp()->add_tsf_endpoint(), "tsf-ep-" + std::to_string(i));
+            (*nc.mutable_status()->mutable_nc_active())["tsf-ep-" + std::to_string(i)] = true;
+        }
+        nc.mutable_status()->set_allocated_shards(4);
+        return nc;
+    }
+};
+
+struct shard {
+    typedef Shard msg_t;
+    typedef upsf_shard_t c_t;
+    static msg_t make()
+    {
+        msg_t shard;
+        shard.set_name("shard-0001");
+        fill_metadata(shard.mutable_metadata());
+        shard.mutable_spec()->set_max_session_count(4096);
+        shard.mutable_spec()->set_virtual_mac("02:00:00:00:00:01");
+        shard.mutable_spec()->mutable_desired_state()->set_service_gateway_user_plane("up-0001");
+        for (int i = 0; i < 4; i++) {
+            shard.mutable_spec()->mutable_desired_state()->add_network_connection("nc-000" + std::to_string(i));
+            (*shard.mutable_status()->mutable_current_state()->mutable_tsf_network_connection())["tsf-000" + std::to_string(i)] = "nc-000" + std::to_string(i);
+        }
+        for (int i = 0; i < 16; i++) {
+            shard.mutable_spec()->add_prefix("10.0." + std::to_string(i) + ".0/24");
+        }
+        shard.mutable_status()->set_allocated_session_count(1024);
+        shard.mutable_status()->set_maximum_allocated_quality(100);
+        shard.mutable_status()->add_service_groups_supported("basic-internet");
+        shard.mutable_status()->mutable_current_state()->set_service_gateway_user_plane("up-0001");
+        shard.mutable_mbb()->set_mbb_state(Shard::Mbb::mbb_complete);
+        return shard;
+    }
+};
+
+struct session_context {
+    typedef SessionContext msg_t;
+    typedef upsf_session_context_t c_t;
+    static msg_t make()
+    {
+        msg_t sctx;
+        sctx.set_name("session-0001");
+        fill_metadata(sctx.mutable_metadata());
+        sctx.mutable_spec()->set_traffic_steering_function("tsf-0001");
+        sctx.mutable_spec()->add_required_service_group("basic-internet");
+        sctx.mutable_spec()->set_required_quality(100);
+        sctx.mutable_spec()->set_circuit_id("circuit-0001");
+        sctx.mutable_spec()->set_remote_id("remote-0001");
+        sctx.mutable_spec()->mutable_session_filter()->set_source_mac_address("02:00:00:00:01:01");
+        sctx.mutable_spec()->mutable_session_filter()->set_svlan(100);
+        sctx.mutable_spec()->mutable_session_filter()->set_cvlan(200);
+        sctx.mutable_spec()->mutable_desired_state()->set_shard("shard-0001");
+        sctx.mutable_spec()->set_network_connection("nc-0001");
+        sctx.mutable_status()->mutable_current_state()->set_user_plane_shard("shard-0001");
+        sctx.mutable_status()->mutable_current_state()->set_tsf_shard("shard-0001");
+        return sctx;
+    }
+};
+
+}; // end anonymous namespace
+
+/* C++ to C, the target struct gets reset first */
+template<typename T>
+static void BM_map_to_c(benchmark::State& state)
+{
+    const typename T::msg_t msg = T::make();
+    auto to = std::make_unique<typename T::c_t>();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(upsf::UpsfMapping::map(msg, *to));
+        benchmark::ClobberMemory();
+    }
+}
+
+/* C++ to C, reusing a struct holding the result of a previous mapping */
+template<typename T>
+static void BM_map_to_c_reuse(benchmark::State& state)
+{
+    const typename T::msg_t msg = T::make();
+    auto to = std::make_unique<typename T::c_t>();
+    upsf::UpsfMapping::map(msg, *to);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(upsf::UpsfMapping::map(msg, *to, false));
+        benchmark::ClobberMemory();
+    }
+}
+
+/* C to C++ */
+template<typename T>
+static void BM_map_from_c(benchmark::State& state)
+{
+    auto from = std::make_unique<typename T::c_t>();
+    upsf::UpsfMapping::map(T::make(), *from);
+    typename T::msg_t to;
+    for (auto _ : state) {
+        to.Clear();
+        benchmark::DoNotOptimize(upsf::UpsfMapping::map(*from, to));
+    }
+}
+
+#define UPSF_BENCHMARK_MAPPING(type) \
+    BENCHMARK_TEMPLATE(BM_map_to_c, type); \
+    BENCHMARK_TEMPLATE(BM_map_to_c_reuse, type); \
+    BENCHMARK_TEMPLATE(BM_map_from_c, type)
+
+UPSF_BENCHMARK_MAPPING(service_gateway);
+UPSF_BENCHMARK_MAPPING(service_gateway_user_plane);
+UPSF_BENCHMARK_MAPPING(traffic_steering_function);
+UPSF_BENCHMARK_MAPPING(network_connection);
+UPSF_BENCHMARK_MAPPING(shard);
+UPSF_BENCHMARK_MAPPING(session_context);
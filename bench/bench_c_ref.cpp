@@ -0,0 +1,179 @@
+/* bench_c_ref.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * item reference accessors vs mapping into the fixed size C structs:
+ * a subscriber reading a few fields of each notified item
+ */
+
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "upsf.h"
+#include "upsf_c_mapping.hpp"
+#include "upsf_c_ref.hpp"
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+using namespace wt474_messages::v1;
+
+namespace {
+
+std::shared_ptr<const Item> make_shard()
+{
+    auto item = std::make_shared<Item>();
+    auto shard = item->mutable_shard();
+    shard->set_name("shard-0001");
+    shard->mutable_metadata()->set_description("benchmark shard");
+    shard->mutable_spec()->set_max_session_count(4096);
+    shard->mutable_spec()->set_virtual_mac("02:00:00:00:00:01");
+    shard->mutable_spec()->mutable_desired_state()->set_service_gateway_user_plane("up-0001");
+    for (int i = 0; i < 4; i++) {
+        shard->mutable_spec()->mutable_desired_state()->add_network_connection("nc-000" + std::to_string(i));
+    }
+    for (int i = 0; i < 16; i++) {
+        shard->mutable_spec()->add_prefix("10.0." + std::to_string(i) + ".0/24");
+    }
+    shard->mutable_status()->set_allocated_session_count(1024);
+    shard->mutable_status()->mutable_current_state()->set_service_gateway_user_plane("up-0001");
+    return item;
+}
+
+std::shared_ptr<const Item> make_session_context()
+{
+    auto item = std::make_shared<Item>();
+    auto sctx = item->mutable_session_context();
+    sctx->set_name("session-0001");
+    sctx->mutable_spec()->set_traffic_steering_function("tsf-0001");
+    sctx->mutable_spec()->add_required_service_group("basic-internet");
+    sctx->mutable_spec()->set_required_quality(100);
+    sctx->mutable_spec()->set_circuit_id("circuit-0001");
+    sctx->mutable_spec()->set_remote_id("remote-0001");
+    sctx->mutable_spec()->mutable_session_filter()->set_source_mac_address("02:00:00:00:01:01");
+    sctx->mutable_spec()->mutable_session_filter()->set_svlan(100);
+    sctx->mutable_spec()->mutable_session_filter()->set_cvlan(200);
+    sctx->mutable_spec()->mutable_desired_state()->set_shard("shard-0001");
+    sctx->mutable_status()->mutable_current_state()->set_user_plane_shard("shard-0001");
+    return item;
+}
+
+}; // end anonymous namespace
+
+/* shard: map into upsf_shard_t, then read name, state and prefixes */
+static void BM_shard_struct_mapping(benchmark::State& state)
+{
+    auto item = make_shard();
+    auto shard = std::make_unique<upsf_shard_t>();
+    for (auto _ : state) {
+        upsf::UpsfMapping::map(item->shard(), *shard);
+        size_t len = shard->name.len;
+        for (size_t i = 0; i < shard->spec.prefix_size; i++) {
+            len += shard->spec.prefix[i].len;
+        }
+        benchmark::DoNotOptimize(len);
+        benchmark::DoNotOptimize(shard->metadata.derived_state);
+    }
+}
+BENCHMARK(BM_shard_struct_mapping);
+
+/* shard: as above, with a reused buffer cleared partially only */
+static void BM_shard_struct_mapping_reuse(benchmark::State& state)
+{
+    auto item = make_shard();
+    auto shard = std::make_unique<upsf_shard_t>();
+    upsf::UpsfMapping::map(item->shard(), *shard);
+    for (auto _ : state) {
+        upsf::UpsfMapping::map(item->shard(), *shard, false);
+        size_t len = shard->name.len;
+        for (size_t i = 0; i < shard->spec.prefix_size; i++) {
+            len += shard->spec.prefix[i].len;
+        }
+        benchmark::DoNotOptimize(len);
+        benchmark::DoNotOptimize(shard->metadata.derived_state);
+    }
+}
+BENCHMARK(BM_shard_struct_mapping_reuse);
+
+/* shard: hand out a reference, then read the same fields via accessors */
+static void BM_shard_item_ref(benchmark::State& state)
+{
+    auto item = make_shard();
+    for (auto _ : state) {
+        upsf_item_ref_t* ref = new upsf_item_ref_s(item);
+        size_t len = 0, n = 0;
+        benchmark::DoNotOptimize(upsf_item_ref_name(ref, &n));
+        len += n;
+        for (size_t i = 0; i < upsf_shard_prefix_size(ref); i++) {
+            benchmark::DoNotOptimize(upsf_shard_prefix_at(ref, i, &n));
+            len += n;
+        }
+        benchmark::DoNotOptimize(len);
+        benchmark::DoNotOptimize(upsf_item_ref_derived_state(ref));
+        upsf_item_ref_release(ref);
+    }
+}
+BENCHMARK(BM_shard_item_ref);
+
+/* session context: map into upsf_session_context_t, read a few fields */
+static void BM_session_context_struct_mapping(benchmark::State& state)
+{
+    auto item = make_session_context();
+    auto sctx = std::make_unique<upsf_session_context_t>();
+    for (auto _ : state) {
+        upsf::UpsfMapping::map(item->session_context(), *sctx);
+        benchmark::DoNotOptimize(sctx->name.len);
+        benchmark::DoNotOptimize(sctx->spec.desired_state.shard.len);
+        benchmark::DoNotOptimize(sctx->spec.session_filter.svlan);
+    }
+}
+BENCHMARK(BM_session_context_struct_mapping);
+
+/* session context: same fields via item reference accessors */
+static void BM_session_context_item_ref(benchmark::State& state)
+{
+    auto item = make_session_context();
+    for (auto _ : state) {
+        upsf_item_ref_t* ref = new upsf_item_ref_s(item);
+        size_t n = 0;
+        benchmark::DoNotOptimize(upsf_item_ref_name(ref, &n));
+        benchmark::DoNotOptimize(upsf_session_context_desired_shard(ref, &n));
+        benchmark::DoNotOptimize(upsf_session_context_svlan(ref));
+        upsf_item_ref_release(ref);
+    }
+}
+BENCHMARK(BM_session_context_item_ref);
@@ -0,0 +1,218 @@
+/* bench_cache.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * concurrent UpsfCache reads while a writer applies a watch update storm,
+ * compared with a replica guarded by a std::shared_mutex
+ */
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "upsf_cache.hpp"
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+using namespace wt474_messages::v1;
+using wt474_upsf_service::v1::ItemType;
+
+namespace {
+
+// number of cached session contexts
+constexpr size_t num_items = 16384;
+
+std::vector<std::string> names;
+std::vector<upsf::UpsfCache::ItemPtr> updates;
+
+/* session contexts and a second version of each for the update storm */
+void make_items()
+{
+    if (!names.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < num_items; i++) {
+        names.push_back("session-" + std::to_string(i));
+    }
+    for (size_t i = 0; i < 2 * num_items; i++) {
+        auto item = std::make_shared<Item>();
+        auto sctx = item->mutable_session_context();
+        sctx->set_name(names[i % num_items]);
+        sctx->mutable_metadata()->set_derived_state(DerivedState::active);
+        sctx->mutable_metadata()->mutable_last_updated()->set_seconds(i);
+        sctx->mutable_spec()->mutable_desired_state()->set_shard("shard-" + std::to_string(i % 64));
+        updates.push_back(item);
+    }
+}
+
+/**
+ * replica guarded by a reader/writer lock, readers wait for the writer
+ */
+class LockedReplica {
+public:
+    void put(
+        const upsf::UpsfCache::ItemPtr& item)
+    {
+        std::unique_lock lock(mutex);
+        items[item->session_context().name()] = item;
+    };
+
+    bool contains(
+        const std::string& name) const
+    {
+        std::shared_lock lock(mutex);
+        return items.find(name) != items.end();
+    };
+
+private:
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, upsf::UpsfCache::ItemPtr> items;
+};
+
+upsf::UpsfCache* cache = nullptr;
+LockedReplica* replica = nullptr;
+
+/**
+ * writer thread applying updates one by one as a watch stream does
+ */
+class Storm {
+public:
+    template <typename T>
+    void start(
+        T& target)
+    {
+        stopping = false;
+        writer = std::thread([this, &target]() {
+            for (size_t i = 0; !stopping.load(std::memory_order_relaxed); i++) {
+                target.put(updates[i % updates.size()]);
+                applied.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    };
+
+    void stop()
+    {
+        if (writer.joinable()) {
+            stopping = true;
+            writer.join();
+        }
+    };
+
+    std::atomic<uint64_t> applied { 0 };
+
+private:
+    std::atomic<bool> stopping { false };
+    std::thread writer;
+};
+
+Storm storm;
+
+void setup_cache(const benchmark::State&)
+{
+    make_items();
+    cache = new upsf::UpsfCache();
+    for (size_t i = 0; i < num_items; i++) {
+        cache->put(updates[i]);
+    }
+}
+
+void setup_cache_storm(const benchmark::State& state)
+{
+    setup_cache(state);
+    storm.start(*cache);
+}
+
+void teardown_cache(const benchmark::State&)
+{
+    storm.stop();
+    delete cache;
+    cache = nullptr;
+}
+
+void setup_replica(const benchmark::State&)
+{
+    make_items();
+    replica = new LockedReplica();
+    for (size_t i = 0; i < num_items; i++) {
+        replica->put(updates[i]);
+    }
+}
+
+void setup_replica_storm(const benchmark::State& state)
+{
+    setup_replica(state);
+    storm.start(*replica);
+}
+
+void teardown_replica(const benchmark::State&)
+{
+    storm.stop();
+    delete replica;
+    replica = nullptr;
+}
+
+}; // end anonymous namespace
+
+/* lookups by name in a View, a View per lookup as a per-packet handler does */
+static void BM_cache_read(benchmark::State& state)
+{
+    size_t i = state.thread_index() * 7919;
+    for (auto _ : state) {
+        upsf::UpsfCache::View view = cache->view();
+        benchmark::DoNotOptimize(view.find(ItemType::session_context, names[i++ % num_items]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_cache_read)->Setup(setup_cache)->Teardown(teardown_cache)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_cache_read)->Name("BM_cache_read_update_storm")->Setup(setup_cache_storm)->Teardown(teardown_cache)->ThreadRange(1, 8)->UseRealTime();
+
+/* lookups by name in the locked replica */
+static void BM_locked_read(benchmark::State& state)
+{
+    size_t i = state.thread_index() * 7919;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(replica->contains(names[i++ % num_items]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_locked_read)->Setup(setup_replica)->Teardown(teardown_replica)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_locked_read)->Name("BM_locked_read_update_storm")->Setup(setup_replica_storm)->Teardown(teardown_replica)->ThreadRange(1, 8)->UseRealTime();
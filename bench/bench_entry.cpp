@@ -0,0 +1,127 @@
+/* bench_entry.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+/*
+ * heap bytes per UpsfCache entry, for session contexts and user planes
+ * carrying service groups, items allocated up front are not counted
+ */
+
+#include <malloc.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "upsf_cache.hpp"
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+using namespace wt474_messages::v1;
+
+namespace {
+
+// number of cached items
+constexpr size_t num_items = 16384;
+
+// service groups per item
+constexpr size_t num_groups = 4;
+
+std::vector<upsf::UpsfCache::ItemPtr> sessions;
+std::vector<upsf::UpsfCache::ItemPtr> user_planes;
+
+/* items drawing their service groups from a few recurring sets */
+void make_items()
+{
+    if (!sessions.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < num_items; i++) {
+        auto item = std::make_shared<Item>();
+        auto sctx = item->mutable_session_context();
+        sctx->set_name("session-" + std::to_string(i));
+        sctx->mutable_spec()->mutable_desired_state()->set_shard("shard-" + std::to_string(i % 64));
+        for (size_t g = 0; g < num_groups; g++) {
+            sctx->mutable_spec()->add_required_service_group("group-" + std::to_string((i + g) % 8));
+        }
+        sessions.push_back(item);
+
+        item = std::make_shared<Item>();
+        auto up = item->mutable_service_gateway_user_plane();
+        up->set_name("up-" + std::to_string(i));
+        up->set_service_gateway_name("sg-" + std::to_string(i % 16));
+        for (size_t g = 0; g < num_groups; g++) {
+            up->mutable_spec()->add_supported_service_group("group-" + std::to_string((i * 3 + g) % 8));
+        }
+        user_planes.push_back(item);
+    }
+}
+
+/* heap bytes allocated by filling a cache, per item */
+void fill(
+    benchmark::State& state,
+    const std::vector<upsf::UpsfCache::ItemPtr>& items)
+{
+    make_items();
+    double bytes = 0;
+    for (auto _ : state) {
+        size_t before = mallinfo2().uordblks;
+        {
+            upsf::UpsfCache cache;
+            for (const auto& item : items) {
+                cache.put(item);
+            }
+            bytes += double(mallinfo2().uordblks - before) / items.size();
+        }
+    }
+    state.counters["bytes_per_entry"] = benchmark::Counter(bytes, benchmark::Counter::kAvgIterations);
+}
+
+}; // end anonymous namespace
+
+static void BM_entry_session_context(benchmark::State& state)
+{
+    fill(state, sessions);
+}
+BENCHMARK(BM_entry_session_context);
+
+static void BM_entry_user_plane(benchmark::State& state)
+{
+    fill(state, user_planes);
+}
+BENCHMARK(BM_entry_user_plane);
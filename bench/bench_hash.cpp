@@ -0,0 +1,162 @@
+/* bench_hash.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * content hash and equality by direct field access (upsf_hash.hpp) vs
+ * hashing and comparing the deterministically serialized messages
+ */
+
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include "upsf_hash.hpp"
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+using namespace wt474_messages::v1;
+
+namespace {
+
+Item make_shard()
+{
+    Item item;
+    auto shard = item.mutable_shard();
+    shard->set_name("shard-0001");
+    shard->mutable_metadata()->set_description("benchmark shard");
+    shard->mutable_metadata()->mutable_last_updated()->set_seconds(1700000000);
+    shard->mutable_spec()->set_max_session_count(4096);
+    shard->mutable_spec()->set_virtual_mac("02:00:00:00:00:01");
+    shard->mutable_spec()->mutable_desired_state()->set_service_gateway_user_plane("up-0001");
+    for (int i = 0; i < 4; i++) {
+        shard->mutable_spec()->mutable_desired_state()->add_network_connection("nc-000" + std::to_string(i));
+    }
+    for (int i = 0; i < 16; i++) {
+        shard->mutable_spec()->add_prefix("10.0." + std::to_string(i) + ".0/24");
+    }
+    shard->mutable_status()->set_allocated_session_count(1024);
+    shard->mutable_status()->mutable_current_state()->set_service_gateway_user_plane("up-0001");
+    for (int i = 0; i < 4; i++) {
+        (*shard->mutable_status()->mutable_current_state()->mutable_tsf_network_connection())["tsf-000" + std::to_string(i)] = "nc-000" + std::to_string(i);
+    }
+    return item;
+}
+
+Item make_session_context()
+{
+    Item item;
+    auto sctx = item.mutable_session_context();
+    sctx->set_name("session-0001");
+    sctx->mutable_metadata()->mutable_last_updated()->set_seconds(1700000000);
+    sctx->mutable_spec()->set_traffic_steering_function("tsf-0001");
+    sctx->mutable_spec()->add_required_service_group("basic-internet");
+    sctx->mutable_spec()->add_required_service_group("iptv");
+    sctx->mutable_spec()->set_required_quality(100);
+    sctx->mutable_spec()->set_circuit_id("circuit-0001");
+    sctx->mutable_spec()->set_remote_id("remote-0001");
+    sctx->mutable_spec()->mutable_session_filter()->set_source_mac_address("02:00:00:00:01:01");
+    sctx->mutable_spec()->mutable_session_filter()->set_svlan(100);
+    sctx->mutable_spec()->mutable_session_filter()->set_cvlan(200);
+    sctx->mutable_spec()->mutable_desired_state()->set_shard("shard-0001");
+    sctx->mutable_status()->mutable_current_state()->set_user_plane_shard("shard-0001");
+    return item;
+}
+
+/* deterministic serialization, map entries in key order */
+std::string serialize(const Item& item)
+{
+    std::string buf;
+    google::protobuf::io::StringOutputStream output(&buf);
+    google::protobuf::io::CodedOutputStream coded(&output);
+    coded.SetSerializationDeterministic(true);
+    item.SerializeToCodedStream(&coded);
+    coded.Trim();
+    return buf;
+}
+
+}; // end anonymous namespace
+
+template <Item (*make)()>
+static void BM_hash_upsf(benchmark::State& state)
+{
+    Item item = make();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(upsf::UpsfHashing::hash(item));
+    }
+}
+
+template <Item (*make)()>
+static void BM_hash_serialized(benchmark::State& state)
+{
+    Item item = make();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(std::hash<std::string>()(serialize(item)));
+    }
+}
+
+/* equal copies: the full comparison runs on both sides */
+template <Item (*make)()>
+static void BM_equal_upsf(benchmark::State& state)
+{
+    Item a = make();
+    Item b = make();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(upsf::UpsfHashing::equal(a, b));
+    }
+}
+
+template <Item (*make)()>
+static void BM_equal_serialized(benchmark::State& state)
+{
+    Item a = make();
+    Item b = make();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(serialize(a) == serialize(b));
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_hash_upsf, make_shard);
+BENCHMARK_TEMPLATE(BM_hash_serialized, make_shard);
+BENCHMARK_TEMPLATE(BM_equal_upsf, make_shard);
+BENCHMARK_TEMPLATE(BM_equal_serialized, make_shard);
+BENCHMARK_TEMPLATE(BM_hash_upsf, make_session_context);
+BENCHMARK_TEMPLATE(BM_hash_serialized, make_session_context);
+BENCHMARK_TEMPLATE(BM_equal_upsf, make_session_context);
+BENCHMARK_TEMPLATE(BM_equal_serialized, make_session_context);
@@ -0,0 +1,162 @@
+/* bench_stream.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * upsf_dump_*() formatting into the caller's buffer vs the former
+ * std::stringstream based path
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "upsf.h"
+#include "upsf_c_mapping.hpp"
+#include "upsf_stream.hpp"
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+using namespace wt474_messages::v1;
+
+namespace {
+
+std::unique_ptr<upsf_shard_t> make_shard()
+{
+    Shard shard;
+    shard.set_name("shard-0001");
+    shard.mutable_metadata()->set_description("benchmark shard");
+    shard.mutable_metadata()->mutable_last_updated()->set_seconds(1700000100);
+    shard.mutable_spec()->set_max_session_count(4096);
+    shard.mutable_spec()->set_virtual_mac("02:00:00:00:00:01");
+    shard.mutable_spec()->mutable_desired_state()->set_service_gateway_user_plane("up-0001");
+    for (int i = 0; i < 4; i++) {
+        shard.mutable_spec()->mutable_desired_state()->add_network_connection("nc-000" + std::to_string(i));
+        (*shard.mutable_status()->mutable_current_state()->mutable_tsf_network_connection())["tsf-000" + std::to_string(i)] = "nc-000" + std::to_string(i);
+    }
+    for (int i = 0; i < 8; i++) {
+        shard.mutable_spec()->add_prefix("10.0." + std::to_string(i) + ".0/24");
+    }
+    shard.mutable_status()->mutable_current_state()->set_service_gateway_user_plane("up-0001");
+
+    auto to = std::make_unique<upsf_shard_t>();
+    upsf::UpsfMapping::map(shard, *to);
+    return to;
+}
+
+std::unique_ptr<upsf_session_context_t> make_session_context()
+{
+    SessionContext sctx;
+    sctx.set_name("session-0001");
+    sctx.mutable_metadata()->mutable_last_updated()->set_seconds(1700000100);
+    sctx.mutable_spec()->set_traffic_steering_function("tsf-0001");
+    sctx.mutable_spec()->add_required_service_group("basic-internet");
+    sctx.mutable_spec()->set_circuit_id("circuit-0001");
+    sctx.mutable_spec()->set_remote_id("remote-0001");
+    sctx.mutable_spec()->mutable_session_filter()->set_source_mac_address("02:00:00:00:01:01");
+    sctx.mutable_spec()->mutable_session_filter()->set_svlan(100);
+    sctx.mutable_spec()->mutable_session_filter()->set_cvlan(200);
+    sctx.mutable_spec()->mutable_desired_state()->set_shard("shard-0001");
+    sctx.mutable_status()->mutable_current_state()->set_user_plane_shard("shard-0001");
+
+    auto to = std::make_unique<upsf_session_context_t>();
+    upsf::UpsfMapping::map(sctx, *to);
+    return to;
+}
+
+/* former dump path: fresh item, std::stringstream, str() copies, strncpy */
+template <typename M, typename S, typename C>
+char* dump_stringstream(char* str, size_t size, const C* elem)
+{
+    M item;
+    upsf::UpsfMapping::map(*elem, item);
+
+    std::stringstream sstr;
+    sstr << S(item);
+
+    strncpy(str, sstr.str().c_str(), std::min(size, sstr.str().size()));
+
+    return str;
+}
+
+}; // end anonymous namespace
+
+static void BM_dump_shard_stringstream(benchmark::State& state)
+{
+    auto shard = make_shard();
+    char buf[2048];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dump_stringstream<Shard, upsf::ShardStream>(buf, sizeof(buf), shard.get()));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_dump_shard_stringstream);
+
+static void BM_dump_shard(benchmark::State& state)
+{
+    auto shard = make_shard();
+    char buf[2048];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(upsf_dump_shard(buf, sizeof(buf), shard.get()));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_dump_shard);
+
+static void BM_dump_session_context_stringstream(benchmark::State& state)
+{
+    auto sctx = make_session_context();
+    char buf[2048];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dump_stringstream<SessionContext, upsf::SessionContextStream>(buf, sizeof(buf), sctx.get()));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_dump_session_context_stringstream);
+
+static void BM_dump_session_context(benchmark::State& state)
+{
+    auto sctx = make_session_context();
+    char buf[2048];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(upsf_dump_session_context(buf, sizeof(buf), sctx.get()));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_dump_session_context);
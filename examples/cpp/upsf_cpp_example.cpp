@@ -37,6 +37,7 @@
 
 #include <gflags/gflags.h>
 
+#include <sstream>
 #include <string>
 
 using namespace upsf;
@@ -89,11 +90,12 @@ void UpsfCppExample::sg_read(const std::string& sg_name)
  */
 bool UpsfCppExample::sg_exists(const std::string& sg_name)
 {
-    wt474_messages::v1::ServiceGateway r_reply;
-    if (!client.ReadV1(sg_name, r_reply)) {
+    /* existence check, the item itself is not transferred */
+    bool exists = false;
+    if (!client.Exists(wt474_upsf_service::v1::ItemType::service_gateway, sg_name, exists)) {
         return false;
     }
-    return true;
+    return exists;
 }
 
 /*
@@ -224,11 +226,12 @@ void UpsfCppExample::up_read(const std::string& up_name)
  */
 bool UpsfCppExample::up_exists(const std::string& up_name)
 {
-    wt474_messages::v1::ServiceGatewayUserPlane r_reply;
-    if (!client.ReadV1(up_name, r_reply)) {
+    /* existence check, the item itself is not transferred */
+    bool exists = false;
+    if (!client.Exists(wt474_upsf_service::v1::ItemType::service_gateway_user_plane, up_name, exists)) {
         return false;
     }
-    return true;
+    return exists;
 }
 
 /*
@@ -377,11 +380,12 @@ void UpsfCppExample::tsf_read(const std::string& tsf_name)
  */
 bool UpsfCppExample::tsf_exists(const std::string& tsf_name)
 {
-    wt474_messages::v1::TrafficSteeringFunction r_reply;
-    if (!client.ReadV1(tsf_name, r_reply)) {
+    /* existence check, the item itself is not transferred */
+    bool exists = false;
+    if (!client.Exists(wt474_upsf_service::v1::ItemType::traffic_steering_function, tsf_name, exists)) {
         return false;
     }
-    return true;
+    return exists;
 }
 
 /*
@@ -520,11 +524,12 @@ void UpsfCppExample::sgrp_read(const std::string& sgrp_name)
  */
 bool UpsfCppExample::sgrp_exists(const std::string& sgrp_name)
 {
-    wt474_messages::v1::Shard r_reply;
-    if (!client.ReadV1(sgrp_name, r_reply)) {
+    /* existence check, the item itself is not transferred */
+    bool exists = false;
+    if (!client.Exists(wt474_upsf_service::v1::ItemType::shard, sgrp_name, exists)) {
         return false;
     }
-    return true;
+    return exists;
 }
 
 /*
@@ -668,11 +673,12 @@ void UpsfCppExample::sctx_read(const std::string& sctx_name)
  */
 bool UpsfCppExample::sctx_exists(const std::string& sctx_name)
 {
-    wt474_messages::v1::SessionContext r_reply;
-    if (!client.ReadV1(sctx_name, r_reply)) {
+    /* existence check, the item itself is not transferred */
+    bool exists = false;
+    if (!client.Exists(wt474_upsf_service::v1::ItemType::session_context, sctx_name, exists)) {
         return false;
     }
-    return true;
+    return exists;
 }
 
 /*
@@ -807,11 +813,12 @@ void UpsfCppExample::nc_read(const std::string& nc_name)
  */
 bool UpsfCppExample::nc_exists(const std::string& nc_name)
 {
-    wt474_messages::v1::SessionContext r_reply;
-    if (!client.ReadV1(nc_name, r_reply)) {
+    /* existence check, the item itself is not transferred */
+    bool exists = false;
+    if (!client.Exists(wt474_upsf_service::v1::ItemType::network_connection, nc_name, exists)) {
         return false;
     }
-    return true;
+    return exists;
 }
 
 /*
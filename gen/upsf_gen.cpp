@@ -0,0 +1,1071 @@
+/* upsf_gen.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+/*
+ * upsf_gen generates the C structs of upsf.h, the UpsfMapping::map()
+ * functions in both directions and the stream formatters from the
+ * descriptors of messages_v1.proto and the C options in upsf_c.options
+ *
+ * usage: upsf_gen <descriptor set> <options> <output directory>
+ *
+ * The descriptor set is written by protoc --include_imports
+ * --descriptor_set_out, its last file is the one to generate code for.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::EnumDescriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FileDescriptor;
+using google::protobuf::FileDescriptorSet;
+using google::protobuf::OneofDescriptor;
+
+namespace {
+
+/**
+ * options by kind and full name of a descriptor element, flags have an
+ * empty value
+ */
+class Options {
+public:
+    /**
+   * read options file, returns false on syntax errors
+   */
+    bool load(
+        const std::string& filename)
+    {
+        static const std::set<std::string> kinds = { "message", "enum", "value", "field", "oneof" };
+
+        std::ifstream in(filename);
+        if (!in) {
+            std::cerr << "upsf_gen: unable to read " << filename << std::endl;
+            return false;
+        }
+        std::string line;
+        for (size_t lineno = 1; std::getline(in, line); lineno++) {
+            std::istringstream tokens(line.substr(0, line.find('#')));
+            std::string kind, name, option;
+            if (!(tokens >> kind)) {
+                continue;
+            }
+            if (!kinds.count(kind) || !(tokens >> name)) {
+                std::cerr << filename << ":" << lineno << ": expected <kind> <name> [options]" << std::endl;
+                return false;
+            }
+            auto& entry = entries[kind + " " + name];
+            while (tokens >> option) {
+                size_t eq = option.find('=');
+                entry[option.substr(0, eq)] = (eq == std::string::npos) ? "" : option.substr(eq + 1);
+            }
+        }
+        return true;
+    };
+
+    /**
+   * check whether an option is set for an element
+   */
+    bool has(
+        const std::string& kind,
+        const std::string& name,
+        const std::string& key) const
+    {
+        const auto* entry = find(kind, name);
+        return entry && entry->count(key);
+    };
+
+    /**
+   * get value of an option for an element, default if not set
+   */
+    std::string get(
+        const std::string& kind,
+        const std::string& name,
+        const std::string& key,
+        const std::string& def = "") const
+    {
+        const auto* entry = find(kind, name);
+        if (!entry || !entry->count(key)) {
+            return def;
+        }
+        return entry->at(key);
+    };
+
+    /**
+   * elements with options that were never looked up, e.g. misspelled names
+   */
+    std::vector<std::string> unused() const
+    {
+        std::vector<std::string> names;
+        for (const auto& it : entries) {
+            if (!used.count(it.first)) {
+                names.push_back(it.first);
+            }
+        }
+        return names;
+    };
+
+private:
+    const std::map<std::string, std::string>* find(
+        const std::string& kind,
+        const std::string& name) const
+    {
+        auto it = entries.find(kind + " " + name);
+        if (it == entries.end()) {
+            return nullptr;
+        }
+        used.insert(it->first);
+        return &it->second;
+    };
+
+    // options by "<kind> <full name>"
+    std::map<std::string, std::map<std::string, std::string>> entries;
+    // entries looked up
+    mutable std::set<std::string> used;
+};
+
+/**
+ * CamelCase to snake_case, digits do not start a new word
+ */
+std::string snake(
+    const std::string& s)
+{
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (isupper(s[i]) && i > 0 && (islower(s[i - 1]) || isdigit(s[i - 1]))) {
+            out += '_';
+        }
+        out += tolower(s[i]);
+    }
+    return out;
+}
+
+std::string upper(
+    std::string s)
+{
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return toupper(c); });
+    return s;
+}
+
+/**
+ * member of a C struct: a field or a oneof with discriminator and union
+ */
+struct Member {
+    const FieldDescriptor* field = nullptr;
+    const OneofDescriptor* oneof = nullptr;
+};
+
+class Generator {
+public:
+    Generator(
+        const FileDescriptor* file,
+        const Options& options)
+        : file(file)
+        , options(options)
+    {
+        for (int i = 0; i < file->enum_type_count(); i++) {
+            enums.push_back(file->enum_type(i));
+        }
+        for (int i = 0; i < file->message_type_count(); i++) {
+            collect(file->message_type(i));
+        }
+        for (int i = 0; i < file->message_type_count(); i++) {
+            order(file->message_type(i));
+        }
+    };
+
+    /**
+   * C enums and structs, included by upsf.h
+   */
+    std::string types_h()
+    {
+        std::ostringstream os;
+        os << banner("upsf_c_types.h");
+        os << "#ifndef UPSF_C_TYPES_H\n"
+           << "#define UPSF_C_TYPES_H\n\n";
+
+        for (const auto* e : enums) {
+            os << "/* enum: " << e->full_name() << " */\n";
+            os << "enum " << enum_cname(e) << " {\n";
+            for (int i = 0; i < e->value_count(); i++) {
+                std::string value = e->full_name() + "." + e->value(i)->name();
+                if (options.has("value", value, "skip")) {
+                    continue;
+                }
+                os << "    " << enum_prefix(e) << options.get("value", value, "cname", upper(e->value(i)->name()))
+                   << " = " << e->value(i)->number() << ",\n";
+            }
+            os << "    " << enum_prefix(e) << "MAX,\n";
+            os << "};\n\n";
+        }
+
+        for (const auto* d : messages) {
+            for (const auto& m : members(d, true)) {
+                if (!m.oneof) {
+                    continue;
+                }
+                os << "/* oneof: " << m.oneof->full_name() << " */\n";
+                os << "enum " << oneof_cname(m.oneof) << " {\n";
+                int value = 0;
+                if (oneof_unspecified(m.oneof)) {
+                    os << "    " << oneof_prefix(m.oneof) << "UNSPECIFIED = " << value++ << ",\n";
+                }
+                for (int i = 0; i < m.oneof->field_count(); i++) {
+                    os << "    " << oneof_value(m.oneof->field(i)) << " = " << value++ << ",\n";
+                }
+                os << "    " << oneof_prefix(m.oneof) << "MAX,\n";
+                os << "};\n\n";
+            }
+        }
+
+        for (const auto* d : messages) {
+            os << "/* message: " << d->full_name() << " */\n";
+            os << "typedef struct {\n";
+            for (const auto& m : members(d, true)) {
+                if (m.oneof) {
+                    os << "    enum " << oneof_cname(m.oneof) << " " << oneof_type(m.oneof) << ";\n";
+                    os << "    union " << oneof_union(m.oneof) << "_u {\n";
+                    for (int i = 0; i < m.oneof->field_count(); i++) {
+                        os << "        " << ctype(m.oneof->field(i)) << " " << cname(m.oneof->field(i)) << ";\n";
+                    }
+                    os << "    } " << oneof_union(m.oneof) << ";\n";
+                } else if (m.field->is_repeated()) {
+                    os << "    " << ctype(m.field) << " " << cname(m.field) << "[" << capacity(m.field) << "];\n";
+                    os << "    size_t " << cname(m.field) << "_size;\n";
+                } else {
+                    os << "    " << ctype(m.field) << " " << cname(m.field) << ";\n";
+                }
+            }
+            os << "} " << cname(d) << ";\n\n";
+        }
+
+        os << "#endif\n";
+        return os.str();
+    };
+
+    /**
+   * UpsfMapping::map() declarations, included by the class definition
+   */
+    std::string mapping_inc()
+    {
+        std::ostringstream os;
+        os << banner("upsf_c_mapping.inc");
+        for (const auto* d : messages) {
+            os << "    /* " << d->full_name() << " */\n";
+            os << "    static bool map(\n"
+               << "        const " << cpp(d) << "& from,\n"
+               << "        " << cname(d) << "& to,\n"
+               << "        bool reset = true);\n\n";
+            os << "    static bool map(\n"
+               << "        const " << cname(d) << "& from,\n"
+               << "        " << cpp(d) << "& to);\n\n";
+        }
+        return os.str();
+    };
+
+    /**
+   * UpsfMapping::map() definitions
+   */
+    std::string mapping_cpp()
+    {
+        std::ostringstream os;
+        os << banner("upsf_c_mapping_gen.cpp");
+        os << "#include \"upsf_c_mapping.hpp\"\n"
+           << "#include \"upsf_stream.hpp\"\n\n"
+           << "#include <algorithm>\n"
+           << "#include <cstring>\n\n"
+           << "using namespace upsf;\n\n"
+           << "/**\n"
+           << " * clear array entries left over from a previous mapping with more entries\n"
+           << " */\n"
+           << "template <typename T, size_t N>\n"
+           << "static void reset_tail(\n"
+           << "    T (&entries)[N],\n"
+           << "    size_t size,\n"
+           << "    size_t prev_size)\n"
+           << "{\n"
+           << "    prev_size = (prev_size < N) ? prev_size : N;\n"
+           << "    if (prev_size > size) {\n"
+           << "        memset(&entries[size], 0, (prev_size - size) * sizeof(T));\n"
+           << "    }\n"
+           << "}\n\n"
+           << "/* bool map values */\n"
+           << "static const std::string value_true(\"1\");\n"
+           << "static const std::string value_false(\"0\");\n\n";
+        for (const auto* d : messages) {
+            to_c(os, d);
+            to_proto(os, d);
+        }
+        return os.str();
+    };
+
+    /**
+   * stream formatters, included by upsf_stream.hpp
+   */
+    std::string stream_hpp()
+    {
+        std::ostringstream os;
+        os << banner("upsf_stream_gen.hpp");
+        os << "#ifndef UPSF_STREAM_GEN_HPP\n"
+           << "#define UPSF_STREAM_GEN_HPP\n\n"
+           << "namespace upsf {\n\n";
+        for (const auto* d : messages) {
+            if (!options.has("message", d->full_name(), "stream")) {
+                stream(os, d);
+            }
+        }
+        os << "}; // end namespace upsf\n\n"
+           << "#endif\n";
+        return os.str();
+    };
+
+    /**
+   * errors found while generating
+   */
+    const std::vector<std::string>& errors() const
+    {
+        return errs;
+    };
+
+private:
+    std::string banner(
+        const std::string& name) const
+    {
+        return "/* " + name + "\n"
+            " *\n"
+            " * generated by upsf_gen from\n"
+            " *   " + file->name() + "\n"
+            " *   upsf_c.options\n"
+            " * do not edit\n"
+            " */\n\n";
+    };
+
+    /**
+   * enums nested in a message, in declaration order
+   */
+    void collect(
+        const Descriptor* d)
+    {
+        for (int i = 0; i < d->enum_type_count(); i++) {
+            enums.push_back(d->enum_type(i));
+        }
+        for (int i = 0; i < d->nested_type_count(); i++) {
+            collect(d->nested_type(i));
+        }
+    };
+
+    /**
+   * messages with the ones they contain first, map entries and skipped
+   * messages excluded
+   */
+    void order(
+        const Descriptor* d)
+    {
+        if (visited.count(d) || d->options().map_entry()) {
+            return;
+        }
+        visited.insert(d);
+        if (!options.has("message", d->full_name(), "skip")) {
+            for (int i = 0; i < d->field_count(); i++) {
+                if (d->field(i)->message_type()) {
+                    order(d->field(i)->message_type());
+                }
+            }
+            messages.push_back(d);
+        }
+        if (d->file() == file) {
+            for (int i = 0; i < d->nested_type_count(); i++) {
+                order(d->nested_type(i));
+            }
+        }
+    };
+
+    /**
+   * members of a message in field order, a oneof at the position of its
+   * first field, moved by option after= for the C struct
+   */
+    std::vector<Member> members(
+        const Descriptor* d,
+        bool c_order)
+    {
+        std::vector<Member> result;
+        for (int i = 0; i < d->field_count(); i++) {
+            const FieldDescriptor* field = d->field(i);
+            const OneofDescriptor* oneof = field->containing_oneof();
+            if (oneof && oneof->field(0) == field) {
+                result.push_back(Member { nullptr, oneof });
+            } else if (!oneof) {
+                result.push_back(Member { field, nullptr });
+            }
+        }
+        if (!c_order) {
+            return result;
+        }
+        for (int i = 0; i < d->field_count(); i++) {
+            const FieldDescriptor* field = d->field(i);
+            std::string after = options.get("field", field->full_name(), "after");
+            if (after.empty()) {
+                continue;
+            }
+            auto it = std::find_if(result.begin(), result.end(), [field](const Member& m) { return m.field == field; });
+            Member moved = *it;
+            result.erase(it);
+            auto pos = std::find_if(result.begin(), result.end(), [&after](const Member& m) { return m.field && m.field->name() == after; });
+            if (pos == result.end()) {
+                errs.push_back(field->full_name() + ": after=" + after + " names no field");
+                pos = result.end();
+            } else {
+                pos++;
+            }
+            result.insert(pos, moved);
+        }
+        return result;
+    };
+
+    /*
+     * names
+     */
+
+    /* message path without package, e.g. NetworkConnection.Spec.Endpoint */
+    std::vector<std::string> path(
+        const Descriptor* d) const
+    {
+        std::vector<std::string> parts;
+        for (; d; d = d->containing_type()) {
+            parts.insert(parts.begin(), d->name());
+        }
+        return parts;
+    };
+
+    std::string cname(
+        const Descriptor* d) const
+    {
+        std::string name = "upsf";
+        for (const auto& part : path(d)) {
+            name += "_" + snake(part);
+        }
+        return options.get("message", d->full_name(), "cname", name + "_t");
+    };
+
+    std::string cname(
+        const FieldDescriptor* field) const
+    {
+        return options.get("field", field->full_name(), "cname", field->name());
+    };
+
+    std::string cpp(
+        const Descriptor* d) const
+    {
+        std::string name = d->full_name();
+        for (size_t pos = 0; (pos = name.find('.', pos)) != std::string::npos;) {
+            name.replace(pos, 1, "::");
+        }
+        return name;
+    };
+
+    std::string cpp(
+        const EnumDescriptor* e) const
+    {
+        std::string name = e->full_name();
+        for (size_t pos = 0; (pos = name.find('.', pos)) != std::string::npos;) {
+            name.replace(pos, 1, "::");
+        }
+        return name;
+    };
+
+    std::string stream_name(
+        const Descriptor* d) const
+    {
+        std::string name;
+        for (const auto& part : path(d)) {
+            name += part;
+        }
+        return options.get("message", d->full_name(), "stream", name + "Stream");
+    };
+
+    /* comment prefix of a message, e.g. network_connection: spec: endpoint */
+    std::string comment(
+        const Descriptor* d) const
+    {
+        std::string name;
+        for (const auto& part : path(d)) {
+            name += (name.empty() ? "" : ": ") + snake(part);
+        }
+        return name;
+    };
+
+    std::string label(
+        const FieldDescriptor* field) const
+    {
+        return options.get("field", field->full_name(), "label", field->name());
+    };
+
+    std::string enum_cname(
+        const EnumDescriptor* e) const
+    {
+        return options.get("enum", e->full_name(), "cname", "upsf_" + snake(e->name()) + "_t");
+    };
+
+    /* e.g. UPSF_DERIVED_STATE_ for upsf_derived_state_t */
+    std::string enum_prefix(
+        const EnumDescriptor* e) const
+    {
+        std::string name = enum_cname(e);
+        return upper(name.substr(0, name.size() - 2)) + "_";
+    };
+
+    /* e.g. upsf_derived_state_to_name for upsf_derived_state_t */
+    std::string enum_to_name(
+        const EnumDescriptor* e) const
+    {
+        std::string name = enum_cname(e);
+        return name.substr(0, name.size() - 2) + "_to_name";
+    };
+
+    std::string oneof_type(
+        const OneofDescriptor* oneof)
+    {
+        std::string type = options.get("oneof", oneof->full_name(), "type");
+        if (type.empty()) {
+            errs.push_back(oneof->full_name() + ": oneof needs type=");
+        }
+        return type;
+    };
+
+    std::string oneof_union(
+        const OneofDescriptor* oneof)
+    {
+        std::string name = options.get("oneof", oneof->full_name(), "union");
+        if (name.empty()) {
+            errs.push_back(oneof->full_name() + ": oneof needs union=");
+        }
+        return name;
+    };
+
+    bool oneof_unspecified(
+        const OneofDescriptor* oneof) const
+    {
+        return options.has("oneof", oneof->full_name(), "unspecified");
+    };
+
+    std::string oneof_cname(
+        const OneofDescriptor* oneof)
+    {
+        return "upsf_" + oneof_type(oneof) + "_t";
+    };
+
+    std::string oneof_prefix(
+        const OneofDescriptor* oneof)
+    {
+        return "UPSF_" + upper(oneof_type(oneof)) + "_";
+    };
+
+    std::string oneof_value(
+        const FieldDescriptor* field)
+    {
+        return oneof_prefix(field->containing_oneof()) + upper(cname(field));
+    };
+
+    std::string capacity(
+        const FieldDescriptor* field)
+    {
+        std::string name = options.get("field", field->full_name(), "capacity");
+        if (name.empty()) {
+            errs.push_back(field->full_name() + ": repeated field needs capacity=");
+        }
+        return name;
+    };
+
+    /* C type of a field or of an entry of a repeated field */
+    std::string ctype(
+        const FieldDescriptor* field)
+    {
+        std::string type = options.get("field", field->full_name(), "ctype");
+        if (!type.empty()) {
+            return type;
+        }
+        if (field->is_map()) {
+            const FieldDescriptor* key = field->message_type()->map_key();
+            const FieldDescriptor* value = field->message_type()->map_value();
+            if (key->type() != FieldDescriptor::TYPE_STRING || (value->type() != FieldDescriptor::TYPE_STRING && value->type() != FieldDescriptor::TYPE_BOOL)) {
+                errs.push_back(field->full_name() + ": only maps from string to string or bool are supported");
+            }
+            return "upsf_key_value_t";
+        }
+        switch (field->type()) {
+        case FieldDescriptor::TYPE_STRING:
+            return "upsf_string_t";
+        case FieldDescriptor::TYPE_MESSAGE:
+            return cname(field->message_type());
+        case FieldDescriptor::TYPE_ENUM:
+            return "enum " + enum_cname(field->enum_type());
+        case FieldDescriptor::TYPE_INT32:
+        case FieldDescriptor::TYPE_SINT32:
+        case FieldDescriptor::TYPE_SFIXED32:
+        case FieldDescriptor::TYPE_BOOL:
+            return "int";
+        case FieldDescriptor::TYPE_INT64:
+        case FieldDescriptor::TYPE_SINT64:
+        case FieldDescriptor::TYPE_SFIXED64:
+            return "int64_t";
+        case FieldDescriptor::TYPE_UINT32:
+        case FieldDescriptor::TYPE_FIXED32:
+            return "uint32_t";
+        case FieldDescriptor::TYPE_UINT64:
+        case FieldDescriptor::TYPE_FIXED64:
+            return "uint64_t";
+        case FieldDescriptor::TYPE_DOUBLE:
+            return "double";
+        case FieldDescriptor::TYPE_FLOAT:
+            return "float";
+        default:
+            errs.push_back(field->full_name() + ": unsupported type " + field->type_name());
+            return "void";
+        }
+    };
+
+    /*
+     * mapping
+     */
+
+    /* statement mapping a single value from protobuf into C */
+    std::string value_to_c(
+        const FieldDescriptor* field,
+        const std::string& from,
+        const std::string& to) const
+    {
+        switch (field->type()) {
+        case FieldDescriptor::TYPE_STRING:
+            return "UpsfMapping::map(" + from + ", " + to + ");";
+        case FieldDescriptor::TYPE_MESSAGE:
+            return "UpsfMapping::map(" + from + ", " + to + ", false);";
+        case FieldDescriptor::TYPE_ENUM:
+            return to + " = (" + enum_cname(field->enum_type()) + ")" + from + ";";
+        default:
+            return to + " = " + from + ";";
+        }
+    };
+
+    /* statement mapping a single value from C into protobuf */
+    std::string value_to_proto(
+        const FieldDescriptor* field,
+        const std::string& from,
+        const std::string& to) const
+    {
+        std::string accessor = field->is_repeated() ? "add_" : "set_";
+        switch (field->type()) {
+        case FieldDescriptor::TYPE_STRING:
+        case FieldDescriptor::TYPE_MESSAGE:
+            accessor = field->is_repeated() ? "add_" : "mutable_";
+            return "UpsfMapping::map(" + from + ", *" + to + "." + accessor + field->name() + "());";
+        case FieldDescriptor::TYPE_ENUM:
+            return to + "." + accessor + field->name() + "(" + cpp(field->enum_type()) + "(" + from + "));";
+        default:
+            return to + "." + accessor + field->name() + "(" + from + ");";
+        }
+    };
+
+    void to_c(
+        std::ostream& os,
+        const Descriptor* d)
+    {
+        std::string path = comment(d);
+        std::vector<Member> ms = members(d, true);
+        bool checked = std::any_of(ms.begin(), ms.end(), [this](const Member& m) { return m.oneof && oneof_unspecified(m.oneof); });
+
+        os << "bool UpsfMapping::map(\n"
+           << "    const " << cpp(d) << "& from,\n"
+           << "    " << cname(d) << "& to,\n"
+           << "    bool reset)\n"
+           << "{\n";
+        os << "    /* " << path << ": init */\n"
+           << "    if (reset) {\n"
+           << "        memset(&to, 0, sizeof(to));\n"
+           << "    }\n";
+        if (checked) {
+            os << "    bool success = true;\n";
+        }
+
+        for (const auto& m : ms) {
+            if (m.oneof) {
+                std::string type = oneof_type(m.oneof);
+                std::string name = oneof_union(m.oneof);
+                os << "\n    /* " << path << ": " << m.oneof->name() << ", cleared if left over from a different type */\n";
+                os << "    " << oneof_cname(m.oneof) << " " << type << " = ";
+                for (int i = 0; i < m.oneof->field_count(); i++) {
+                    os << "from.has_" << m.oneof->field(i)->name() << "() ? " << oneof_value(m.oneof->field(i)) << "\n        : ";
+                }
+                os << oneof_prefix(m.oneof) << (oneof_unspecified(m.oneof) ? "UNSPECIFIED" : upper(cname(m.oneof->field(0)))) << ";\n";
+                os << "    if (!reset && ((" << type << " != to." << type << ") || (from." << m.oneof->name() << "_case() == " << cpp(d) << "::" << upper(m.oneof->name()) << "_NOT_SET))) {\n"
+                   << "        memset(&to." << name << ", 0, sizeof(to." << name << "));\n"
+                   << "    }\n"
+                   << "    to." << type << " = " << type << ";\n";
+                for (int i = 0; i < m.oneof->field_count(); i++) {
+                    const FieldDescriptor* field = m.oneof->field(i);
+                    os << "    " << (i ? "} else if" : "if") << " (from.has_" << field->name() << "()) {\n"
+                       << "        /* " << path << ": " << field->name() << " */\n"
+                       << "        " << value_to_c(field, "from." + field->name() + "()", "to." + name + "." + cname(field)) << "\n";
+                }
+                if (oneof_unspecified(m.oneof)) {
+                    os << "    } else {\n"
+                       << "        /* " << path << ": " << m.oneof->name() << " unspecified */\n"
+                       << "        success = false;\n";
+                }
+                os << "    }\n";
+                continue;
+            }
+
+            const FieldDescriptor* field = m.field;
+            std::string f = field->name();
+            std::string c = cname(field);
+            os << "\n    /* " << path << ": " << f << " */\n";
+            if (field->is_map()) {
+                const FieldDescriptor* value = field->message_type()->map_value();
+                std::string cap = capacity(field);
+                os << "    size_t prev_" << c << "_size = to." << c << "_size;\n"
+                   << "    to." << c << "_size = 0;\n"
+                   << "    for (const auto& it : from." << f << "()) {\n"
+                   << "        if (to." << c << "_size == " << cap << ") {\n"
+                   << "            break;\n"
+                   << "        }\n"
+                   << "        UpsfMapping::map(it.first, to." << c << "[to." << c << "_size].key);\n";
+                if (value->type() == FieldDescriptor::TYPE_BOOL) {
+                    os << "        UpsfMapping::map(it.second ? value_true : value_false, to." << c << "[to." << c << "_size].value);\n";
+                } else {
+                    os << "        UpsfMapping::map(it.second, to." << c << "[to." << c << "_size].value);\n";
+                }
+                os << "        to." << c << "_size++;\n"
+                   << "    }\n"
+                   << "    reset_tail(to." << c << ", to." << c << "_size, prev_" << c << "_size);\n";
+                warning(os, d, field, cap);
+            } else if (field->is_repeated()) {
+                std::string cap = capacity(field);
+                os << "    size_t prev_" << c << "_size = to." << c << "_size;\n"
+                   << "    to." << c << "_size = std::min<size_t>(from." << f << "_size(), " << cap << ");\n"
+                   << "    for (size_t i = 0; i < to." << c << "_size; i++) {\n"
+                   << "        " << value_to_c(field, "from." + f + "(i)", "to." + c + "[i]") << "\n"
+                   << "    }\n"
+                   << "    reset_tail(to." << c << ", to." << c << "_size, prev_" << c << "_size);\n";
+                warning(os, d, field, cap);
+            } else {
+                os << "    " << value_to_c(field, "from." + f + "()", "to." + c) << "\n";
+            }
+        }
+
+        os << "\n    return " << (checked ? "success" : "true") << ";\n"
+           << "}\n\n";
+    };
+
+    /* warning for entries exceeding the capacity of a C array */
+    void warning(
+        std::ostream& os,
+        const Descriptor* d,
+        const FieldDescriptor* field,
+        const std::string& cap)
+    {
+        os << "    if (to." << cname(field) << "_size < size_t(from." << field->name() << "_size())) {\n"
+           << "        LOG(WARNING) << \"libupsf: \" << __PRETTY_FUNCTION__ << \" too many entries for " << field->name()
+           << ", max number supported=\" << " << cap << " << \", from: \" << upsf::" << stream_name(d) << "(from) << std::endl;\n"
+           << "    }\n";
+    };
+
+    void to_proto(
+        std::ostream& os,
+        const Descriptor* d)
+    {
+        std::string path = comment(d);
+        std::vector<Member> ms = members(d, true);
+        bool checked = std::any_of(ms.begin(), ms.end(), [](const Member& m) { return m.oneof; });
+
+        os << "bool UpsfMapping::map(\n"
+           << "    const " << cname(d) << "& from,\n"
+           << "    " << cpp(d) << "& to)\n"
+           << "{\n";
+        if (checked) {
+            os << "    bool success = true;\n\n";
+        }
+
+        bool first = true;
+        for (const auto& m : ms) {
+            os << (first ? "" : "\n");
+            first = false;
+
+            if (m.oneof) {
+                std::string type = oneof_type(m.oneof);
+                std::string name = oneof_union(m.oneof);
+                os << "    /* " << path << ": " << m.oneof->name() << " */\n"
+                   << "    switch (from." << type << ") {\n";
+                for (int i = 0; i < m.oneof->field_count(); i++) {
+                    const FieldDescriptor* field = m.oneof->field(i);
+                    os << "    case " << oneof_value(field) << ":\n"
+                       << "        " << value_to_proto(field, "from." + name + "." + cname(field), "to") << "\n"
+                       << "        break;\n";
+                }
+                os << "    default:\n"
+                   << "        /* " << path << ": " << m.oneof->name() << " unspecified */\n"
+                   << "        success = false;\n"
+                   << "        break;\n"
+                   << "    }\n";
+                continue;
+            }
+
+            const FieldDescriptor* field = m.field;
+            std::string f = field->name();
+            std::string c = cname(field);
+            os << "    /* " << path << ": " << f << " */\n";
+            if (field->is_map()) {
+                const FieldDescriptor* value = field->message_type()->map_value();
+                os << "    for (size_t i = 0; i < std::min<size_t>(from." << c << "_size, " << capacity(field) << "); i++) {\n"
+                   << "        std::string key;\n"
+                   << "        UpsfMapping::map(from." << c << "[i].key, key);\n";
+                if (value->type() == FieldDescriptor::TYPE_BOOL) {
+                    os << "        (*to.mutable_" << f << "())[key] = (from." << c << "[i].value.str[0] == '1');\n";
+                } else {
+                    os << "        UpsfMapping::map(from." << c << "[i].value, (*to.mutable_" << f << "())[key]);\n";
+                }
+                os << "    }\n";
+            } else if (field->is_repeated()) {
+                os << "    for (size_t i = 0; i < std::min<size_t>(from." << c << "_size, " << capacity(field) << "); i++) {\n"
+                   << "        " << value_to_proto(field, "from." + c + "[i]", "to") << "\n"
+                   << "    }\n";
+            } else if (field->message_type() && options.has("message", field->message_type()->full_name(), "omit_unset")) {
+                const Descriptor* type = field->message_type();
+                os << "    if (";
+                for (int i = 0; i < type->field_count(); i++) {
+                    os << (i ? " || " : "") << "from." << c << "." << cname(type->field(i));
+                }
+                os << ") {\n"
+                   << "        " << value_to_proto(field, "from." + c, "to") << "\n"
+                   << "    }\n";
+            } else {
+                os << "    " << value_to_proto(field, "from." + c, "to") << "\n";
+            }
+        }
+
+        os << "\n    return " << (checked ? "success" : "true") << ";\n"
+           << "}\n\n";
+    };
+
+    /*
+     * formatters
+     */
+
+    /* expression formatting a single value */
+    std::string value_stream(
+        const FieldDescriptor* field,
+        const std::string& value) const
+    {
+        switch (field->type()) {
+        case FieldDescriptor::TYPE_MESSAGE:
+            return stream_name(field->message_type()) + "(" + value + ")";
+        case FieldDescriptor::TYPE_ENUM:
+            return enum_to_name(field->enum_type()) + "(" + value + ")";
+        default:
+            return value;
+        }
+    };
+
+    void stream(
+        std::ostream& os,
+        const Descriptor* d)
+    {
+        std::string path = comment(d);
+        std::string cls = stream_name(d);
+        std::string var = snake(d->name());
+        std::string msg = "s." + var + ".";
+
+        os << "class " << cls << " {\n"
+           << "    const " << cpp(d) << "& " << var << ";\n\n"
+           << "public:\n"
+           << "    " << cls << "(\n"
+           << "        const " << cpp(d) << "& " << var << ")\n"
+           << "        : " << var << "(" << var << ") {};\n\n"
+           << "    friend std::ostream& operator<<(\n"
+           << "        std::ostream& os, const " << cls << "& s)\n"
+           << "    {\n"
+           << "        os << \"" << d->name() << "(\";\n";
+
+        std::vector<Member> ms = members(d, false);
+        for (size_t n = 0; n < ms.size(); n++) {
+            const auto& m = ms[n];
+            std::string sep = (n + 1 < ms.size()) ? " << \", \"" : "";
+
+            if (m.oneof) {
+                os << "\n        /* " << path << ": " << m.oneof->name() << " */\n";
+                for (int i = 0; i < m.oneof->field_count(); i++) {
+                    const FieldDescriptor* field = m.oneof->field(i);
+                    os << "        " << (i ? "} else if" : "if") << " (" << msg << "has_" << field->name() << "()) {\n"
+                       << "            os << \"" << label(field) << "=\" << " << value_stream(field, msg + field->name() + "()") << ";\n";
+                }
+                os << "        } else {\n"
+                   << "            os << \"" << m.oneof->name() << "=unset\";\n"
+                   << "        }\n";
+                if (!sep.empty()) {
+                    os << "        os" << sep << ";\n";
+                }
+                continue;
+            }
+
+            const FieldDescriptor* field = m.field;
+            std::string f = field->name();
+            os << "\n        /* " << path << ": " << f << " */\n";
+            if (field->is_map()) {
+                os << "        os << \"" << label(field) << "=(\";\n"
+                   << "        for (const auto& it : " << msg << f << "()) {\n"
+                   << "            os << it.first << \":\" << it.second << \", \";\n"
+                   << "        }\n"
+                   << "        os << \")\"" << sep << ";\n";
+            } else if (field->is_repeated()) {
+                os << "        os << \"" << label(field) << "=(\";\n"
+                   << "        for (int i = 0; i < " << msg << f << "_size(); i++) {\n"
+                   << "            os << \"[\" << i << \"]\" << " << value_stream(field, msg + f + "(i)") << " << \", \";\n"
+                   << "        }\n"
+                   << "        os << \")\"" << sep << ";\n";
+            } else {
+                os << "        os << \"" << label(field) << "=\" << " << value_stream(field, msg + f + "()") << sep << ";\n";
+            }
+        }
+
+        os << "\n        os << \")\"; // " << d->name() << "\n\n"
+           << "        return os;\n"
+           << "    };\n"
+           << "};\n\n";
+    };
+
+    // file to generate code for
+    const FileDescriptor* file;
+    // C options
+    const Options& options;
+    // messages in dependency order
+    std::vector<const Descriptor*> messages;
+    // messages ordered already
+    std::set<const Descriptor*> visited;
+    // enums in declaration order
+    std::vector<const EnumDescriptor*> enums;
+    // errors found
+    std::vector<std::string> errs;
+};
+
+/**
+ * write file unless unchanged, so dependent sources are not rebuilt
+ */
+bool write(
+    const std::string& filename,
+    const std::string& content)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (in) {
+        std::ostringstream current;
+        current << in.rdbuf();
+        if (current.str() == content) {
+            return true;
+        }
+    }
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out << content;
+    if (!out) {
+        std::cerr << "upsf_gen: unable to write " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}; // end anonymous namespace
+
+int main(int argc, char** argv)
+{
+    if (argc != 4) {
+        std::cerr << "usage: " << argv[0] << " <descriptor set> <options> <output directory>" << std::endl;
+        return 1;
+    }
+
+    FileDescriptorSet set;
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!set.ParseFromIstream(&in) || set.file_size() == 0) {
+        std::cerr << "upsf_gen: unable to read descriptor set " << argv[1] << std::endl;
+        return 1;
+    }
+    DescriptorPool pool;
+    const FileDescriptor* file = nullptr;
+    for (const auto& proto : set.file()) {
+        if (!(file = pool.BuildFile(proto))) {
+            std::cerr << "upsf_gen: invalid descriptor " << proto.name() << std::endl;
+            return 1;
+        }
+    }
+
+    Options options;
+    if (!options.load(argv[2])) {
+        return 1;
+    }
+
+    Generator generator(file, options);
+    std::string dir(argv[3]);
+    std::string types_h = generator.types_h();
+    std::string mapping_inc = generator.mapping_inc();
+    std::string mapping_cpp = generator.mapping_cpp();
+    std::string stream_hpp = generator.stream_hpp();
+
+    std::vector<std::string> errors = generator.errors();
+    for (const auto& name : options.unused()) {
+        errors.push_back(name + ": no such element");
+    }
+    if (!errors.empty()) {
+        for (const auto& error : errors) {
+            std::cerr << argv[2] << ": " << error << std::endl;
+        }
+        return 1;
+    }
+
+    return (write(dir + "/upsf_c_types.h", types_h)
+               && write(dir + "/upsf_c_mapping.inc", mapping_inc)
+               && write(dir + "/upsf_c_mapping_gen.cpp", mapping_cpp)
+               && write(dir + "/upsf_stream_gen.hpp", stream_hpp))
+        ? 0
+        : 1;
+}
@@ -0,0 +1,479 @@
+/* upsf_proxy
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "upsf_proxy.hpp"
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <sstream>
+#include <string>
+
+DEFINE_string(upsfhost, "localhost", "upstream UPSF host");
+DEFINE_int32(upsfport, 50051, "upstream UPSF port");
+DEFINE_string(listenhost, "localhost", "proxy listening address");
+DEFINE_int32(listenport, 50052, "proxy listening port");
+DEFINE_int32(maxwatchqueue, 65536, "max. items queued for a downstream watch");
+DEFINE_int32(lookupttl, 30000, "lifetime of cached lookup results in ms");
+DEFINE_int32(lookupnegativettl, 1000, "lifetime of cached not found lookup results in ms");
+DEFINE_int32(upstreamtimeout, 5000, "deadline of upstream calls shared by several downstream callers in ms");
+
+/*
+ * Check whether an item passes the filters of a read request,
+ * parent filters are not evaluated, empty filters match all
+ */
+static bool matches(
+    const wt474_upsf_service::v1::ReadReq& req,
+    const wt474_messages::v1::Item& item)
+{
+    wt474_upsf_service::v1::ItemType itemtype;
+    if (!upsf::item_type(item, itemtype)) {
+        return false;
+    }
+    if (req.itemtype_size() > 0 && std::find(req.itemtype().begin(), req.itemtype().end(), itemtype) == req.itemtype().end()) {
+        return false;
+    }
+    if (req.itemstate_size() > 0 && std::find(req.itemstate().begin(), req.itemstate().end(), upsf::item_metadata(item).derived_state()) == req.itemstate().end()) {
+        return false;
+    }
+    if (req.name_size() > 0 && std::none_of(req.name().begin(), req.name().end(), [&item](const google::protobuf::StringValue& name) { return name.value() == upsf::item_name(item); })) {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * UpsfProxyWatch
+ */
+UpsfProxyWatch::UpsfProxyWatch(
+    const wt474_upsf_service::v1::ReadReq& req)
+    : upsf::UpsfSubscriber(
+        std::vector<wt474_upsf_service::v1::ItemType>(),
+        std::vector<wt474_messages::v1::DerivedState>(),
+        std::vector<std::string>(),
+        std::vector<std::string>(),
+        /*watch=*/true)
+    , overflow(false)
+{
+    /* same filters as the downstream request, empty filters match all */
+    for (auto itemtype : req.itemtype()) {
+        itemtypes.push_back(wt474_upsf_service::v1::ItemType(itemtype));
+    }
+    for (auto itemstate : req.itemstate()) {
+        derivedstates.push_back(wt474_messages::v1::DerivedState(itemstate));
+    }
+    for (const auto& name : req.name()) {
+        names.push_back(name.value());
+    }
+}
+
+void UpsfProxyWatch::notify(
+    const std::shared_ptr<const wt474_messages::v1::Item>& item)
+{
+    std::scoped_lock lock(mutex);
+    if (overflow) {
+        return;
+    }
+    if (queue.size() >= size_t(FLAGS_maxwatchqueue)) {
+        overflow = true;
+        queue.clear();
+    } else {
+        queue.push_back(item);
+    }
+    cond.notify_one();
+}
+
+bool UpsfProxyWatch::next(
+    grpc::ServerContext* context,
+    const std::atomic<bool>& stopping,
+    std::shared_ptr<const wt474_messages::v1::Item>& item)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (queue.empty() && !overflow) {
+        /* poll for cancellation of the downstream context */
+        if (stopping || context->IsCancelled()) {
+            return false;
+        }
+        cond.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    if (overflow) {
+        return false;
+    }
+    item = std::move(queue.front());
+    queue.pop_front();
+    return true;
+}
+
+bool UpsfProxyWatch::overflowed() const
+{
+    std::scoped_lock lock(mutex);
+    return overflow;
+}
+
+/*
+ * UpsfProxy
+ */
+UpsfProxy::UpsfProxy(
+    std::shared_ptr<grpc::Channel> channel)
+    : channel(channel)
+    , stub(wt474_upsf_service::v1::upsf::NewStub(channel))
+    , client(channel)
+    , hub(channel,
+          upsf::UpsfSubscriber().itemtypes,
+          { wt474_messages::v1::DerivedState::unknown,
+              wt474_messages::v1::DerivedState::inactive,
+              wt474_messages::v1::DerivedState::active,
+              wt474_messages::v1::DerivedState::updating,
+              wt474_messages::v1::DerivedState::deleting,
+              wt474_messages::v1::DerivedState::deleted })
+    , lookup_cache(std::chrono::milliseconds(FLAGS_lookupttl), std::chrono::milliseconds(FLAGS_lookupnegativettl))
+    , ready(false)
+    , stopping(false)
+    , reads_cached(0)
+    , reads_forwarded(0)
+{
+    hub.attach(cache);
+    hub.attach(lookup_cache);
+    /* lookup results are cached only while the watch stream is established */
+    hub.set_callbacks(
+        [this]() { lookup_cache.set_enabled(true); },
+        [this]() { lookup_cache.set_enabled(false); });
+}
+
+UpsfProxy::~UpsfProxy()
+{
+    stop();
+}
+
+void UpsfProxy::start()
+{
+    upstream = std::thread(&UpsfProxy::run_upstream, this);
+}
+
+void UpsfProxy::stop()
+{
+    if (stopping.exchange(true)) {
+        return;
+    }
+    hub.stop();
+    if (upstream.joinable()) {
+        upstream.join();
+    }
+
+    LOG(INFO) << "upsf_proxy: reads cached=" << reads_cached << " forwarded=" << reads_forwarded
+              << " coalesced=" << reads.get_coalesced() << " lookups cached=" << lookup_cache.get_hits()
+              << " coalesced=" << lookups.get_coalesced() << std::endl;
+}
+
+/*
+ * Serve the upstream watch stream, the cache is reconciled with a full read
+ * on each (re)connect and used for reads once reconciled
+ */
+void UpsfProxy::run_upstream()
+{
+    while (!stopping) {
+        std::thread sync([this]() {
+            if (cache.reconcile(client)) {
+                ready = true;
+                LOG(INFO) << "upsf_proxy: cache in sync, revision=" << cache.view().revision() << std::endl;
+            }
+        });
+
+        hub.run();
+
+        /* upstream stream terminated: forward reads until reconciled again */
+        ready = false;
+        sync.join();
+        /* a reconcile completing meanwhile must not enable the cache */
+        ready = false;
+
+        if (!stopping) {
+            LOG(WARNING) << "upsf_proxy: upstream watch stream terminated, reconnecting" << std::endl;
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+}
+
+grpc::Status UpsfProxy::CreateV1(
+    grpc::ServerContext* context,
+    const wt474_messages::v1::Item* request,
+    wt474_messages::v1::Item* response)
+{
+    VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+    std::unique_ptr<grpc::ClientContext> upstream_context = grpc::ClientContext::FromServerContext(*context);
+    grpc::Status status = stub->CreateV1(upstream_context.get(), *request, response);
+    if (status.ok()) {
+        /* read your writes, unless the watch stream delivered a newer copy meanwhile */
+        cache.put_if_newer(std::make_shared<wt474_messages::v1::Item>(*response));
+    }
+    return status;
+}
+
+grpc::Status UpsfProxy::UpdateV1(
+    grpc::ServerContext* context,
+    const wt474_upsf_service::v1::UpdateReq* request,
+    wt474_messages::v1::Item* response)
+{
+    VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+    std::unique_ptr<grpc::ClientContext> upstream_context = grpc::ClientContext::FromServerContext(*context);
+    grpc::Status status = stub->UpdateV1(upstream_context.get(), *request, response);
+    if (status.ok()) {
+        cache.put_if_newer(std::make_shared<wt474_messages::v1::Item>(*response));
+    }
+    return status;
+}
+
+grpc::Status UpsfProxy::DeleteV1(
+    grpc::ServerContext* context,
+    const google::protobuf::StringValue* request,
+    google::protobuf::StringValue* response)
+{
+    VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+    /* the removal reaches the cache via the watch stream, names are not unique across item types */
+    std::unique_ptr<grpc::ClientContext> upstream_context = grpc::ClientContext::FromServerContext(*context);
+    return stub->DeleteV1(upstream_context.get(), *request, response);
+}
+
+grpc::Status UpsfProxy::LookupV1(
+    grpc::ServerContext* context,
+    const wt474_messages::v1::SessionContext::Spec* request,
+    wt474_messages::v1::SessionContext* response)
+{
+    VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+    /* served from the lookup cache, misses of concurrent identical requests share a single call */
+    std::string key = upsf::UpsfLookupCache::key_of(*request);
+    return lookup_cache.LookupV1(*request, *response,
+        [this, request, &key](wt474_messages::v1::SessionContext& result) {
+            return lookups.run(key, result,
+                [this, request](wt474_messages::v1::SessionContext& result) {
+                    /* shared by several callers: not bound to a single downstream context */
+                    grpc::ClientContext upstream_context;
+                    upstream_context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(FLAGS_upstreamtimeout));
+                    return stub->LookupV1(&upstream_context, *request, &result);
+                });
+        });
+}
+
+grpc::Status UpsfProxy::ReadV1(
+    grpc::ServerContext* context,
+    const wt474_upsf_service::v1::ReadReq* request,
+    grpc::ServerWriter<wt474_messages::v1::Item>* writer)
+{
+    VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+    /* parent filters are evaluated by the UPSF only */
+    if (request->parent_size() > 0) {
+        if (request->watch()) {
+            return watch_forwarded(context, *request, writer);
+        }
+        return read_forwarded(*request, writer);
+    }
+
+    if (request->watch()) {
+        return watch_cached(context, *request, writer);
+    }
+
+    if (!ready) {
+        return read_forwarded(*request, writer);
+    }
+    reads_cached++;
+    read_cached(*request, writer);
+
+    return grpc::Status::OK;
+}
+
+bool UpsfProxy::read_cached(
+    const wt474_upsf_service::v1::ReadReq& request,
+    grpc::ServerWriter<wt474_messages::v1::Item>* writer)
+{
+    bool result = true;
+    upsf::UpsfCache::View view = cache.view();
+
+    /* by name: direct lookups instead of a full scan */
+    if (request.name_size() > 0) {
+        for (size_t index = 0; result && index < upsf::UpsfCache::num_itemtypes; index++) {
+            for (const auto& name : request.name()) {
+                const wt474_messages::v1::Item* item = view.find(wt474_upsf_service::v1::ItemType(index), name.value());
+                if (item && matches(request, *item)) {
+                    result = writer->Write(*item);
+                }
+            }
+        }
+        return result;
+    }
+
+    for (size_t index = 0; result && index < upsf::UpsfCache::num_itemtypes; index++) {
+        wt474_upsf_service::v1::ItemType itemtype = wt474_upsf_service::v1::ItemType(index);
+        if (request.itemtype_size() > 0 && std::find(request.itemtype().begin(), request.itemtype().end(), itemtype) == request.itemtype().end()) {
+            continue;
+        }
+        view.for_each(itemtype,
+            [&request, writer, &result](const upsf::UpsfCache::ItemPtr& item) {
+                if (matches(request, *item)) {
+                    result = writer->Write(*item);
+                }
+                return result;
+            });
+    }
+    return result;
+}
+
+grpc::Status UpsfProxy::read_forwarded(
+    const wt474_upsf_service::v1::ReadReq& request,
+    grpc::ServerWriter<wt474_messages::v1::Item>* writer)
+{
+    reads_forwarded++;
+
+    std::string key;
+    request.SerializeToString(&key);
+    std::vector<wt474_messages::v1::Item> items;
+    grpc::Status status = reads.run(key, items,
+        [this, &request](std::vector<wt474_messages::v1::Item>& result) {
+            grpc::ClientContext upstream_context;
+            upstream_context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(FLAGS_upstreamtimeout));
+            std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(stub->ReadV1(&upstream_context, request));
+            wt474_messages::v1::Item item;
+            while (reader->Read(&item)) {
+                result.push_back(std::move(item));
+                item.Clear();
+            }
+            return reader->Finish();
+        });
+
+    for (const auto& item : items) {
+        if (!writer->Write(item)) {
+            break;
+        }
+    }
+    return status;
+}
+
+grpc::Status UpsfProxy::watch_forwarded(
+    grpc::ServerContext* context,
+    const wt474_upsf_service::v1::ReadReq& request,
+    grpc::ServerWriter<wt474_messages::v1::Item>* writer)
+{
+    std::unique_ptr<grpc::ClientContext> upstream_context = grpc::ClientContext::FromServerContext(*context);
+    std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(stub->ReadV1(upstream_context.get(), request));
+    wt474_messages::v1::Item item;
+    while (reader->Read(&item)) {
+        if (!writer->Write(item)) {
+            upstream_context->TryCancel();
+            break;
+        }
+    }
+    return reader->Finish();
+}
+
+grpc::Status UpsfProxy::watch_cached(
+    grpc::ServerContext* context,
+    const wt474_upsf_service::v1::ReadReq& request,
+    grpc::ServerWriter<wt474_messages::v1::Item>* writer)
+{
+    /* attach first, so no change is missed while sending the current state */
+    UpsfProxyWatch watch(request);
+    hub.attach(watch);
+
+    bool result = true;
+    if (ready) {
+        result = read_cached(request, writer);
+    } else {
+        wt474_upsf_service::v1::ReadReq current(request);
+        current.set_watch(false);
+        result = read_forwarded(current, writer).ok();
+    }
+
+    std::shared_ptr<const wt474_messages::v1::Item> item;
+    while (result && watch.next(context, stopping, item)) {
+        result = writer->Write(*item);
+    }
+    hub.detach(watch);
+
+    if (watch.overflowed()) {
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "watch queue overflow");
+    }
+    return grpc::Status::OK;
+}
+
+int main(int argc, char** argv)
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    // upstream and listening address
+    std::stringstream upsfaddr;
+    upsfaddr << FLAGS_upsfhost << ":" << FLAGS_upsfport;
+    std::stringstream listenaddr;
+    listenaddr << FLAGS_listenhost << ":" << FLAGS_listenport;
+
+    VLOG(1) << "UPSF address: " << upsfaddr.str() << std::endl;
+    VLOG(1) << "listening address: " << listenaddr.str() << std::endl;
+
+    // block termination signals, handled by a dedicated thread below
+    sigset_t sigset;
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGINT);
+    sigaddset(&sigset, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigset, nullptr);
+
+    // proxy
+    UpsfProxy proxy(grpc::CreateChannel(upsfaddr.str(), grpc::InsecureChannelCredentials()));
+    proxy.start();
+
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(listenaddr.str(), grpc::InsecureServerCredentials());
+    builder.RegisterService(&proxy);
+    std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+    if (!server) {
+        LOG(ERROR) << "failure: unable to listen on " << listenaddr.str() << std::endl;
+        proxy.stop();
+        return 1;
+    }
+    LOG(INFO) << "upsf_proxy: listening on " << listenaddr.str() << ", upstream " << upsfaddr.str() << std::endl;
+
+    std::thread signals([&]() {
+        int sig;
+        sigwait(&sigset, &sig);
+        proxy.stop();
+        server->Shutdown(std::chrono::system_clock::now() + std::chrono::seconds(1));
+    });
+
+    server->Wait();
+    signals.join();
+
+    return 0;
+};
@@ -0,0 +1,190 @@
+/* upsf_proxy
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef UPSF_PROXY_HPP
+#define UPSF_PROXY_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+
+#include "upsf.hpp"
+#include "upsf_cache.hpp"
+#include "upsf_flight.hpp"
+#include "upsf_hub.hpp"
+#include "upsf_lookup.hpp"
+
+/*
+ * UpsfProxyWatch queues items for a single downstream watch stream, it is
+ * attached as local subscriber to the proxy's upstream subscription hub
+ */
+class UpsfProxyWatch : public upsf::UpsfSubscriber {
+public:
+    UpsfProxyWatch(
+        const wt474_upsf_service::v1::ReadReq& req);
+
+    virtual ~UpsfProxyWatch() {};
+
+    /* queue a shared item, the watch overflows if the queue is full */
+    void notify(
+        const std::shared_ptr<const wt474_messages::v1::Item>& item) override;
+
+    /* wait for the next item, returns false if the downstream context was
+     * cancelled, the proxy is stopping or the queue overflowed */
+    bool next(
+        grpc::ServerContext* context,
+        const std::atomic<bool>& stopping,
+        std::shared_ptr<const wt474_messages::v1::Item>& item);
+
+    /* the queue overflowed */
+    bool overflowed() const;
+
+private:
+    /* queued items */
+    std::deque<std::shared_ptr<const wt474_messages::v1::Item>> queue;
+    /* queue overflowed */
+    bool overflow;
+    /* mutex and condition for queue */
+    mutable std::mutex mutex;
+    std::condition_variable cond;
+};
+
+/*
+ * UpsfProxy implements the UPSF service for local clients: reads are served
+ * from a local cache fed by a single upstream watch stream, watches are
+ * multiplexed onto that stream, lookups are served from a lookup cache fed
+ * by the same stream, lookups and reads not answerable from the caches are
+ * coalesced and forwarded, writes are forwarded as is.
+ */
+class UpsfProxy final : public wt474_upsf_service::v1::upsf::Service {
+private:
+    /* upstream channel shared by all forwarded calls */
+    std::shared_ptr<grpc::Channel> channel;
+    /* upstream stub for forwarding, stubs are thread-safe */
+    std::unique_ptr<wt474_upsf_service::v1::upsf::Stub> stub;
+    /* libupsf client for reconciling the cache */
+    upsf::UpsfClient client;
+    /* upstream watch stream */
+    upsf::UpsfSubscriptionHub hub;
+    /* local item cache */
+    upsf::UpsfCache cache;
+    /* local lookup result cache */
+    upsf::UpsfLookupCache lookup_cache;
+    /* cache is in sync with upstream */
+    std::atomic<bool> ready;
+    /* proxy is stopping */
+    std::atomic<bool> stopping;
+    /* upstream thread */
+    std::thread upstream;
+    /* coalesced upstream calls */
+    upsf::UpsfSingleFlight<wt474_messages::v1::SessionContext> lookups;
+    upsf::UpsfSingleFlight<std::vector<wt474_messages::v1::Item>> reads;
+    /* statistics */
+    std::atomic<uint64_t> reads_cached;
+    std::atomic<uint64_t> reads_forwarded;
+
+public:
+    UpsfProxy(
+        std::shared_ptr<grpc::Channel> channel);
+
+    virtual ~UpsfProxy();
+
+    /* start serving the upstream watch stream */
+    void start();
+
+    /* stop serving the upstream watch stream and all downstream watches */
+    void stop();
+
+    grpc::Status CreateV1(
+        grpc::ServerContext* context,
+        const wt474_messages::v1::Item* request,
+        wt474_messages::v1::Item* response) override;
+
+    grpc::Status ReadV1(
+        grpc::ServerContext* context,
+        const wt474_upsf_service::v1::ReadReq* request,
+        grpc::ServerWriter<wt474_messages::v1::Item>* writer) override;
+
+    grpc::Status UpdateV1(
+        grpc::ServerContext* context,
+        const wt474_upsf_service::v1::UpdateReq* request,
+        wt474_messages::v1::Item* response) override;
+
+    grpc::Status DeleteV1(
+        grpc::ServerContext* context,
+        const google::protobuf::StringValue* request,
+        google::protobuf::StringValue* response) override;
+
+    grpc::Status LookupV1(
+        grpc::ServerContext* context,
+        const wt474_messages::v1::SessionContext::Spec* request,
+        wt474_messages::v1::SessionContext* response) override;
+
+private:
+    /* keep the upstream watch stream and the cache in sync */
+    void run_upstream();
+
+    /* write all cached items matching request */
+    bool read_cached(
+        const wt474_upsf_service::v1::ReadReq& request,
+        grpc::ServerWriter<wt474_messages::v1::Item>* writer);
+
+    /* read from upstream, concurrent identical requests share a single call */
+    grpc::Status read_forwarded(
+        const wt474_upsf_service::v1::ReadReq& request,
+        grpc::ServerWriter<wt474_messages::v1::Item>* writer);
+
+    /* relay an upstream watch stream not served by the hub */
+    grpc::Status watch_forwarded(
+        grpc::ServerContext* context,
+        const wt474_upsf_service::v1::ReadReq& request,
+        grpc::ServerWriter<wt474_messages::v1::Item>* writer);
+
+    /* serve a watch from the hub */
+    grpc::Status watch_cached(
+        grpc::ServerContext* context,
+        const wt474_upsf_service::v1::ReadReq& request,
+        grpc::ServerWriter<wt474_messages::v1::Item>* writer);
+};
+
+#endif
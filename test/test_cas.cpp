@@ -0,0 +1,148 @@
+/* test_cas.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * UpsfCompareAndSet against a stub server and a lagging cache
+ */
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "upsf_cache.hpp"
+#include "upsf_cas.hpp"
+#include "upsf_stub_server.hpp"
+
+using namespace wt474_messages::v1;
+using wt474_upsf_service::v1::ItemType;
+
+namespace {
+
+TEST(UpsfCompareAndSet, UnchangedItemIsUpdated)
+{
+    upsf::UpsfStubServer server;
+    Item current = server.put(upsf::stub_shard("shard-A", 1));
+
+    upsf::UpsfClient client(server.channel());
+    upsf::UpsfCache cache;
+    upsf::UpsfCompareAndSet cas(client, &cache);
+
+    Shard update = current.shard();
+    update.mutable_spec()->set_max_session_count(2);
+    Shard reply;
+    grpc::Status status;
+    EXPECT_TRUE(cas.UpdateV1(update, reply, status));
+    EXPECT_EQ(server.get("shard-A").shard().spec().max_session_count(), 2);
+    ASSERT_TRUE(cache.get(ItemType::shard, "shard-A"));
+    EXPECT_EQ(cache.get(ItemType::shard, "shard-A")->shard().spec().max_session_count(), 2);
+}
+
+TEST(UpsfCompareAndSet, StaleCacheDoesNotLetLostUpdateThrough)
+{
+    upsf::UpsfStubServer server;
+    Item read = server.put(upsf::stub_shard("shard-A", 1));
+
+    /* the cache still holds the copy the caller has read */
+    upsf::UpsfCache cache;
+    cache.put(std::make_shared<const Item>(read));
+
+    /* another writer changes the item, the cache has not seen it yet */
+    server.put(upsf::stub_shard("shard-A", 10));
+
+    upsf::UpsfClient client(server.channel());
+    upsf::UpsfCompareAndSet cas(client, &cache);
+
+    Shard update = read.shard();
+    update.mutable_spec()->set_max_session_count(2);
+    Shard reply;
+    grpc::Status status;
+    EXPECT_FALSE(cas.UpdateV1(update, reply, status));
+    EXPECT_TRUE(upsf::UpsfCompareAndSet::is_conflict(status));
+    EXPECT_EQ(reply.spec().max_session_count(), 10);
+    EXPECT_EQ(server.updates, 0u);
+    EXPECT_EQ(server.get("shard-A").shard().spec().max_session_count(), 10);
+    EXPECT_EQ(cas.get_conflicts(), 1u);
+}
+
+TEST(UpsfCompareAndSet, LaggingCacheDoesNotReportFalseConflict)
+{
+    upsf::UpsfStubServer server;
+    Item old = server.put(upsf::stub_shard("shard-A", 1));
+    Item read = server.put(upsf::stub_shard("shard-A", 10));
+
+    /* the cache still holds an older copy than the caller has read */
+    upsf::UpsfCache cache;
+    cache.put(std::make_shared<const Item>(old));
+
+    upsf::UpsfClient client(server.channel());
+    upsf::UpsfCompareAndSet cas(client, &cache);
+
+    Shard update = read.shard();
+    update.mutable_spec()->set_max_session_count(2);
+    Shard reply;
+    grpc::Status status;
+    EXPECT_TRUE(cas.UpdateV1(update, reply, status));
+    EXPECT_EQ(server.get("shard-A").shard().spec().max_session_count(), 2);
+}
+
+TEST(UpsfCompareAndSet, ReadKeepsNewerCachedCopy)
+{
+    upsf::UpsfStubServer server;
+    Item old = server.put(upsf::stub_shard("shard-A", 1));
+    Item current = server.put(upsf::stub_shard("shard-A", 10));
+
+    /* the watch stream has applied a newer copy than the read will return */
+    Item newer = current;
+    newer.mutable_shard()->mutable_spec()->set_max_session_count(20);
+    newer.mutable_shard()->mutable_metadata()->mutable_last_updated()->set_seconds(current.shard().metadata().last_updated().seconds() + 1000);
+    upsf::UpsfCache cache;
+    cache.put(std::make_shared<const Item>(newer));
+
+    upsf::UpsfClient client(server.channel());
+    upsf::UpsfCompareAndSet cas(client, &cache);
+
+    Shard update = old.shard();
+    update.mutable_spec()->set_max_session_count(2);
+    Shard reply;
+    grpc::Status status;
+    EXPECT_FALSE(cas.UpdateV1(update, reply, status));
+    EXPECT_TRUE(upsf::UpsfCompareAndSet::is_conflict(status));
+    ASSERT_TRUE(cache.get(ItemType::shard, "shard-A"));
+    EXPECT_EQ(cache.get(ItemType::shard, "shard-A")->shard().spec().max_session_count(), 20);
+}
+
+}; // end anonymous namespace
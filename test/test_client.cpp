@@ -0,0 +1,210 @@
+/* test_client.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * UpsfClient calls coalesced by a shared UpsfFlights instance
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "upsf.hpp"
+#include "upsf_cache.hpp"
+#include "upsf_flight.hpp"
+#include "upsf_stub_server.hpp"
+
+using namespace wt474_messages::v1;
+using wt474_upsf_service::v1::ItemType;
+
+namespace {
+
+TEST(UpsfClient, ConcurrentReadsShareOneCall)
+{
+    upsf::UpsfStubServer server;
+    server.put(upsf::stub_shard("shard-A", 1));
+    server.set_read_delay(std::chrono::milliseconds(200));
+
+    const int num_threads = 8;
+    auto flights = std::make_shared<upsf::UpsfFlights>();
+    std::atomic<int> found(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+        threads.emplace_back([&server, &flights, &found]() {
+            upsf::UpsfClient client(server.channel(), flights);
+            Item item;
+            if (client.ReadV1(ItemType::shard, "shard-A", item) && item.shard().spec().max_session_count() == 1) {
+                found++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(found, num_threads);
+    EXPECT_LT(server.reads, uint64_t(num_threads));
+    EXPECT_EQ(server.reads + flights->reads.get_coalesced(), uint64_t(num_threads));
+}
+
+TEST(UpsfClient, ReadAfterWriteDoesNotShareEarlierCall)
+{
+    upsf::UpsfStubServer server;
+    server.put(upsf::stub_shard("shard-A", 1));
+    server.set_read_delay(std::chrono::milliseconds(300));
+
+    auto flights = std::make_shared<upsf::UpsfFlights>();
+
+    /* a slow read of the old copy is in flight while the item is updated */
+    Item early;
+    std::thread reader([&server, &flights, &early]() {
+        upsf::UpsfClient client(server.channel(), flights);
+        client.ReadV1(ItemType::shard, "shard-A", early);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    upsf::UpsfClient writer(server.channel(), flights);
+    wt474_upsf_service::v1::UpdateReq req;
+    *req.mutable_item() = upsf::stub_shard("shard-A", 2);
+    Item updated;
+    ASSERT_TRUE(writer.UpdateV1(req, updated));
+
+    Item item;
+    ASSERT_TRUE(writer.ReadV1(ItemType::shard, "shard-A", item));
+    reader.join();
+
+    EXPECT_EQ(early.shard().spec().max_session_count(), 1);
+    EXPECT_EQ(item.shard().spec().max_session_count(), 2);
+    EXPECT_EQ(flights->reads.get_coalesced(), 0u);
+}
+
+TEST(UpsfClient, ConcurrentLookupsShareOneCall)
+{
+    upsf::UpsfStubServer server;
+    Item item;
+    item.mutable_session_context()->set_name("session-A");
+    item.mutable_session_context()->mutable_spec()->set_circuit_id("circuit-A");
+    server.put(item);
+    server.set_read_delay(std::chrono::milliseconds(200));
+
+    const int num_threads = 8;
+    auto flights = std::make_shared<upsf::UpsfFlights>();
+    std::atomic<int> found(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+        threads.emplace_back([&server, &flights, &found]() {
+            upsf::UpsfClient client(server.channel(), flights);
+            SessionContext::Spec spec;
+            spec.set_circuit_id("circuit-A");
+            SessionContext resp;
+            if (client.LookupV1(spec, resp) && resp.name() == "session-A") {
+                found++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(found, num_threads);
+    EXPECT_LT(server.lookups, uint64_t(num_threads));
+    EXPECT_EQ(server.lookups + flights->lookups.get_coalesced(), uint64_t(num_threads));
+}
+
+TEST(UpsfClient, CountAndExistsAskTheCacheFirst)
+{
+    upsf::UpsfStubServer server;
+    upsf::UpsfCache cache;
+    for (const auto& name : { "shard-A", "shard-B" }) {
+        cache.put(std::make_shared<const Item>(server.put(upsf::stub_shard(name, 1))));
+    }
+
+    upsf::UpsfClient client(server.channel());
+    wt474_upsf_service::v1::ReadReq req;
+    req.add_itemtype(ItemType::shard);
+    size_t count = 0;
+    EXPECT_TRUE(client.Count(req, count, cache.view()));
+    EXPECT_EQ(count, 2u);
+
+    req.add_name()->set_value("shard-B");
+    bool exists = false;
+    EXPECT_TRUE(client.Exists(req, exists, cache.view()));
+    EXPECT_TRUE(exists);
+    EXPECT_EQ(server.reads, 0u);
+
+    /* parent filters are evaluated by the UPSF only */
+    req.add_parent()->set_value("up-A");
+    EXPECT_TRUE(client.Count(req, count, cache.view()));
+    EXPECT_EQ(server.reads, 1u);
+}
+
+TEST(UpsfSingleFlight, ThrowingCallReleasesWaiters)
+{
+    upsf::UpsfSingleFlight<Item> flight;
+    std::atomic<bool> started(false);
+
+    std::thread caller([&flight, &started]() {
+        Item result;
+        EXPECT_THROW(flight.run("key", result, [&started](Item&) -> grpc::Status {
+            started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            throw std::runtime_error("call failed");
+        }),
+            std::runtime_error);
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    /* joins the call in flight and gets its error */
+    Item result;
+    grpc::Status status = flight.run("key", result, [](Item&) { return grpc::Status::OK; });
+    caller.join();
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::INTERNAL);
+    EXPECT_EQ(flight.get_coalesced(), 1u);
+
+    /* a later call with the same key is not joined to the failed one */
+    status = flight.run("key", result, [](Item&) { return grpc::Status::OK; });
+    EXPECT_TRUE(status.ok());
+}
+
+}; // end anonymous namespace
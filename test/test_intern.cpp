@@ -0,0 +1,155 @@
+/* test_intern.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+/*
+ * UpsfInterner and its users UpsfCache and UpsfTopology
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "upsf_cache.hpp"
+#include "upsf_intern.hpp"
+#include "upsf_topology.hpp"
+
+using namespace wt474_messages::v1;
+using wt474_upsf_service::v1::ItemType;
+
+namespace {
+
+TEST(UpsfInterner, EqualStringsGetEqualIds)
+{
+    upsf::UpsfInterner interner;
+    upsf::UpsfInterner::id_t id = interner.intern("shard-A");
+    EXPECT_EQ(interner.intern(std::string("shard-A")), id);
+    EXPECT_NE(interner.intern("shard-B"), id);
+    EXPECT_EQ(interner.intern(""), upsf::UpsfInterner::empty);
+    EXPECT_EQ(interner.find("shard-A"), id);
+    EXPECT_EQ(interner.find("shard-C"), upsf::UpsfInterner::invalid);
+    EXPECT_EQ(interner.str(id), "shard-A");
+    EXPECT_EQ(interner.hash(id), std::hash<std::string>()("shard-A"));
+}
+
+TEST(UpsfInterner, ExhaustedInternerReturnsInvalid)
+{
+    upsf::UpsfInterner interner(3);
+    upsf::UpsfInterner::id_t a = interner.intern("a");
+    upsf::UpsfInterner::id_t b = interner.intern("b");
+    EXPECT_NE(a, upsf::UpsfInterner::invalid);
+    EXPECT_NE(b, upsf::UpsfInterner::invalid);
+    EXPECT_EQ(interner.intern("c"), upsf::UpsfInterner::invalid);
+    EXPECT_EQ(interner.find("c"), upsf::UpsfInterner::invalid);
+    EXPECT_EQ(interner.intern("a"), a);
+    EXPECT_EQ(interner.size(), 3u);
+}
+
+TEST(UpsfSetInterner, EqualSetsGetEqualIds)
+{
+    upsf::UpsfSetInterner interner(3);
+    upsf::UpsfSetInterner::id_t id = interner.intern({ 1, 2, 3 });
+    EXPECT_EQ(interner.intern({ 1, 2, 3 }), id);
+    EXPECT_NE(interner.intern({ 1, 2 }), id);
+    EXPECT_EQ(interner.intern({}), upsf::UpsfInterner::empty);
+    EXPECT_EQ(interner.set(id), std::vector<upsf::UpsfInterner::id_t>({ 1, 2, 3 }));
+    EXPECT_EQ(interner.intern({ 4 }), upsf::UpsfInterner::invalid);
+    EXPECT_EQ(interner.size(), 3u);
+}
+
+TEST(UpsfCache, ServiceGroupsAreInterned)
+{
+    Item up;
+    up.mutable_service_gateway_user_plane()->set_name("up-A");
+    for (const auto& group : { "gold", "basic", "gold", "silver" }) {
+        up.mutable_service_gateway_user_plane()->mutable_spec()->add_supported_service_group(group);
+    }
+    Item session;
+    session.mutable_session_context()->set_name("session-A");
+    for (const auto& group : { "silver", "gold" }) {
+        session.mutable_session_context()->mutable_spec()->add_required_service_group(group);
+    }
+
+    upsf::UpsfCache cache;
+    cache.put(std::make_shared<const Item>(up));
+    cache.put(std::make_shared<const Item>(session));
+
+    upsf::UpsfCache::View view = cache.view();
+    const std::vector<upsf::UpsfInterner::id_t>* supported = view.service_groups(ItemType::service_gateway_user_plane, "up-A");
+    const std::vector<upsf::UpsfInterner::id_t>* required = view.service_groups(ItemType::session_context, "session-A");
+    ASSERT_TRUE(supported);
+    ASSERT_TRUE(required);
+    EXPECT_EQ(supported->size(), 3u);
+    EXPECT_TRUE(std::is_sorted(supported->begin(), supported->end()));
+    EXPECT_TRUE(std::includes(supported->begin(), supported->end(), required->begin(), required->end()));
+    EXPECT_FALSE(view.service_groups(ItemType::session_context, "session-B"));
+
+    /* items with equal service groups share a single set */
+    session.mutable_session_context()->set_name("session-B");
+    session.mutable_session_context()->mutable_spec()->add_required_service_group("gold");
+    cache.put(std::make_shared<const Item>(session));
+    upsf::UpsfCache::View next = cache.view();
+    EXPECT_EQ(next.service_groups(ItemType::session_context, "session-B"), required);
+}
+
+TEST(UpsfTopology, InternedAndUninternedNamesResolve)
+{
+    Shard shard;
+    shard.set_name("shard-A");
+    shard.mutable_spec()->mutable_desired_state()->set_service_gateway_user_plane("up-A");
+    shard.mutable_spec()->mutable_desired_state()->add_network_connection("nc-A");
+    SessionContext session;
+    session.set_name("session-A");
+    session.mutable_spec()->mutable_desired_state()->set_shard("shard-A");
+
+    upsf::UpsfTopology topology;
+    topology.notify(shard);
+    topology.notify(session);
+
+    EXPECT_EQ(topology.shards_of_network_connection("nc-A"), std::vector<std::string>({ "shard-A" }));
+    EXPECT_EQ(topology.session_contexts_of_service_gateway_user_plane("up-A"), std::vector<std::string>({ "session-A" }));
+    EXPECT_EQ(topology.references(ItemType::session_context, "session-A", ItemType::shard), std::vector<std::string>({ "shard-A" }));
+    EXPECT_EQ(topology.id(ItemType::session_context, "session-B"), upsf::UpsfTopology::invalid);
+
+    session.mutable_metadata()->set_derived_state(DerivedState::deleted);
+    topology.notify(session);
+    EXPECT_TRUE(topology.session_contexts_of_service_gateway_user_plane("up-A").empty());
+}
+
+}; // end anonymous namespace
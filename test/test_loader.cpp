@@ -0,0 +1,99 @@
+/* test_loader.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * UpsfLoader against a stub server
+ */
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "upsf_cache.hpp"
+#include "upsf_loader.hpp"
+#include "upsf_stub_server.hpp"
+
+using namespace wt474_messages::v1;
+using wt474_upsf_service::v1::ItemType;
+
+namespace {
+
+TEST(UpsfLoader, PhasesReportReadyInDependencyOrder)
+{
+    upsf::UpsfStubServer server;
+    Item up;
+    up.mutable_service_gateway_user_plane()->set_name("up-A");
+    server.put(up);
+    Item shard = upsf::stub_shard("shard-A", 1);
+    shard.mutable_shard()->mutable_spec()->mutable_desired_state()->set_service_gateway_user_plane("up-A");
+    server.put(shard);
+    Item session;
+    session.mutable_session_context()->set_name("session-A");
+    session.mutable_session_context()->mutable_spec()->mutable_desired_state()->set_shard("shard-A");
+    server.put(session);
+
+    upsf::UpsfCache cache;
+    upsf::UpsfLoader loader(server.channel(), cache);
+    std::mutex mutex;
+    std::vector<ItemType> ready;
+    loader.set_callbacks(
+        [&mutex, &ready, &cache](const upsf::UpsfLoader::Phase& phase) {
+            std::scoped_lock lock(mutex);
+            /* items of a ready phase are in the cache already */
+            if (phase.itemtype == ItemType::shard) {
+                EXPECT_TRUE(cache.get(ItemType::shard, "shard-A"));
+                EXPECT_TRUE(cache.get(ItemType::service_gateway_user_plane, "up-A"));
+            }
+            ready.push_back(phase.itemtype);
+        });
+    ASSERT_TRUE(loader.load());
+
+    ASSERT_EQ(ready.size(), loader.phases().size());
+    auto position = [&ready](ItemType itemtype) {
+        return std::find(ready.begin(), ready.end(), itemtype) - ready.begin();
+    };
+    EXPECT_LT(position(ItemType::service_gateway), position(ItemType::service_gateway_user_plane));
+    EXPECT_LT(position(ItemType::service_gateway_user_plane), position(ItemType::shard));
+    EXPECT_LT(position(ItemType::network_connection), position(ItemType::shard));
+    EXPECT_LT(position(ItemType::shard), position(ItemType::session_context));
+    EXPECT_EQ(loader.referrers(ItemType::shard, "shard-A", ItemType::session_context), std::vector<std::string>({ "session-A" }));
+}
+
+}; // end anonymous namespace
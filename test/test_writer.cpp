@@ -0,0 +1,130 @@
+/* test_writer.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * UpsfWriteBehind retries of failed writes
+ */
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "upsf_stub_server.hpp"
+#include "upsf_writer.hpp"
+
+using namespace wt474_messages::v1;
+
+namespace {
+
+class UpsfWriteBehindTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        server.put(upsf::stub_shard("shard-A", 0));
+    };
+
+    /* write a single update, wait until it has been acknowledged or finally failed */
+    void write(
+        unsigned max_retries)
+    {
+        upsf::UpsfWriteBehind writer(server.channel(), std::chrono::milliseconds(10), max_retries);
+        writer.set_callbacks(
+            [this](const Item&, const Item&) { written++; },
+            [this](const Item&) { failed++; });
+        std::thread thread([&writer]() { writer.run(); });
+
+        Shard shard;
+        shard.set_name("shard-A");
+        shard.mutable_status()->set_allocated_session_count(1);
+        writer.update(shard);
+
+        for (int i = 0; i < 500 && written + failed == 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        /* further retries would show up meanwhile */
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        writer.stop();
+        thread.join();
+        retried = writer.get_retried();
+    };
+
+    upsf::UpsfStubServer server;
+    std::atomic<int> written { 0 };
+    std::atomic<int> failed { 0 };
+    uint64_t retried = 0;
+};
+
+TEST_F(UpsfWriteBehindTest, TransientFailuresAreRetried)
+{
+    server.fail_updates({ grpc::Status(grpc::StatusCode::UNAVAILABLE, "unavailable"),
+        grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED, "deadline exceeded") });
+    write(5);
+
+    EXPECT_EQ(written, 1);
+    EXPECT_EQ(failed, 0);
+    EXPECT_EQ(retried, 2u);
+    EXPECT_EQ(server.updates, 3u);
+    EXPECT_EQ(server.get("shard-A").shard().status().allocated_session_count(), 1);
+}
+
+TEST_F(UpsfWriteBehindTest, PermanentFailureIsReportedOnce)
+{
+    server.fail_updates({ grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "invalid") });
+    write(5);
+
+    EXPECT_EQ(written, 0);
+    EXPECT_EQ(failed, 1);
+    EXPECT_EQ(retried, 0u);
+    EXPECT_EQ(server.updates, 1u);
+}
+
+TEST_F(UpsfWriteBehindTest, RetriesAreCapped)
+{
+    server.fail_updates(std::vector<grpc::Status>(10, grpc::Status(grpc::StatusCode::UNAVAILABLE, "unavailable")));
+    write(2);
+
+    EXPECT_EQ(written, 0);
+    EXPECT_EQ(failed, 1);
+    EXPECT_EQ(retried, 2u);
+    EXPECT_EQ(server.updates, 3u);
+}
+
+}; // end anonymous namespace
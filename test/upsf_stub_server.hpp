@@ -0,0 +1,343 @@
+/* upsf_stub_server.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_STUB_SERVER_HPP
+#define UPSF_STUB_SERVER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+
+#include "upsf_item.hpp"
+
+#include "wt474_upsf_service/v1/service_v1.grpc.pb.h"
+
+namespace upsf {
+
+/**
+ * shard item for populating a stub server
+ */
+inline wt474_messages::v1::Item stub_shard(
+    const std::string& name,
+    int max_session_count)
+{
+    wt474_messages::v1::Item item;
+    item.mutable_shard()->set_name(name);
+    item.mutable_shard()->mutable_spec()->set_max_session_count(max_session_count);
+    return item;
+}
+
+/**
+ * UpsfStubServer is an in-process UPSF for tests: items are kept in a map,
+ * every write stamps metadata.last_updated with a strictly increasing time,
+ * and the number of calls per RPC is counted. Watches are not supported.
+ */
+class UpsfStubServer final : public wt474_upsf_service::v1::upsf::Service {
+
+public:
+    /**
+   * constructor, listens on an ephemeral local port
+   */
+    UpsfStubServer()
+        : clock(0)
+        , creates(0)
+        , reads(0)
+        , updates(0)
+        , deletes(0)
+        , lookups(0)
+    {
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+        builder.RegisterService(this);
+        server = builder.BuildAndStart();
+    };
+
+    ~UpsfStubServer()
+    {
+        server->Shutdown(std::chrono::system_clock::now());
+    };
+
+public:
+    /**
+   * new channel to the server
+   */
+    std::shared_ptr<grpc::Channel> channel() const
+    {
+        return grpc::CreateChannel("127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials());
+    };
+
+    /**
+   * store an item as if written by another client, returns the stored copy
+   */
+    wt474_messages::v1::Item put(
+        const wt474_messages::v1::Item& item)
+    {
+        std::scoped_lock lock(mutex);
+        return store(item);
+    };
+
+    /**
+   * stored copy of an item, empty if none
+   */
+    wt474_messages::v1::Item get(
+        const std::string& name) const
+    {
+        std::scoped_lock lock(mutex);
+        auto it = items.find(name);
+        return it == items.end() ? wt474_messages::v1::Item() : it->second;
+    };
+
+    /**
+   * delay of non-watch ReadV1 and LookupV1 calls after taking their
+   * snapshot of items
+   */
+    void set_read_delay(
+        std::chrono::milliseconds delay)
+    {
+        std::scoped_lock lock(mutex);
+        read_delay = delay;
+    };
+
+    /**
+   * status returned by the next UpdateV1 calls instead of applying them
+   */
+    void fail_updates(
+        const std::vector<grpc::Status>& statuses)
+    {
+        std::scoped_lock lock(mutex);
+        update_failures = statuses;
+    };
+
+public:
+    grpc::Status CreateV1(
+        grpc::ServerContext* context,
+        const wt474_messages::v1::Item* request,
+        wt474_messages::v1::Item* response) override
+    {
+        creates++;
+        std::scoped_lock lock(mutex);
+        *response = store(*request);
+        return grpc::Status::OK;
+    };
+
+    grpc::Status ReadV1(
+        grpc::ServerContext* context,
+        const wt474_upsf_service::v1::ReadReq* request,
+        grpc::ServerWriter<wt474_messages::v1::Item>* writer) override
+    {
+        reads++;
+        if (request->watch()) {
+            return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "watch not supported");
+        }
+
+        std::vector<wt474_messages::v1::Item> matching;
+        std::chrono::milliseconds delay;
+        {
+            std::scoped_lock lock(mutex);
+            for (const auto& it : items) {
+                if (matches(*request, it.second)) {
+                    matching.push_back(it.second);
+                }
+            }
+            delay = read_delay;
+        }
+        std::this_thread::sleep_for(delay);
+
+        for (const auto& item : matching) {
+            if (!writer->Write(item)) {
+                break;
+            }
+        }
+        return grpc::Status::OK;
+    };
+
+    grpc::Status UpdateV1(
+        grpc::ServerContext* context,
+        const wt474_upsf_service::v1::UpdateReq* request,
+        wt474_messages::v1::Item* response) override
+    {
+        updates++;
+        std::scoped_lock lock(mutex);
+        if (!update_failures.empty()) {
+            grpc::Status status = update_failures.front();
+            update_failures.erase(update_failures.begin());
+            return status;
+        }
+        if (items.find(item_name(request->item())) == items.end()) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "no such item");
+        }
+        *response = store(request->item());
+        return grpc::Status::OK;
+    };
+
+    grpc::Status DeleteV1(
+        grpc::ServerContext* context,
+        const google::protobuf::StringValue* request,
+        google::protobuf::StringValue* response) override
+    {
+        deletes++;
+        std::scoped_lock lock(mutex);
+        if (items.erase(request->value()) == 0) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "no such item");
+        }
+        response->set_value(request->value());
+        return grpc::Status::OK;
+    };
+
+    grpc::Status LookupV1(
+        grpc::ServerContext* context,
+        const wt474_messages::v1::SessionContext::Spec* request,
+        wt474_messages::v1::SessionContext* response) override
+    {
+        lookups++;
+        bool found = false;
+        std::chrono::milliseconds delay;
+        {
+            std::scoped_lock lock(mutex);
+            for (const auto& it : items) {
+                if (it.second.has_session_context() && it.second.session_context().spec().circuit_id() == request->circuit_id()) {
+                    *response = it.second.session_context();
+                    found = true;
+                    break;
+                }
+            }
+            delay = read_delay;
+        }
+        std::this_thread::sleep_for(delay);
+
+        if (!found) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "no matching session context");
+        }
+        return grpc::Status::OK;
+    };
+
+private:
+    /**
+   * store a copy stamped with the next last_updated
+   */
+    wt474_messages::v1::Item store(
+        const wt474_messages::v1::Item& item)
+    {
+        wt474_messages::v1::Item stored(item);
+        google::protobuf::Timestamp* last_updated = nullptr;
+        switch (stored.sssitem_case()) {
+        case wt474_messages::v1::Item::kServiceGateway:
+            last_updated = stored.mutable_service_gateway()->mutable_metadata()->mutable_last_updated();
+            break;
+        case wt474_messages::v1::Item::kServiceGatewayUserPlane:
+            last_updated = stored.mutable_service_gateway_user_plane()->mutable_metadata()->mutable_last_updated();
+            break;
+        case wt474_messages::v1::Item::kTrafficSteeringFunction:
+            last_updated = stored.mutable_traffic_steering_function()->mutable_metadata()->mutable_last_updated();
+            break;
+        case wt474_messages::v1::Item::kNetworkConnection:
+            last_updated = stored.mutable_network_connection()->mutable_metadata()->mutable_last_updated();
+            break;
+        case wt474_messages::v1::Item::kShard:
+            last_updated = stored.mutable_shard()->mutable_metadata()->mutable_last_updated();
+            break;
+        case wt474_messages::v1::Item::kSessionContext:
+            last_updated = stored.mutable_session_context()->mutable_metadata()->mutable_last_updated();
+            break;
+        default:
+            break;
+        }
+        if (last_updated) {
+            clock++;
+            last_updated->set_seconds(1000000 + clock / 1000);
+            last_updated->set_nanos(int32_t(clock % 1000) * 1000);
+        }
+        items[item_name(stored)] = stored;
+        return stored;
+    };
+
+    /**
+   * check whether an item passes the type and name filters of a request
+   */
+    static bool matches(
+        const wt474_upsf_service::v1::ReadReq& req,
+        const wt474_messages::v1::Item& item)
+    {
+        wt474_upsf_service::v1::ItemType itemtype;
+        if (!item_type(item, itemtype)) {
+            return false;
+        }
+        if (req.itemtype_size() > 0 && std::find(req.itemtype().begin(), req.itemtype().end(), itemtype) == req.itemtype().end()) {
+            return false;
+        }
+        if (req.name_size() > 0 && std::none_of(req.name().begin(), req.name().end(), [&item](const google::protobuf::StringValue& name) { return name.value() == item_name(item); })) {
+            return false;
+        }
+        return true;
+    };
+
+private:
+    // server and its port
+    std::unique_ptr<grpc::Server> server;
+    int port;
+    // items by name
+    std::map<std::string, wt474_messages::v1::Item> items;
+    // last_updated stamped on the latest write
+    uint64_t clock;
+    // delay of non-watch reads and lookups
+    std::chrono::milliseconds read_delay { 0 };
+    // statuses returned by the next updates
+    std::vector<grpc::Status> update_failures;
+    // mutex for all of the above
+    mutable std::mutex mutex;
+
+public:
+    // statistics
+    std::atomic<uint64_t> creates;
+    std::atomic<uint64_t> reads;
+    std::atomic<uint64_t> updates;
+    std::atomic<uint64_t> deletes;
+    std::atomic<uint64_t> lookups;
+};
+
+}; // end namespace upsf
+
+#endif
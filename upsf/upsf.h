@@ -53,18 +53,9 @@ typedef int upsf_handle_t;
 #define UPSF_MAX_NUM_IP_PREFIXES 16
 #define UPSF_MAX_NUM_SUPPORTED_SERVICE_GROUPS 16
 #define UPSF_MAX_NUM_ENDPOINTS 16
-
-enum upsf_derived_state_t {
-    UPSF_DERIVED_STATE_UNKNOWN = 0,
-    UPSF_DERIVED_STATE_INACTIVE = 1,
-    UPSF_DERIVED_STATE_ACTIVE = 2,
-    UPSF_DERIVED_STATE_UPDATING = 3,
-    UPSF_DERIVED_STATE_DELETING = 4,
-    UPSF_DERIVED_STATE_DELETED = 5,
-    UPSF_DERIVED_STATE_MAX,
-};
-
-const char* upsf_derived_state_to_name(int derived_state);
+#define UPSF_MAX_NUM_SUBSCRIBE_PARENTS 16
+#define UPSF_MAX_NUM_SUBSCRIBE_NAMES 16
+#define UPSF_DEFAULT_BATCH_SIZE 32
 
 enum upsf_item_type_t {
     UPSF_ITEM_TYPE_SERVICE_GATEWAY = 0,
@@ -78,43 +69,6 @@ enum upsf_item_type_t {
 
 const char* upsf_item_type_to_name(int item_type);
 
-enum upsf_maintenance_req_t {
-    UPSF_MAINTENANCE_REQ_NONE = 0,
-    UPSF_MAINTENANCE_REQ_DRAIN = 1,
-    UPSF_MAINTENANCE_REQ_DRAIN_AND_DELETE = 2,
-    UPSF_MAINTENANCE_REQ_MAX,
-};
-
-const char* upsf_maintenance_req_to_name(int maintenance_req);
-
-enum upsf_mbb_state_t {
-    UPSF_MBB_STATE_NON_MBB_MOVE_REQUIRED = 0,
-    UPSF_MBB_STATE_USERPLANE_MBB_INITIATION_REQUIRED = 1,
-    UPSF_MBB_STATE_UPSTREAM_SWITCHOVER_REQUIRED = 2,
-    UPSF_MBB_STATE_DOWNSTREAM_SWITCHOVER_REQUIRED = 3,
-    UPSF_MBB_STATE_UPSTREAM_FINALIZATION_REQUIRED = 4,
-    UPSF_MBB_STATE_COMPLETE = 5,
-    UPSF_MBB_STATE_MAX,
-    //UPSF_MBB_STATE_FAILURE = 999,
-};
-
-enum upsf_nc_spec_type_t {
-    UPSF_NC_SPEC_TYPE_SS_PTP = 0,
-    UPSF_NC_SPEC_TYPE_SS_MPTP = 1,
-    UPSF_NC_SPEC_TYPE_MS_PTP = 2,
-    UPSF_NC_SPEC_TYPE_MS_MPTP = 3,
-    UPSF_NC_SPEC_TYPE_MAX,
-};
-
-/* endpoint types */
-enum upsf_ep_type_t {
-    UPSF_EP_TYPE_UNSPECIFIED = 0,
-    UPSF_EP_TYPE_VTEP = 1,
-    UPSF_EP_TYPE_L2VPN = 2,
-    UPSF_EP_TYPE_PORT_VLAN = 3,
-    UPSF_EP_TYPE_MAX,
-};
-
 /* string type */
 typedef struct {
     char str[UPSF_MAX_STRING_SIZE];
@@ -127,239 +81,225 @@ typedef struct {
     upsf_string_t value;
 } upsf_key_value_t;
 
-/* message: metadata */
+/*
+ * enums and structs of messages_v1.proto, generated by upsf_gen with the
+ * C options in upsf_c.options
+ */
+#include "upsf_c_types.h"
+
+/*
+ * variable length items allocated from a caller provided arena
+ *
+ * Strings and arrays hold the entries actually present in an item instead
+ * of UPSF_MAX_* sized buffers, so neither padding is copied nor entries are
+ * truncated. All memory is taken from the arena and remains valid until
+ * the arena is reset or its buffer is freed by the caller.
+ */
 typedef struct {
-    upsf_string_t description;
-    /* TODO: timestamps */
-    enum upsf_derived_state_t derived_state;
-} upsf_metadata_t;
+    char* base;
+    size_t size;
+    size_t used;
+} upsf_arena_t;
 
-/* message: maintenance */
+/* string type, '\0' terminated */
 typedef struct {
-    enum upsf_maintenance_req_t maintenance_req;
-} upsf_maintenance_t;
+    const char* str;
+    size_t len; // excluding terminating '\0'
+} upsf_var_string_t;
+
+/* map type */
+typedef struct {
+    upsf_var_string_t key;
+    upsf_var_string_t value;
+} upsf_var_key_value_t;
+
+/* message: metadata */
+typedef struct {
+    upsf_var_string_t description;
+    upsf_timestamp_t created;
+    upsf_timestamp_t last_updated;
+    enum upsf_derived_state_t derived_state;
+} upsf_var_metadata_t;
 
 /* message: vtep */
 typedef struct {
-    upsf_string_t ip_address;
+    upsf_var_string_t ip_address;
     int udp_port;
     int vni;
-} upsf_vtep_t;
+} upsf_var_vtep_t;
 
 /* message: port_vlan */
 typedef struct {
-    upsf_string_t logical_port;
+    upsf_var_string_t logical_port;
     int svlan;
     int cvlan;
-} upsf_port_vlan_t;
-
-/* message: l2vpn */
-typedef struct {
-    int vpn_id;
-} upsf_l2vpn_t;
+} upsf_var_port_vlan_t;
 
 /* message: network_connection.spec.endpoint */
 typedef struct {
-    upsf_string_t endpoint_name;
+    upsf_var_string_t endpoint_name;
     enum upsf_ep_type_t ep_type;
-    union ep_spec_u {
-        upsf_vtep_t vtep;
+    union var_ep_spec_u {
+        upsf_var_vtep_t vtep;
         upsf_l2vpn_t l2vpn;
-        upsf_port_vlan_t port_vlan;
+        upsf_var_port_vlan_t port_vlan;
     } ep_spec;
-} upsf_network_connection_spec_endpoint_t;
-
-/* message: ss_ptp_spec */
-typedef struct {
-    upsf_network_connection_spec_endpoint_t sgup_endpoint[UPSF_MAX_NUM_ENDPOINTS];
-    size_t sgup_endpoint_size;
-    upsf_network_connection_spec_endpoint_t tsf_endpoint;
-} upsf_network_connection_spec_ss_ptp_spec_t;
-
-/* message: ss_mptp_spec */
-typedef struct {
-    upsf_network_connection_spec_endpoint_t sgup_endpoint[UPSF_MAX_NUM_ENDPOINTS];
-    size_t sgup_endpoint_size;
-    upsf_network_connection_spec_endpoint_t tsf_endpoint[UPSF_MAX_NUM_ENDPOINTS];
-    size_t tsf_endpoint_size;
-} upsf_network_connection_spec_ss_mptp_spec_t;
-
-/* message: ms_ptp_spec */
-typedef struct {
-    upsf_network_connection_spec_endpoint_t sgup_endpoint;
-    upsf_network_connection_spec_endpoint_t tsf_endpoint;
-} upsf_network_connection_spec_ms_ptp_spec_t;
-
-/* message: ms_mptp_spec */
-typedef struct {
-    upsf_network_connection_spec_endpoint_t sgup_endpoint;
-    upsf_network_connection_spec_endpoint_t tsf_endpoint[UPSF_MAX_NUM_ENDPOINTS];
-    size_t tsf_endpoint_size;
-} upsf_network_connection_spec_ms_mptp_spec_t;
+} upsf_var_network_connection_spec_endpoint_t;
 
-/* message: network_connection.spec */
+/* message: network_connection.spec, endpoints of all nc_spec types,
+ * single endpoint types use an array of size 1 */
 typedef struct {
     int maximum_supported_quality;
     enum upsf_nc_spec_type_t nc_spec_type;
-    union nc_spec_u {
-        upsf_network_connection_spec_ss_ptp_spec_t ss_ptp;
-        upsf_network_connection_spec_ss_mptp_spec_t ss_mptp;
-        upsf_network_connection_spec_ms_ptp_spec_t ms_ptp;
-        upsf_network_connection_spec_ms_mptp_spec_t ms_mptp;
-    } nc_spec;
-} upsf_network_connection_spec_t;
+    upsf_var_network_connection_spec_endpoint_t* sgup_endpoint;
+    size_t sgup_endpoint_size;
+    upsf_var_network_connection_spec_endpoint_t* tsf_endpoint;
+    size_t tsf_endpoint_size;
+} upsf_var_network_connection_spec_t;
 
 /* message: network_connection.status */
 typedef struct {
-    upsf_key_value_t nc_active[UPSF_MAX_NUM_ENDPOINTS];
+    upsf_var_key_value_t* nc_active;
     size_t nc_active_size;
     int allocated_shards;
-} upsf_network_connection_status_t;
+} upsf_var_network_connection_status_t;
 
 /* message: network connection */
 typedef struct {
-    upsf_string_t name;
-    upsf_metadata_t metadata;
+    upsf_var_string_t name;
+    upsf_var_metadata_t metadata;
     upsf_maintenance_t maintenance;
-    upsf_network_connection_spec_t spec;
-    upsf_network_connection_status_t status;
-} upsf_network_connection_t;
+    upsf_var_network_connection_spec_t spec;
+    upsf_var_network_connection_status_t status;
+} upsf_var_network_connection_t;
 
 /* message: service gateway user plane spec */
 typedef struct {
     int max_session_count;
     int max_shards;
-    upsf_string_t supported_service_group[UPSF_MAX_NUM_SUPPORTED_SERVICE_GROUPS];
+    upsf_var_string_t* supported_service_group;
     size_t supported_service_group_size;
-    upsf_network_connection_spec_endpoint_t default_endpoint;
-} upsf_service_gateway_user_plane_spec_t;
-
-/* message: service gateway userplane status */
-typedef struct {
-    int allocated_session_count;
-    int allocated_shards;
-} upsf_service_gateway_user_plane_status_t;
+    upsf_var_network_connection_spec_endpoint_t default_endpoint;
+} upsf_var_service_gateway_user_plane_spec_t;
 
 /* message: service gateway */
 typedef struct {
-    upsf_string_t name;
-    upsf_metadata_t metadata;
-} upsf_service_gateway_t;
+    upsf_var_string_t name;
+    upsf_var_metadata_t metadata;
+} upsf_var_service_gateway_t;
 
 /* message: service gateway user plane */
 typedef struct {
-    upsf_string_t name;
-    upsf_metadata_t metadata;
-    upsf_string_t service_gateway_name;
+    upsf_var_string_t name;
+    upsf_var_metadata_t metadata;
+    upsf_var_string_t service_gateway_name;
     upsf_maintenance_t maintenance;
-    upsf_service_gateway_user_plane_spec_t spec;
+    upsf_var_service_gateway_user_plane_spec_t spec;
     upsf_service_gateway_user_plane_status_t status;
-} upsf_service_gateway_user_plane_t;
+} upsf_var_service_gateway_user_plane_t;
 
 /* message: traffic_steering_function_spec */
 typedef struct {
-    upsf_network_connection_spec_endpoint_t default_endpoint;
-} upsf_traffic_steering_function_spec_t;
+    upsf_var_network_connection_spec_endpoint_t default_endpoint;
+} upsf_var_traffic_steering_function_spec_t;
 
 /* message: traffic steering function */
 typedef struct {
-    upsf_string_t name;
-    upsf_metadata_t metadata;
-    upsf_traffic_steering_function_spec_t spec;
-} upsf_traffic_steering_function_t;
+    upsf_var_string_t name;
+    upsf_var_metadata_t metadata;
+    upsf_var_traffic_steering_function_spec_t spec;
+} upsf_var_traffic_steering_function_t;
 
 /* message: shard_spec_desired_state */
 typedef struct {
-    upsf_string_t service_gateway_user_plane;
-    upsf_string_t network_connection[UPSF_MAX_NUM_NETWORK_CONNECTIONS];
+    upsf_var_string_t service_gateway_user_plane;
+    upsf_var_string_t* network_connection;
     size_t network_connection_size;
-} upsf_shard_spec_desired_state_t;
+} upsf_var_shard_spec_desired_state_t;
 
 /* message: shard_spec */
 typedef struct {
     int max_session_count;
-    upsf_string_t virtual_mac;
-    upsf_shard_spec_desired_state_t desired_state;
-    upsf_string_t prefix[UPSF_MAX_NUM_IP_PREFIXES];
+    upsf_var_string_t virtual_mac;
+    upsf_var_shard_spec_desired_state_t desired_state;
+    upsf_var_string_t* prefix;
     size_t prefix_size;
-} upsf_shard_spec_t;
+} upsf_var_shard_spec_t;
 
 /* message: shard_status_current_state */
 typedef struct {
-    upsf_string_t service_gateway_user_plane;
-    upsf_key_value_t tsf_network_connection[UPSF_MAX_NUM_TSF_NETWORK_CONNECTIONS];
+    upsf_var_string_t service_gateway_user_plane;
+    upsf_var_key_value_t* tsf_network_connection;
     size_t tsf_network_connection_size;
-} upsf_shard_status_current_state_t;
+} upsf_var_shard_status_current_state_t;
 
 /* message: shard_status */
 typedef struct {
     int allocated_session_count;
     int maximum_allocated_quality;
-    upsf_string_t service_groups_supported[UPSF_MAX_NUM_SUPPORTED_SERVICE_GROUPS];
+    upsf_var_string_t* service_groups_supported;
     size_t service_groups_supported_size;
-    upsf_shard_status_current_state_t current_state;
-} upsf_shard_status_t;
-
-/* message: shard_mbb */
-typedef struct {
-    enum upsf_mbb_state_t mbb_state;
-} upsf_shard_mbb_t;
+    upsf_var_shard_status_current_state_t current_state;
+} upsf_var_shard_status_t;
 
 /* message: shard */
 typedef struct {
-    upsf_string_t name;
-    upsf_metadata_t metadata;
-    upsf_shard_spec_t spec;
-    upsf_shard_status_t status;
+    upsf_var_string_t name;
+    upsf_var_metadata_t metadata;
+    upsf_var_shard_spec_t spec;
+    upsf_var_shard_status_t status;
     upsf_shard_mbb_t mbb;
-} upsf_shard_t;
+} upsf_var_shard_t;
 
 /* message: session_filter */
 typedef struct {
-    upsf_string_t source_mac_address;
+    upsf_var_string_t source_mac_address;
     int svlan;
     int cvlan;
-} upsf_session_filter_t;
-
-/* message: session_context_spec_desired_state */
-typedef struct {
-    upsf_string_t shard;
-} upsf_session_context_spec_desired_state_t;
+} upsf_var_session_filter_t;
 
 /* message: session_context_spec */
 typedef struct {
-    upsf_string_t traffic_steering_function;
-    upsf_string_t required_service_group[UPSF_MAX_NUM_REQUIRED_SERVICE_GROUPS];
+    upsf_var_string_t traffic_steering_function;
+    upsf_var_string_t* required_service_group;
     size_t required_service_group_size;
     int required_quality;
-    upsf_string_t circuit_id;
-    upsf_string_t remote_id;
-    upsf_session_filter_t session_filter;
-    upsf_session_context_spec_desired_state_t desired_state;
-    upsf_string_t network_connection;
-} upsf_session_context_spec_t;
-
-/* message: session_context_status_current_state */
-typedef struct {
-    upsf_string_t user_plane_shard;
-    upsf_string_t tsf_shard;
-} upsf_session_context_status_current_state_t;
+    upsf_var_string_t circuit_id;
+    upsf_var_string_t remote_id;
+    upsf_var_session_filter_t session_filter;
+    upsf_var_string_t desired_shard;
+    upsf_var_string_t network_connection;
+} upsf_var_session_context_spec_t;
 
 /* message: session_context_status */
 typedef struct {
-    upsf_session_context_status_current_state_t current_state;
-} upsf_session_context_status_t;
+    upsf_var_string_t current_user_plane_shard;
+    upsf_var_string_t current_tsf_shard;
+} upsf_var_session_context_status_t;
 
 /* message: session_context */
 typedef struct {
-    upsf_string_t name;
-    upsf_metadata_t metadata;
-    upsf_session_context_spec_t spec;
-    upsf_session_context_status_t status;
-} upsf_session_context_t;
+    upsf_var_string_t name;
+    upsf_var_metadata_t metadata;
+    upsf_var_session_context_spec_t spec;
+    upsf_var_session_context_status_t status;
+} upsf_var_session_context_t;
+
+/* subscribe filter, mapped onto ReadReq */
+typedef struct {
+    enum upsf_item_type_t item_types[UPSF_ITEM_TYPE_MAX];
+    size_t item_types_size; // 0: derive item types from non-NULL callbacks
+    enum upsf_derived_state_t derived_states[UPSF_DERIVED_STATE_MAX];
+    size_t derived_states_size; // 0: unknown, inactive, active, updating
+    upsf_string_t parents[UPSF_MAX_NUM_SUBSCRIBE_PARENTS];
+    size_t parents_size;
+    upsf_string_t names[UPSF_MAX_NUM_SUBSCRIBE_NAMES];
+    size_t names_size;
+} upsf_subscribe_filter_t;
 
 /*
- *
+ * subscriber callbacks, items point to per-subscription buffers reused
+ * across callbacks, treat them as read-only and copy what must be retained
  */
 typedef int (*upsf_shard_cb_t)(upsf_shard_t* shard, void* userdata);
 typedef int (*upsf_session_context_cb_t)(upsf_session_context_t* session_context, void* userdata);
@@ -368,6 +308,125 @@ typedef int (*upsf_service_gateway_user_plane_cb_t)(upsf_service_gateway_user_pl
 typedef int (*upsf_traffic_steering_function_cb_t)(upsf_traffic_steering_function_t* traffic_steering_function, void* userdata);
 typedef int (*upsf_service_gateway_cb_t)(upsf_service_gateway_t* service_gateway, void* userdata);
 
+/*
+ * batch callbacks, items are valid for the duration of the callback only,
+ * same as for single item callbacks above
+ */
+typedef int (*upsf_shard_batch_cb_t)(upsf_shard_t* shards, size_t shards_size, void* userdata);
+typedef int (*upsf_session_context_batch_cb_t)(upsf_session_context_t* session_contexts, size_t session_contexts_size, void* userdata);
+typedef int (*upsf_network_connection_batch_cb_t)(upsf_network_connection_t* network_connections, size_t network_connections_size, void* userdata);
+typedef int (*upsf_service_gateway_user_plane_batch_cb_t)(upsf_service_gateway_user_plane_t* service_gateway_user_planes, size_t service_gateway_user_planes_size, void* userdata);
+typedef int (*upsf_traffic_steering_function_batch_cb_t)(upsf_traffic_steering_function_t* traffic_steering_functions, size_t traffic_steering_functions_size, void* userdata);
+typedef int (*upsf_service_gateway_batch_cb_t)(upsf_service_gateway_t* service_gateways, size_t service_gateways_size, void* userdata);
+
+/*
+ * item references: zero-copy access to items held by libupsf
+ *
+ * A reference keeps its item alive until the last upsf_item_ref_release().
+ * Strings returned by accessors point into the item, are '\0' terminated
+ * and remain valid as long as a reference is held, len may be NULL.
+ * Accessors for an item type other than the referenced one return empty
+ * values, accessors *_at() return NULL for an index out of range.
+ */
+typedef struct upsf_item_ref_s upsf_item_ref_t;
+
+/* ref is valid for the duration of the callback, acquire it for retaining */
+typedef int (*upsf_item_ref_cb_t)(upsf_item_ref_t* ref, void* userdata);
+
+/*
+ * endpoint within a referenced item, valid as long as a reference to the
+ * item is held, accessors return empty values for a NULL endpoint
+ */
+typedef struct upsf_endpoint_ref_s upsf_endpoint_ref_t;
+
+/*
+ * list cursors: items are mapped into the caller's buffer chunk by chunk
+ * while they are streamed from the UPSF, a cursor must be closed by the
+ * matching *_end() function, also when not read until its end
+ */
+typedef struct upsf_list_cursor_s upsf_list_cursor_t;
+
+upsf_item_ref_t* upsf_item_ref_acquire(upsf_item_ref_t* ref);
+void upsf_item_ref_release(upsf_item_ref_t* ref);
+
+/* item, UPSF_ITEM_TYPE_MAX for an empty item */
+enum upsf_item_type_t upsf_item_ref_type(const upsf_item_ref_t* ref);
+const char* upsf_item_ref_name(const upsf_item_ref_t* ref, size_t* len);
+const char* upsf_item_ref_description(const upsf_item_ref_t* ref, size_t* len);
+enum upsf_derived_state_t upsf_item_ref_derived_state(const upsf_item_ref_t* ref);
+
+/* service gateway user plane */
+const char* upsf_service_gateway_user_plane_service_gateway_name(const upsf_item_ref_t* ref, size_t* len);
+int upsf_service_gateway_user_plane_max_session_count(const upsf_item_ref_t* ref);
+int upsf_service_gateway_user_plane_max_shards(const upsf_item_ref_t* ref);
+size_t upsf_service_gateway_user_plane_supported_service_group_size(const upsf_item_ref_t* ref);
+const char* upsf_service_gateway_user_plane_supported_service_group_at(const upsf_item_ref_t* ref, size_t i, size_t* len);
+int upsf_service_gateway_user_plane_allocated_session_count(const upsf_item_ref_t* ref);
+int upsf_service_gateway_user_plane_allocated_shards(const upsf_item_ref_t* ref);
+const upsf_endpoint_ref_t* upsf_service_gateway_user_plane_default_endpoint(const upsf_item_ref_t* ref);
+
+/* traffic steering function */
+const upsf_endpoint_ref_t* upsf_traffic_steering_function_default_endpoint(const upsf_item_ref_t* ref);
+
+/* network connection, single endpoint nc_spec types have an endpoint
+ * list of size 1, map entries are iterated by index in unspecified but
+ * stable order, a key not found reads as inactive */
+int upsf_network_connection_maximum_supported_quality(const upsf_item_ref_t* ref);
+enum upsf_nc_spec_type_t upsf_network_connection_nc_spec_type(const upsf_item_ref_t* ref);
+size_t upsf_network_connection_sgup_endpoint_size(const upsf_item_ref_t* ref);
+const upsf_endpoint_ref_t* upsf_network_connection_sgup_endpoint_at(const upsf_item_ref_t* ref, size_t i);
+size_t upsf_network_connection_tsf_endpoint_size(const upsf_item_ref_t* ref);
+const upsf_endpoint_ref_t* upsf_network_connection_tsf_endpoint_at(const upsf_item_ref_t* ref, size_t i);
+size_t upsf_network_connection_nc_active_size(const upsf_item_ref_t* ref);
+const char* upsf_network_connection_nc_active_at(const upsf_item_ref_t* ref, size_t i, size_t* len, int* active);
+int upsf_network_connection_nc_active(const upsf_item_ref_t* ref, const char* key);
+int upsf_network_connection_allocated_shards(const upsf_item_ref_t* ref);
+
+/* endpoint */
+const char* upsf_endpoint_name(const upsf_endpoint_ref_t* ep, size_t* len);
+enum upsf_ep_type_t upsf_endpoint_type(const upsf_endpoint_ref_t* ep);
+const char* upsf_endpoint_vtep_ip_address(const upsf_endpoint_ref_t* ep, size_t* len);
+int upsf_endpoint_vtep_udp_port(const upsf_endpoint_ref_t* ep);
+int upsf_endpoint_vtep_vni(const upsf_endpoint_ref_t* ep);
+int upsf_endpoint_l2vpn_vpn_id(const upsf_endpoint_ref_t* ep);
+const char* upsf_endpoint_port_vlan_logical_port(const upsf_endpoint_ref_t* ep, size_t* len);
+int upsf_endpoint_port_vlan_svlan(const upsf_endpoint_ref_t* ep);
+int upsf_endpoint_port_vlan_cvlan(const upsf_endpoint_ref_t* ep);
+
+/* shard */
+int upsf_shard_max_session_count(const upsf_item_ref_t* ref);
+const char* upsf_shard_virtual_mac(const upsf_item_ref_t* ref, size_t* len);
+const char* upsf_shard_desired_service_gateway_user_plane(const upsf_item_ref_t* ref, size_t* len);
+size_t upsf_shard_desired_network_connection_size(const upsf_item_ref_t* ref);
+const char* upsf_shard_desired_network_connection_at(const upsf_item_ref_t* ref, size_t i, size_t* len);
+size_t upsf_shard_prefix_size(const upsf_item_ref_t* ref);
+const char* upsf_shard_prefix_at(const upsf_item_ref_t* ref, size_t i, size_t* len);
+int upsf_shard_allocated_session_count(const upsf_item_ref_t* ref);
+int upsf_shard_maximum_allocated_quality(const upsf_item_ref_t* ref);
+size_t upsf_shard_service_groups_supported_size(const upsf_item_ref_t* ref);
+const char* upsf_shard_service_groups_supported_at(const upsf_item_ref_t* ref, size_t i, size_t* len);
+const char* upsf_shard_current_service_gateway_user_plane(const upsf_item_ref_t* ref, size_t* len);
+/* tsf_network_connection maps a tsf to a network connection, NULL if not found */
+size_t upsf_shard_current_tsf_network_connection_size(const upsf_item_ref_t* ref);
+const char* upsf_shard_current_tsf_network_connection_at(const upsf_item_ref_t* ref, size_t i, size_t* len, const char** value, size_t* value_len);
+const char* upsf_shard_current_tsf_network_connection(const upsf_item_ref_t* ref, const char* tsf, size_t* len);
+enum upsf_mbb_state_t upsf_shard_mbb_state(const upsf_item_ref_t* ref);
+
+/* session context */
+const char* upsf_session_context_traffic_steering_function(const upsf_item_ref_t* ref, size_t* len);
+size_t upsf_session_context_required_service_group_size(const upsf_item_ref_t* ref);
+const char* upsf_session_context_required_service_group_at(const upsf_item_ref_t* ref, size_t i, size_t* len);
+int upsf_session_context_required_quality(const upsf_item_ref_t* ref);
+const char* upsf_session_context_circuit_id(const upsf_item_ref_t* ref, size_t* len);
+const char* upsf_session_context_remote_id(const upsf_item_ref_t* ref, size_t* len);
+const char* upsf_session_context_source_mac_address(const upsf_item_ref_t* ref, size_t* len);
+int upsf_session_context_svlan(const upsf_item_ref_t* ref);
+int upsf_session_context_cvlan(const upsf_item_ref_t* ref);
+const char* upsf_session_context_desired_shard(const upsf_item_ref_t* ref, size_t* len);
+const char* upsf_session_context_network_connection(const upsf_item_ref_t* ref, size_t* len);
+const char* upsf_session_context_current_user_plane_shard(const upsf_item_ref_t* ref, size_t* len);
+const char* upsf_session_context_current_tsf_shard(const upsf_item_ref_t* ref, size_t* len);
+
 upsf_handle_t upsf_open(
     const char* upsf_host,
     const int upsf_port);
@@ -376,6 +435,16 @@ int upsf_close();
 
 int upsf_exists();
 
+/* number of upsf_get_*() and upsf_lookup() calls of all threads connected to
+ * the same UPSF that shared a concurrent identical call of another thread,
+ * a call issued after a write of any of these threads returned never shares
+ * a call started before, so threads read their own writes; writes by other
+ * processes may still be missed by a shared call like by any read racing
+ * with them */
+int upsf_get_coalesced(
+    uint64_t* reads,
+    uint64_t* lookups);
+
 const char* upsf_derived_state_to_name(int derived_state);
 const char* upsf_item_type_to_name(int item_type);
 const char* upsf_maintenance_req_to_name(int maintenance_req);
@@ -408,6 +477,12 @@ upsf_service_gateway_user_plane_t* upsf_create_service_gateway_user_plane(
 upsf_service_gateway_user_plane_t* upsf_update_service_gateway_user_plane(
     upsf_service_gateway_user_plane_t* service_gateway_user_plane);
 
+/* update if metadata.last_updated equals the one of the current copy,
+ * returns 0 and the updated item, 1 on conflict and the current copy,
+ * -1 on failure */
+int upsf_update_service_gateway_user_plane_if_unchanged(
+    upsf_service_gateway_user_plane_t* service_gateway_user_plane);
+
 upsf_service_gateway_user_plane_t* upsf_get_service_gateway_user_plane(
     upsf_service_gateway_user_plane_t* service_gateway_user_plane);
 
@@ -468,6 +543,12 @@ upsf_shard_t* upsf_create_shard(
 upsf_shard_t* upsf_update_shard(
     upsf_shard_t* shard);
 
+/* update if metadata.last_updated equals the one of the current copy,
+ * returns 0 and the updated item, 1 on conflict and the current copy,
+ * -1 on failure */
+int upsf_update_shard_if_unchanged(
+    upsf_shard_t* shard);
+
 upsf_shard_t* upsf_get_shard(
     upsf_shard_t* shard);
 
@@ -505,6 +586,71 @@ char* upsf_dump_session_context(
 upsf_session_context_t* upsf_lookup(
     upsf_session_context_t* session_context);
 
+/*
+ * lookup cache for upsf_lookup() of all threads: found results are cached
+ * for ttl_ms, not found results for negative_ttl_ms, cached results are
+ * invalidated by changes of the session contexts, shards, user planes and
+ * network connections they depend on, watched on a dedicated stream to
+ * upsf_host:upsf_port, nothing is cached before this stream delivered its
+ * first item and while it is down
+ */
+int upsf_lookup_cache_enable(
+    const char* upsf_host,
+    const int upsf_port,
+    uint32_t ttl_ms,
+    uint32_t negative_ttl_ms);
+
+int upsf_lookup_cache_disable(void);
+
+int upsf_lookup_cache_stats(
+    uint64_t* hits,
+    uint64_t* misses,
+    uint64_t* invalidations);
+
+/*
+ * write-behind for upsf_update_shard() and
+ * upsf_update_service_gateway_user_plane() of all threads: updates equal to
+ * the last state acknowledged by UPSF are dropped, successive updates of
+ * the same item within window_ms are merged and only the latest value is
+ * written on a dedicated connection to upsf_host:upsf_port, the update
+ * functions return the unmodified input item, write_cb (if not NULL) is
+ * called once UPSF has acknowledged (success=1) a write or the write has
+ * finally failed (success=0), writes failing as UPSF is unavailable or
+ * does not answer in time are retried up to 5 times before, other failures
+ * are not retried, upsf_write_behind_flush() writes all pending updates and
+ * returns -1 if any write failed
+ */
+typedef void (*upsf_write_behind_cb_t)(enum upsf_item_type_t item_type, const char* name, int success, void* userdata);
+
+int upsf_write_behind_enable(
+    const char* upsf_host,
+    const int upsf_port,
+    uint32_t window_ms,
+    void* userdata,
+    upsf_write_behind_cb_t write_cb);
+
+int upsf_write_behind_disable(void);
+
+int upsf_write_behind_flush(void);
+
+int upsf_write_behind_stats(
+    uint64_t* updates,
+    uint64_t* dropped,
+    uint64_t* merged,
+    uint64_t* written,
+    uint64_t* failed);
+
+/*
+ * serve upsf_get_*(), upsf_list_*() and upsf_get_item_ref() of all threads
+ * from the shared memory replica name published by an UpsfShmPublisher in
+ * another process on this host: gets not found in the replica and lists
+ * before a first publication are sent to UPSF, no connection to UPSF is
+ * needed for items present in the replica
+ */
+int upsf_shm_attach(const char* name);
+
+int upsf_shm_detach(void);
+
 /* subscribe */
 int upsf_subscribe(
     const char* upsf_host,
@@ -517,6 +663,221 @@ int upsf_subscribe(
     upsf_traffic_steering_function_cb_t upsf_traffic_steering_function_cb,
     upsf_service_gateway_cb_t upsf_service_gateway_cb);
 
+/* subscribe with filter, NULL filter selects item types by non-NULL callbacks */
+int upsf_subscribe_ex(
+    const char* upsf_host,
+    const int upsf_port,
+    void* userdata,
+    const upsf_subscribe_filter_t* filter,
+    upsf_shard_cb_t upsf_shard_cb,
+    upsf_session_context_cb_t upsf_session_context_cb,
+    upsf_network_connection_cb_t upsf_network_connection_cb,
+    upsf_service_gateway_user_plane_cb_t upsf_service_gateway_user_plane_cb,
+    upsf_traffic_steering_function_cb_t upsf_traffic_steering_function_cb,
+    upsf_service_gateway_cb_t upsf_service_gateway_cb);
+
+/* subscribe with batch callbacks, each batch holds up to batch_size items
+ * of a single item type in stream order, 0 selects UPSF_DEFAULT_BATCH_SIZE */
+int upsf_subscribe_batch(
+    const char* upsf_host,
+    const int upsf_port,
+    void* userdata,
+    const upsf_subscribe_filter_t* filter,
+    size_t batch_size,
+    upsf_shard_batch_cb_t upsf_shard_batch_cb,
+    upsf_session_context_batch_cb_t upsf_session_context_batch_cb,
+    upsf_network_connection_batch_cb_t upsf_network_connection_batch_cb,
+    upsf_service_gateway_user_plane_batch_cb_t upsf_service_gateway_user_plane_batch_cb,
+    upsf_traffic_steering_function_batch_cb_t upsf_traffic_steering_function_batch_cb,
+    upsf_service_gateway_batch_cb_t upsf_service_gateway_batch_cb);
+
+/* arena: caller provided buffer */
+void upsf_arena_init(
+    upsf_arena_t* arena,
+    void* buf,
+    size_t size);
+
+/* arena: release all items allocated from arena */
+void upsf_arena_reset(
+    upsf_arena_t* arena);
+
+/*
+ * variable length item API, get returns NULL and list returns -1 if the
+ * item is not found, an error occurs or the arena is exhausted, list
+ * returns the number of items stored in *elems otherwise
+ */
+upsf_var_service_gateway_t* upsf_var_get_service_gateway(
+    upsf_arena_t* arena, const char* name);
+
+int upsf_var_list_service_gateways(
+    upsf_arena_t* arena, upsf_var_service_gateway_t** elems);
+
+upsf_var_service_gateway_user_plane_t* upsf_var_get_service_gateway_user_plane(
+    upsf_arena_t* arena, const char* name);
+
+int upsf_var_list_service_gateway_user_planes(
+    upsf_arena_t* arena, upsf_var_service_gateway_user_plane_t** elems);
+
+upsf_var_traffic_steering_function_t* upsf_var_get_traffic_steering_function(
+    upsf_arena_t* arena, const char* name);
+
+int upsf_var_list_traffic_steering_functions(
+    upsf_arena_t* arena, upsf_var_traffic_steering_function_t** elems);
+
+upsf_var_network_connection_t* upsf_var_get_network_connection(
+    upsf_arena_t* arena, const char* name);
+
+int upsf_var_list_network_connections(
+    upsf_arena_t* arena, upsf_var_network_connection_t** elems);
+
+upsf_var_shard_t* upsf_var_get_shard(
+    upsf_arena_t* arena, const char* name);
+
+int upsf_var_list_shards(
+    upsf_arena_t* arena, upsf_var_shard_t** elems);
+
+upsf_var_session_context_t* upsf_var_get_session_context(
+    upsf_arena_t* arena, const char* name);
+
+int upsf_var_list_session_contexts(
+    upsf_arena_t* arena, upsf_var_session_context_t** elems);
+
+/*
+ * cursor based list API, begin returns NULL on error, next maps up to
+ * n_elems items into elems and returns their number, 0 at the end of the
+ * list or -1 on error, end always closes the cursor and returns -1 if the
+ * list terminated with an error or the cursor lists another item type,
+ * 0 otherwise
+ */
+upsf_list_cursor_t* upsf_list_service_gateways_begin(void);
+
+int upsf_list_service_gateways_next(
+    upsf_list_cursor_t* cursor, upsf_service_gateway_t* elems, size_t n_elems);
+
+int upsf_list_service_gateways_end(
+    upsf_list_cursor_t* cursor);
+
+upsf_list_cursor_t* upsf_list_service_gateway_user_planes_begin(void);
+
+int upsf_list_service_gateway_user_planes_next(
+    upsf_list_cursor_t* cursor, upsf_service_gateway_user_plane_t* elems, size_t n_elems);
+
+int upsf_list_service_gateway_user_planes_end(
+    upsf_list_cursor_t* cursor);
+
+upsf_list_cursor_t* upsf_list_traffic_steering_functions_begin(void);
+
+int upsf_list_traffic_steering_functions_next(
+    upsf_list_cursor_t* cursor, upsf_traffic_steering_function_t* elems, size_t n_elems);
+
+int upsf_list_traffic_steering_functions_end(
+    upsf_list_cursor_t* cursor);
+
+upsf_list_cursor_t* upsf_list_network_connections_begin(void);
+
+int upsf_list_network_connections_next(
+    upsf_list_cursor_t* cursor, upsf_network_connection_t* elems, size_t n_elems);
+
+int upsf_list_network_connections_end(
+    upsf_list_cursor_t* cursor);
+
+upsf_list_cursor_t* upsf_list_shards_begin(void);
+
+int upsf_list_shards_next(
+    upsf_list_cursor_t* cursor, upsf_shard_t* elems, size_t n_elems);
+
+int upsf_list_shards_end(
+    upsf_list_cursor_t* cursor);
+
+upsf_list_cursor_t* upsf_list_session_contexts_begin(void);
+
+int upsf_list_session_contexts_next(
+    upsf_list_cursor_t* cursor, upsf_session_context_t* elems, size_t n_elems);
+
+int upsf_list_session_contexts_end(
+    upsf_list_cursor_t* cursor);
+
+/*
+ * parallel list API, same as upsf_list_*() but mapping overlaps receiving
+ * and is spread across n_workers threads, 0 selects the number of CPUs
+ */
+int upsf_list_service_gateways_parallel(
+    upsf_service_gateway_t* elems, size_t n_elems, size_t n_workers);
+
+int upsf_list_service_gateway_user_planes_parallel(
+    upsf_service_gateway_user_plane_t* elems, size_t n_elems, size_t n_workers);
+
+int upsf_list_traffic_steering_functions_parallel(
+    upsf_traffic_steering_function_t* elems, size_t n_elems, size_t n_workers);
+
+int upsf_list_network_connections_parallel(
+    upsf_network_connection_t* elems, size_t n_elems, size_t n_workers);
+
+int upsf_list_shards_parallel(
+    upsf_shard_t* elems, size_t n_elems, size_t n_workers);
+
+int upsf_list_session_contexts_parallel(
+    upsf_session_context_t* elems, size_t n_elems, size_t n_workers);
+
+/*
+ * count and existence queries, filter selects derived states, parents and
+ * names (item types are implied by the function), NULL or no derived
+ * states match items in all derived states, name NULL matches any name,
+ * count returns the number of items, exists returns 1 if an item matches
+ * and 0 if not, both return -1 on error; answered by an attached shared
+ * memory replica unless filtering by parent
+ */
+int upsf_count_service_gateways(
+    const upsf_subscribe_filter_t* filter);
+
+int upsf_exists_service_gateway(
+    const char* name, const upsf_subscribe_filter_t* filter);
+
+int upsf_count_service_gateway_user_planes(
+    const upsf_subscribe_filter_t* filter);
+
+int upsf_exists_service_gateway_user_plane(
+    const char* name, const upsf_subscribe_filter_t* filter);
+
+int upsf_count_traffic_steering_functions(
+    const upsf_subscribe_filter_t* filter);
+
+int upsf_exists_traffic_steering_function(
+    const char* name, const upsf_subscribe_filter_t* filter);
+
+int upsf_count_network_connections(
+    const upsf_subscribe_filter_t* filter);
+
+int upsf_exists_network_connection(
+    const char* name, const upsf_subscribe_filter_t* filter);
+
+int upsf_count_shards(
+    const upsf_subscribe_filter_t* filter);
+
+int upsf_exists_shard(
+    const char* name, const upsf_subscribe_filter_t* filter);
+
+int upsf_count_session_contexts(
+    const upsf_subscribe_filter_t* filter);
+
+int upsf_exists_session_context(
+    const char* name, const upsf_subscribe_filter_t* filter);
+
+/* get reference to an item by type and name, NULL if not found,
+ * release the reference with upsf_item_ref_release() */
+upsf_item_ref_t* upsf_get_item_ref(
+    enum upsf_item_type_t item_type,
+    const char* name);
+
+/* subscribe with a reference callback for all item types selected by filter,
+ * NULL filter or empty item_types select all item types */
+int upsf_subscribe_ref(
+    const char* upsf_host,
+    const int upsf_port,
+    void* userdata,
+    const upsf_subscribe_filter_t* filter,
+    upsf_item_ref_cb_t upsf_item_ref_cb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,8 @@
 #ifndef UPSF_HPP
 #define UPSF_HPP
 
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <thread>
@@ -47,6 +49,9 @@
 #include <grpcpp/create_channel.h>
 #include <grpcpp/security/credentials.h>
 
+#include "upsf_flight.hpp"
+#include "upsf_item.hpp"
+
 #include "wt474_upsf_messages/v1/messages_v1.grpc.pb.h"
 #include "wt474_upsf_messages/v1/messages_v1.pb.h"
 #include "wt474_upsf_service/v1/service_v1.grpc.pb.h"
@@ -135,7 +140,66 @@ public:
     virtual void notify(
         const wt474_messages::v1::ServiceGateway& service_gateway) {};
 
+    /**
+   * notification for a shared immutable item instance, forwards to the
+   * typed notify methods by default, overwrite for retaining the instance
+   */
+    virtual void notify(
+        const std::shared_ptr<const wt474_messages::v1::Item>& item)
+    {
+        // shard
+        if (item->has_shard()) {
+            notify(item->shard());
+        }
+        // session_context
+        else if (item->has_session_context()) {
+            notify(item->session_context());
+        }
+        // network_connection
+        else if (item->has_network_connection()) {
+            notify(item->network_connection());
+        }
+        // service_gateway_user_plane
+        else if (item->has_service_gateway_user_plane()) {
+            notify(item->service_gateway_user_plane());
+        }
+        // traffic_steering_function
+        else if (item->has_traffic_steering_function()) {
+            notify(item->traffic_steering_function());
+        }
+        // service_gateway
+        else if (item->has_service_gateway()) {
+            notify(item->service_gateway());
+        }
+    };
+
 public:
+    /**
+   * fill ReadReq from subscriber parameters
+   */
+    void get_request(
+        wt474_upsf_service::v1::ReadReq& req) const
+    {
+        /* set item_types */
+        for (auto it : itemtypes) {
+            req.add_itemtype(it);
+        }
+        /* set item_states */
+        for (auto it : derivedstates) {
+            req.add_itemstate(it);
+        }
+        /* set item parents */
+        for (auto it : parents) {
+            req.add_parent()->set_value(it);
+        }
+        /* set item names */
+        for (auto it : names) {
+            req.add_name()->set_value(it);
+        }
+        /* set watch */
+        req.set_watch(watch);
+    };
+
     /**
    *
    */
@@ -167,6 +231,81 @@ public:
     bool watch;
 };
 
+/**
+ * pull style reader for a single ReadV1 stream, items are read one by one
+ * on demand instead of draining the stream into a container
+ */
+class UpsfReader {
+
+public:
+    /**
+   * constructor, opens the stream on its own grpc stub
+   */
+    UpsfReader(
+        std::shared_ptr<grpc::Channel> channel,
+        const wt474_upsf_service::v1::ReadReq& req)
+        : stub_(wt474_upsf_service::v1::upsf::NewStub(channel))
+        , reader(stub_->ReadV1(&context, req))
+        , finished(false)
+        , drained(false) {};
+
+    /**
+   * destructor, cancels a stream not read until its end
+   */
+    virtual ~UpsfReader()
+    {
+        Finish();
+    };
+
+    UpsfReader(const UpsfReader&) = delete;
+    UpsfReader& operator=(const UpsfReader&) = delete;
+
+public:
+    /**
+   * read next item, returns false at the end of the stream
+   */
+    bool Read(
+        wt474_messages::v1::Item& item)
+    {
+        if (drained || finished) {
+            return false;
+        }
+        if (!reader->Read(&item)) {
+            drained = true;
+            return false;
+        }
+        return true;
+    };
+
+    /**
+   * close the stream, returns false if it terminated with an error
+   */
+    bool Finish()
+    {
+        if (finished) {
+            return status.ok() || status.error_code() == grpc::StatusCode::CANCELLED;
+        }
+        if (!drained) {
+            context.TryCancel();
+        }
+        finished = true;
+        status = reader->Finish();
+        if (!status.ok() && status.error_code() != grpc::StatusCode::CANCELLED) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+private:
+    std::unique_ptr<wt474_upsf_service::v1::upsf::Stub> stub_;
+    grpc::ClientContext context;
+    std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader;
+    grpc::Status status;
+    bool finished;
+    bool drained;
+};
+
 class UpsfClient {
 
 public:
@@ -176,7 +315,19 @@ public:
     UpsfClient(
         std::shared_ptr<grpc::Channel> channel)
         : channel(channel)
-        , stub_(wt474_upsf_service::v1::upsf::NewStub(channel)) {};
+        , stub_(wt474_upsf_service::v1::upsf::NewStub(channel))
+        , flights(std::make_shared<UpsfFlights>()) {};
+
+    /**
+   * constructor, concurrent identical reads by name and lookups are
+   * coalesced across all clients sharing flights
+   */
+    UpsfClient(
+        std::shared_ptr<grpc::Channel> channel,
+        std::shared_ptr<UpsfFlights> flights)
+        : channel(channel)
+        , stub_(wt474_upsf_service::v1::upsf::NewStub(channel))
+        , flights(flights) {};
 
     /**
    * destructor
@@ -199,6 +350,7 @@ public:
         grpc::ClientContext context;
         const std::lock_guard<std::mutex> lock(stub_mutex);
         grpc::Status status = stub_->CreateV1(&context, request, &reply);
+        flights->writes++;
         if (!status.ok()) {
             LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
             return false;
@@ -312,11 +464,21 @@ public:
     bool UpdateV1(
         const wt474_upsf_service::v1::UpdateReq& req,
         wt474_messages::v1::Item& resp)
+    {
+        grpc::Status status;
+        return UpdateV1(req, resp, status);
+    };
+
+    bool UpdateV1(
+        const wt474_upsf_service::v1::UpdateReq& req,
+        wt474_messages::v1::Item& resp,
+        grpc::Status& status)
     {
         VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
         grpc::ClientContext context;
         const std::lock_guard<std::mutex> lock(stub_mutex);
-        grpc::Status status = stub_->UpdateV1(&context, req, &resp);
+        status = stub_->UpdateV1(&context, req, &resp);
+        flights->writes++;
         if (!status.ok()) {
             LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
             return false;
@@ -465,6 +627,7 @@ public:
         grpc::ClientContext context;
         const std::lock_guard<std::mutex> lock(stub_mutex);
         grpc::Status status = stub_->DeleteV1(&context, req, &resp);
+        flights->writes++;
         if (!status.ok()) {
             LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
             return false;
@@ -486,6 +649,7 @@ public:
         str_q.set_value(request);
         const std::lock_guard<std::mutex> lock(stub_mutex);
         grpc::Status status = stub_->DeleteV1(&context, str_q, &str_p);
+        flights->writes++;
         if (!status.ok()) {
             LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
             return false;
@@ -504,11 +668,30 @@ public:
     bool LookupV1(
         wt474_messages::v1::SessionContext::Spec& session_context_spec,
         wt474_messages::v1::SessionContext& resp)
+    {
+        grpc::Status status;
+        return LookupV1(session_context_spec, resp, status);
+    };
+
+    /**
+   * rpc LookupV1, status returns the call's status, e.g. NOT_FOUND
+   */
+    bool LookupV1(
+        const wt474_messages::v1::SessionContext::Spec& session_context_spec,
+        wt474_messages::v1::SessionContext& resp,
+        grpc::Status& status)
     {
         VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
-        grpc::ClientContext context;
-        const std::lock_guard<std::mutex> lock(stub_mutex);
-        grpc::Status status = stub_->LookupV1(&context, session_context_spec, &resp);
+        std::string spec;
+        session_context_spec.SerializeToString(&spec);
+
+        /* concurrent identical lookups share a single call, unless started before a write completed */
+        status = flights->lookups.run(flights->key_of(spec), resp,
+            [this, &session_context_spec](wt474_messages::v1::SessionContext& result) {
+                grpc::ClientContext context;
+                const std::lock_guard<std::mutex> lock(stub_mutex);
+                return stub_->LookupV1(&context, session_context_spec, &result);
+            });
         if (!status.ok()) {
             LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
             return false;
@@ -520,41 +703,65 @@ public:
    * ReadV1
    ****************************************/
 
+    /**
+   * rpc ReadV1 (ReadReq) returns (stream Item) for a single item by type and
+   * name, concurrent identical reads share a single call, a read issued
+   * after a write returned never shares a call started before it
+   */
     bool ReadV1(
+        wt474_upsf_service::v1::ItemType itemtype,
         const std::string& name,
-        wt474_messages::v1::ServiceGateway& service_gateway)
+        wt474_messages::v1::Item& item)
     {
         VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
-        wt474_upsf_service::v1::ReadReq req;
-
-        /* set item type */
-        req.add_itemtype(wt474_upsf_service::v1::ItemType::service_gateway);
-
-        /* set parent name */
-        //req.add_parent()->set_value(name);
-        req.add_name()->set_value(name);
+        std::string key(1, char(itemtype));
+        key.append(name);
+
+        /* concurrent identical reads share a single call, unless started before a write completed */
+        grpc::Status status = flights->reads.run(flights->key_of(key), item,
+            [this, itemtype, &name](wt474_messages::v1::Item& result) {
+                wt474_upsf_service::v1::ReadReq req;
+
+                /* set item type */
+                req.add_itemtype(itemtype);
+
+                /* set item name */
+                req.add_name()->set_value(name);
+
+                /* set watch */
+                req.set_watch(false);
+
+                grpc::ClientContext context;
+                const std::lock_guard<std::mutex> lock(stub_mutex);
+                std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(stub_->ReadV1(&context, req));
+                while (reader->Read(&result)) {
+                    if (result.sssitem_case() != wt474_messages::v1::Item::SSSITEM_NOT_SET) {
+                        break;
+                    }
+                }
+                return reader->Finish();
+            });
+        if (!status.ok()) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
+            return false;
+        }
 
-        /* set watch */
-        req.set_watch(false);
+        return true;
+    };
 
-        grpc::ClientContext context;
+    bool ReadV1(
+        const std::string& name,
+        wt474_messages::v1::ServiceGateway& service_gateway)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
         wt474_messages::v1::Item item;
-        const std::lock_guard<std::mutex> lock(stub_mutex);
-        std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(stub_->ReadV1(&context, req));
-        while (reader->Read(&item)) {
-            if (item.has_service_gateway()) {
-                service_gateway = item.service_gateway();
-                break;
-            }
-        }
-        grpc::Status status = reader->Finish();
-        if (!status.ok()) {
-            LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
+        if (!ReadV1(wt474_upsf_service::v1::ItemType::service_gateway, name, item)) {
             return false;
         }
-        if (item.service_gateway().name() != name) {
+        if (!item.has_service_gateway() || item.service_gateway().name() != name) {
             return false;
         }
+        service_gateway = item.service_gateway();
 
         return true;
     };
@@ -564,36 +771,14 @@ public:
         wt474_messages::v1::ServiceGatewayUserPlane& service_gateway_user_plane)
     {
         VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
-        wt474_upsf_service::v1::ReadReq req;
-
-        /* set item type */
-        req.add_itemtype(wt474_upsf_service::v1::ItemType::service_gateway_user_plane);
-
-        /* set parent name */
-        //req.add_parent()->set_value(name);
-        req.add_name()->set_value(name);
-
-        /* set watch */
-        req.set_watch(false);
-
-        grpc::ClientContext context;
         wt474_messages::v1::Item item;
-        const std::lock_guard<std::mutex> lock(stub_mutex);
-        std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(stub_->ReadV1(&context, req));
-        while (reader->Read(&item)) {
-            if (item.has_service_gateway_user_plane()) {
-                service_gateway_user_plane = item.service_gateway_user_plane();
-                break;
-            }
-        }
-        grpc::Status status = reader->Finish();
-        if (!status.ok()) {
-            LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
+        if (!ReadV1(wt474_upsf_service::v1::ItemType::service_gateway_user_plane, name, item)) {
             return false;
         }
-        if (item.service_gateway_user_plane().name() != name) {
+        if (!item.has_service_gateway_user_plane() || item.service_gateway_user_plane().name() != name) {
             return false;
         }
+        service_gateway_user_plane = item.service_gateway_user_plane();
 
         return true;
     };
@@ -603,36 +788,14 @@ public:
         wt474_messages::v1::TrafficSteeringFunction& traffic_steering_function)
     {
         VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
-        wt474_upsf_service::v1::ReadReq req;
-
-        /* set item type */
-        req.add_itemtype(wt474_upsf_service::v1::ItemType::traffic_steering_function);
-
-        /* set parent name */
-        //req.add_parent()->set_value(name);
-        req.add_name()->set_value(name);
-
-        /* set watch */
-        req.set_watch(false);
-
-        grpc::ClientContext context;
         wt474_messages::v1::Item item;
-        const std::lock_guard<std::mutex> lock(stub_mutex);
-        std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(stub_->ReadV1(&context, req));
-        while (reader->Read(&item)) {
-            if (item.has_traffic_steering_function()) {
-                traffic_steering_function = item.traffic_steering_function();
-                break;
-            }
-        }
-        grpc::Status status = reader->Finish();
-        if (!status.ok()) {
-            LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
+        if (!ReadV1(wt474_upsf_service::v1::ItemType::traffic_steering_function, name, item)) {
             return false;
         }
-        if (item.traffic_steering_function().name() != name) {
+        if (!item.has_traffic_steering_function() || item.traffic_steering_function().name() != name) {
             return false;
         }
+        traffic_steering_function = item.traffic_steering_function();
 
         return true;
     };
@@ -642,36 +805,14 @@ public:
         wt474_messages::v1::NetworkConnection& network_connection)
     {
         VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
-        wt474_upsf_service::v1::ReadReq req;
-
-        /* set item type */
-        req.add_itemtype(wt474_upsf_service::v1::ItemType::network_connection);
-
-        /* set parent name */
-        //req.add_parent()->set_value(name);
-        req.add_name()->set_value(name);
-
-        /* set watch */
-        req.set_watch(false);
-
-        grpc::ClientContext context;
         wt474_messages::v1::Item item;
-        const std::lock_guard<std::mutex> lock(stub_mutex);
-        std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(stub_->ReadV1(&context, req));
-        while (reader->Read(&item)) {
-            if (item.has_network_connection()) {
-                network_connection = item.network_connection();
-                break;
-            }
-        }
-        grpc::Status status = reader->Finish();
-        if (!status.ok()) {
-            LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
+        if (!ReadV1(wt474_upsf_service::v1::ItemType::network_connection, name, item)) {
             return false;
         }
-        if (item.network_connection().name() != name) {
+        if (!item.has_network_connection() || item.network_connection().name() != name) {
             return false;
         }
+        network_connection = item.network_connection();
 
         return true;
     };
@@ -681,36 +822,14 @@ public:
         wt474_messages::v1::Shard& shard)
     {
         VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
-        wt474_upsf_service::v1::ReadReq req;
-
-        /* set item type */
-        req.add_itemtype(wt474_upsf_service::v1::ItemType::shard);
-
-        /* set parent name */
-        //req.add_parent()->set_value(name);
-        req.add_name()->set_value(name);
-
-        /* set watch */
-        req.set_watch(false);
-
-        grpc::ClientContext context;
         wt474_messages::v1::Item item;
-        const std::lock_guard<std::mutex> lock(stub_mutex);
-        std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(stub_->ReadV1(&context, req));
-        while (reader->Read(&item)) {
-            if (item.has_shard()) {
-                shard = item.shard();
-                break;
-            }
-        }
-        grpc::Status status = reader->Finish();
-        if (!status.ok()) {
-            LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
+        if (!ReadV1(wt474_upsf_service::v1::ItemType::shard, name, item)) {
             return false;
         }
-        if (item.shard().name() != name) {
+        if (!item.has_shard() || item.shard().name() != name) {
             return false;
         }
+        shard = item.shard();
 
         return true;
     };
@@ -720,36 +839,14 @@ public:
         wt474_messages::v1::SessionContext& session_context)
     {
         VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
-        wt474_upsf_service::v1::ReadReq req;
-
-        /* set item type */
-        req.add_itemtype(wt474_upsf_service::v1::ItemType::session_context);
-
-        /* set parent name */
-        //req.add_parent()->set_value(name);
-        req.add_name()->set_value(name);
-
-        /* set watch */
-        req.set_watch(false);
-
-        grpc::ClientContext context;
         wt474_messages::v1::Item item;
-        const std::lock_guard<std::mutex> lock(stub_mutex);
-        std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(stub_->ReadV1(&context, req));
-        while (reader->Read(&item)) {
-            if (item.has_session_context()) {
-                session_context = item.session_context();
-                break;
-            }
-        }
-        grpc::Status status = reader->Finish();
-        if (!status.ok()) {
-            LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
+        if (!ReadV1(wt474_upsf_service::v1::ItemType::session_context, name, item)) {
             return false;
         }
-        if (item.session_context().name() != name) {
+        if (!item.has_session_context() || item.session_context().name() != name) {
             return false;
         }
+        session_context = item.session_context();
 
         return true;
     };
@@ -940,26 +1037,7 @@ public:
         VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
         wt474_upsf_service::v1::ReadReq req;
 
-        /* set item_types */
-        for (auto it : subscriber.itemtypes) {
-            req.add_itemtype(it);
-        }
-        /* set item_states */
-        for (auto it : subscriber.derivedstates) {
-            req.add_itemstate(it);
-        }
-        /* set item parents */
-        int index = 0;
-        for (auto it : subscriber.parents) {
-            req.mutable_parent(index++)->set_value(it);
-        }
-        /* set item names */
-        int jndex = 0;
-        for (auto it : subscriber.names) {
-            req.mutable_name(jndex++)->set_value(it);
-        }
-        /* set watch */
-        req.set_watch(subscriber.get_watch());
+        subscriber.get_request(req);
 
         std::unique_ptr<wt474_upsf_service::v1::upsf::Stub> subscriber_stub_(wt474_upsf_service::v1::upsf::NewStub(channel));
         grpc::ClientContext context;
@@ -1005,10 +1083,171 @@ public:
         return true;
     };
 
+    /**
+   * rpc ReadV1 (ReadReq) returns (stream Item), every item is read into its
+   * own instance and handed over as shared immutable object, reading stops
+   * when the callback returns false or the context gets cancelled
+   */
+    bool ReadV1(
+        const wt474_upsf_service::v1::ReadReq& req,
+        grpc::ClientContext& context,
+        const std::function<bool(const std::shared_ptr<const wt474_messages::v1::Item>&)>& cb)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        /* create a unique reader grpc stub for this long-lasting operation */
+        std::unique_ptr<wt474_upsf_service::v1::upsf::Stub> reader_stub_(wt474_upsf_service::v1::upsf::NewStub(channel));
+        std::unique_ptr<grpc::ClientReader<wt474_messages::v1::Item>> reader(reader_stub_->ReadV1(&context, req));
+        while (true) {
+            std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+            if (!reader->Read(item.get())) {
+                break;
+            }
+            if (!cb(item)) {
+                context.TryCancel();
+                break;
+            }
+        }
+        grpc::Status status = reader->Finish();
+        if (!status.ok() && status.error_code() != grpc::StatusCode::CANCELLED) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " code:" << status.error_code() << " reason:" << status.error_message() << std::endl;
+            return false;
+        }
+
+        return true;
+    };
+
+    /**
+   * rpc ReadV1 (ReadReq) returns (stream Item), opens the stream for
+   * reading items on demand, see UpsfReader
+   */
+    std::unique_ptr<UpsfReader> NewReader(
+        const wt474_upsf_service::v1::ReadReq& req)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+        return std::unique_ptr<UpsfReader>(new UpsfReader(channel, req));
+    };
+
+    /****************************************
+   * Count, Exists
+   ****************************************/
+
+    /**
+   * count items matching req, items are neither retained nor copied
+   */
+    bool Count(
+        const wt474_upsf_service::v1::ReadReq& req,
+        size_t& count)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+        wt474_upsf_service::v1::ReadReq count_req(req);
+        count_req.set_watch(false);
+
+        UpsfReader reader(channel, count_req);
+        wt474_messages::v1::Item item;
+        count = 0;
+        while (reader.Read(item)) {
+            count++;
+        }
+
+        return reader.Finish();
+    };
+
+    /**
+   * check for an item matching req, the stream is cancelled after the first
+   * matching item, names are verified as for ReadV1 by name
+   */
+    bool Exists(
+        const wt474_upsf_service::v1::ReadReq& req,
+        bool& exists)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+        wt474_upsf_service::v1::ReadReq exists_req(req);
+        exists_req.set_watch(false);
+
+        UpsfReader reader(channel, exists_req);
+        wt474_messages::v1::Item item;
+        exists = false;
+        while (!exists && reader.Read(item)) {
+            exists = (req.name_size() == 0);
+            for (const auto& name : req.name()) {
+                if (item_name(item) == name.value()) {
+                    exists = true;
+                    break;
+                }
+            }
+        }
+
+        return reader.Finish();
+    };
+
+    /**
+   * count items matching req in a local replica, e.g. an UpsfCache::View or
+   * an UpsfShmCache::View, streaming from UPSF only if it cannot answer
+   */
+    template <typename View>
+    bool Count(
+        const wt474_upsf_service::v1::ReadReq& req,
+        size_t& count,
+        const View& view)
+    {
+        return view.count(req, count) || Count(req, count);
+    };
+
+    /**
+   * check for an item matching req in a local replica, streaming from UPSF
+   * only if it cannot answer
+   */
+    template <typename View>
+    bool Exists(
+        const wt474_upsf_service::v1::ReadReq& req,
+        bool& exists,
+        const View& view)
+    {
+        return view.exists(req, exists) || Exists(req, exists);
+    };
+
+    /**
+   * check for an item of type itemtype named name
+   */
+    bool Exists(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name,
+        bool& exists)
+    {
+        wt474_upsf_service::v1::ReadReq req;
+        req.add_itemtype(itemtype);
+        req.add_name()->set_value(name);
+
+        return Exists(req, exists);
+    };
+
+    /****************************************
+   * Statistics
+   ****************************************/
+
+    /**
+   * number of reads by name served by another caller's call
+   */
+    uint64_t get_coalesced_reads() const
+    {
+        return flights->reads.get_coalesced();
+    };
+
+    /**
+   * number of lookups served by another caller's call
+   */
+    uint64_t get_coalesced_lookups() const
+    {
+        return flights->lookups.get_coalesced();
+    };
+
 private:
     std::shared_ptr<grpc::Channel> channel;
     std::unique_ptr<wt474_upsf_service::v1::upsf::Stub> stub_;
     std::mutex stub_mutex;
+    // coalesced calls, possibly shared with other clients
+    std::shared_ptr<UpsfFlights> flights;
 };
 
 } // namespace upsf
@@ -0,0 +1,398 @@
+/* upsf_c_arena.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "upsf_c_arena.hpp"
+
+using namespace upsf;
+
+/******************************************************************
+ * Arena
+ ******************************************************************/
+
+void upsf_arena_init(
+    upsf_arena_t* arena,
+    void* buf,
+    size_t size)
+{
+    if (!arena) {
+        return;
+    }
+    arena->base = static_cast<char*>(buf);
+    arena->size = buf ? size : 0;
+    arena->used = 0;
+}
+
+void upsf_arena_reset(
+    upsf_arena_t* arena)
+{
+    if (!arena) {
+        return;
+    }
+    arena->used = 0;
+}
+
+/******************************************************************
+ * Mapping
+ ******************************************************************/
+
+bool UpsfArenaMapping::map(
+    const std::string& from,
+    upsf_var_string_t& to,
+    upsf_arena_t& arena)
+{
+    /* empty string: no allocation */
+    if (from.empty()) {
+        to.str = "";
+        to.len = 0;
+        return true;
+    }
+
+    char* str = alloc<char>(arena, from.size() + 1);
+    if (!str) {
+        return false;
+    }
+    memcpy(str, from.data(), from.size());
+    to.str = str;
+    to.len = from.size();
+
+    return true;
+}
+
+bool UpsfArenaMapping::map(
+    const google::protobuf::RepeatedPtrField<std::string>& from,
+    upsf_var_string_t*& to,
+    size_t& to_size,
+    upsf_arena_t& arena)
+{
+    to_size = 0;
+    to = alloc<upsf_var_string_t>(arena, from.size());
+    if (!to) {
+        return from.empty();
+    }
+    for (const auto& it : from) {
+        if (!UpsfArenaMapping::map(it, to[to_size++], arena)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool UpsfArenaMapping::map(
+    const google::protobuf::Map<std::string, std::string>& from,
+    upsf_var_key_value_t*& to,
+    size_t& to_size,
+    upsf_arena_t& arena)
+{
+    to_size = 0;
+    to = alloc<upsf_var_key_value_t>(arena, from.size());
+    if (!to) {
+        return from.empty();
+    }
+    for (const auto& it : from) {
+        if (!UpsfArenaMapping::map(it.first, to[to_size].key, arena)) {
+            return false;
+        }
+        if (!UpsfArenaMapping::map(it.second, to[to_size].value, arena)) {
+            return false;
+        }
+        to_size++;
+    }
+
+    return true;
+}
+
+bool UpsfArenaMapping::map(
+    const google::protobuf::Map<std::string, bool>& from,
+    upsf_var_key_value_t*& to,
+    size_t& to_size,
+    upsf_arena_t& arena)
+{
+    to_size = 0;
+    to = alloc<upsf_var_key_value_t>(arena, from.size());
+    if (!to) {
+        return from.empty();
+    }
+    for (const auto& it : from) {
+        if (!UpsfArenaMapping::map(it.first, to[to_size].key, arena)) {
+            return false;
+        }
+        /* same representation as upsf_key_value_t: "1" or "0" */
+        to[to_size].value.str = it.second ? "1" : "0";
+        to[to_size].value.len = 1;
+        to_size++;
+    }
+
+    return true;
+}
+
+bool UpsfArenaMapping::map(
+    const wt474_messages::v1::MetaData& from,
+    upsf_var_metadata_t& to,
+    upsf_arena_t& arena)
+{
+    /* metadata: derived_state */
+    to.derived_state = (upsf_derived_state_t)from.derived_state();
+
+    /* metadata: created */
+    to.created.seconds = from.created().seconds();
+    to.created.nanos = from.created().nanos();
+
+    /* metadata: last_updated */
+    to.last_updated.seconds = from.last_updated().seconds();
+    to.last_updated.nanos = from.last_updated().nanos();
+
+    /* metadata: description */
+    return UpsfArenaMapping::map(from.description(), to.description, arena);
+}
+
+bool UpsfArenaMapping::map(
+    const wt474_messages::v1::NetworkConnection::Spec::Endpoint& from,
+    upsf_var_network_connection_spec_endpoint_t& to,
+    upsf_arena_t& arena)
+{
+    /* endpoint: endpoint_name */
+    if (!UpsfArenaMapping::map(from.endpoint_name(), to.endpoint_name, arena)) {
+        return false;
+    }
+
+    /* endpoint: vtep */
+    if (from.has_vtep()) {
+        to.ep_type = UPSF_EP_TYPE_VTEP;
+        to.ep_spec.vtep.udp_port = from.vtep().udp_port();
+        to.ep_spec.vtep.vni = from.vtep().vni();
+        return UpsfArenaMapping::map(from.vtep().ip_address(), to.ep_spec.vtep.ip_address, arena);
+
+        /* endpoint: l2vpn */
+    } else if (from.has_l2vpn()) {
+        to.ep_type = UPSF_EP_TYPE_L2VPN;
+        to.ep_spec.l2vpn.vpn_id = from.l2vpn().vpn_id();
+
+        /* endpoint: port_vlan */
+    } else if (from.has_port_vlan()) {
+        to.ep_type = UPSF_EP_TYPE_PORT_VLAN;
+        to.ep_spec.port_vlan.svlan = from.port_vlan().svlan();
+        to.ep_spec.port_vlan.cvlan = from.port_vlan().cvlan();
+        return UpsfArenaMapping::map(from.port_vlan().logical_port(), to.ep_spec.port_vlan.logical_port, arena);
+
+        /* endpoint: unknown */
+    } else {
+        to.ep_type = UPSF_EP_TYPE_UNSPECIFIED;
+    }
+
+    return true;
+}
+
+bool UpsfArenaMapping::map(
+    const google::protobuf::RepeatedPtrField<wt474_messages::v1::NetworkConnection::Spec::Endpoint>& from,
+    upsf_var_network_connection_spec_endpoint_t*& to,
+    size_t& to_size,
+    upsf_arena_t& arena)
+{
+    to_size = 0;
+    to = alloc<upsf_var_network_connection_spec_endpoint_t>(arena, from.size());
+    if (!to) {
+        return from.empty();
+    }
+    for (const auto& it : from) {
+        if (!UpsfArenaMapping::map(it, to[to_size++], arena)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool UpsfArenaMapping::map(
+    const wt474_messages::v1::ServiceGateway& from,
+    upsf_var_service_gateway_t& to,
+    upsf_arena_t& arena)
+{
+    /* service_gateway: name, metadata */
+    return UpsfArenaMapping::map(from.name(), to.name, arena)
+        && UpsfArenaMapping::map(from.metadata(), to.metadata, arena);
+}
+
+bool UpsfArenaMapping::map(
+    const wt474_messages::v1::ServiceGatewayUserPlane& from,
+    upsf_var_service_gateway_user_plane_t& to,
+    upsf_arena_t& arena)
+{
+    /* service_gateway_user_plane: maintenance */
+    to.maintenance.maintenance_req = (upsf_maintenance_req_t)from.maintenance().maintenance_req();
+
+    /* service_gateway_user_plane: spec */
+    to.spec.max_session_count = from.spec().max_session_count();
+    to.spec.max_shards = from.spec().max_shards();
+
+    /* service_gateway_user_plane: status */
+    to.status.allocated_session_count = from.status().allocated_session_count();
+    to.status.allocated_shards = from.status().allocated_shards();
+
+    /* service_gateway_user_plane: strings and lists */
+    return UpsfArenaMapping::map(from.name(), to.name, arena)
+        && UpsfArenaMapping::map(from.metadata(), to.metadata, arena)
+        && UpsfArenaMapping::map(from.service_gateway_name(), to.service_gateway_name, arena)
+        && UpsfArenaMapping::map(from.spec().supported_service_group(), to.spec.supported_service_group, to.spec.supported_service_group_size, arena)
+        && UpsfArenaMapping::map(from.spec().default_endpoint(), to.spec.default_endpoint, arena);
+}
+
+bool UpsfArenaMapping::map(
+    const wt474_messages::v1::TrafficSteeringFunction& from,
+    upsf_var_traffic_steering_function_t& to,
+    upsf_arena_t& arena)
+{
+    /* traffic_steering_function: name, metadata, spec */
+    return UpsfArenaMapping::map(from.name(), to.name, arena)
+        && UpsfArenaMapping::map(from.metadata(), to.metadata, arena)
+        && UpsfArenaMapping::map(from.spec().default_endpoint(), to.spec.default_endpoint, arena);
+}
+
+bool UpsfArenaMapping::map(
+    const wt474_messages::v1::NetworkConnection& from,
+    upsf_var_network_connection_t& to,
+    upsf_arena_t& arena)
+{
+    /* network_connection: maintenance */
+    to.maintenance.maintenance_req = (upsf_maintenance_req_t)from.maintenance().maintenance_req();
+
+    /* network_connection: status: allocated_shards */
+    to.status.allocated_shards = from.status().allocated_shards();
+
+    /* network_connection: strings, lists and spec */
+    return UpsfArenaMapping::map(from.name(), to.name, arena)
+        && UpsfArenaMapping::map(from.metadata(), to.metadata, arena)
+        && UpsfArenaMapping::map(from.spec(), to.spec, arena)
+        && UpsfArenaMapping::map(from.status().nc_active(), to.status.nc_active, to.status.nc_active_size, arena);
+}
+
+bool UpsfArenaMapping::map(
+    const wt474_messages::v1::NetworkConnection::Spec& from,
+    upsf_var_network_connection_spec_t& to,
+    upsf_arena_t& arena)
+{
+    /* network_connection: spec: maximum_supported_quality */
+    to.maximum_supported_quality = from.maximum_supported_quality();
+
+    /* network_connection: spec: ss_ptp */
+    if (from.has_ss_ptp()) {
+        to.nc_spec_type = UPSF_NC_SPEC_TYPE_SS_PTP;
+        to.tsf_endpoint_size = 1;
+        to.tsf_endpoint = alloc<upsf_var_network_connection_spec_endpoint_t>(arena, 1);
+        return to.tsf_endpoint
+            && UpsfArenaMapping::map(from.ss_ptp().sgup_endpoint(), to.sgup_endpoint, to.sgup_endpoint_size, arena)
+            && UpsfArenaMapping::map(from.ss_ptp().tsf_endpoint(), to.tsf_endpoint[0], arena);
+
+        /* network_connection: spec: ss_mptp */
+    } else if (from.has_ss_mptpc()) {
+        to.nc_spec_type = UPSF_NC_SPEC_TYPE_SS_MPTP;
+        return UpsfArenaMapping::map(from.ss_mptpc().sgup_endpoint(), to.sgup_endpoint, to.sgup_endpoint_size, arena)
+            && UpsfArenaMapping::map(from.ss_mptpc().tsf_endpoint(), to.tsf_endpoint, to.tsf_endpoint_size, arena);
+
+        /* network_connection: spec: ms_ptp */
+    } else if (from.has_ms_ptp()) {
+        to.nc_spec_type = UPSF_NC_SPEC_TYPE_MS_PTP;
+        to.sgup_endpoint_size = 1;
+        to.sgup_endpoint = alloc<upsf_var_network_connection_spec_endpoint_t>(arena, 1);
+        to.tsf_endpoint_size = 1;
+        to.tsf_endpoint = alloc<upsf_var_network_connection_spec_endpoint_t>(arena, 1);
+        return to.sgup_endpoint && to.tsf_endpoint
+            && UpsfArenaMapping::map(from.ms_ptp().sgup_endpoint(), to.sgup_endpoint[0], arena)
+            && UpsfArenaMapping::map(from.ms_ptp().tsf_endpoint(), to.tsf_endpoint[0], arena);
+
+        /* network_connection: spec: ms_mptp */
+    } else if (from.has_ms_mptp()) {
+        to.nc_spec_type = UPSF_NC_SPEC_TYPE_MS_MPTP;
+        to.sgup_endpoint_size = 1;
+        to.sgup_endpoint = alloc<upsf_var_network_connection_spec_endpoint_t>(arena, 1);
+        return to.sgup_endpoint
+            && UpsfArenaMapping::map(from.ms_mptp().sgup_endpoint(), to.sgup_endpoint[0], arena)
+            && UpsfArenaMapping::map(from.ms_mptp().tsf_endpoint(), to.tsf_endpoint, to.tsf_endpoint_size, arena);
+    }
+
+    return true;
+}
+
+bool UpsfArenaMapping::map(
+    const wt474_messages::v1::Shard& from,
+    upsf_var_shard_t& to,
+    upsf_arena_t& arena)
+{
+    /* shard: spec */
+    to.spec.max_session_count = from.spec().max_session_count();
+
+    /* shard: status */
+    to.status.allocated_session_count = from.status().allocated_session_count();
+    to.status.maximum_allocated_quality = from.status().maximum_allocated_quality();
+
+    /* shard: mbb */
+    to.mbb.mbb_state = (upsf_mbb_state_t)from.mbb().mbb_state();
+
+    /* shard: strings and lists */
+    return UpsfArenaMapping::map(from.name(), to.name, arena)
+        && UpsfArenaMapping::map(from.metadata(), to.metadata, arena)
+        && UpsfArenaMapping::map(from.spec().virtual_mac(), to.spec.virtual_mac, arena)
+        && UpsfArenaMapping::map(from.spec().desired_state().service_gateway_user_plane(), to.spec.desired_state.service_gateway_user_plane, arena)
+        && UpsfArenaMapping::map(from.spec().desired_state().network_connection(), to.spec.desired_state.network_connection, to.spec.desired_state.network_connection_size, arena)
+        && UpsfArenaMapping::map(from.spec().prefix(), to.spec.prefix, to.spec.prefix_size, arena)
+        && UpsfArenaMapping::map(from.status().service_groups_supported(), to.status.service_groups_supported, to.status.service_groups_supported_size, arena)
+        && UpsfArenaMapping::map(from.status().current_state().service_gateway_user_plane(), to.status.current_state.service_gateway_user_plane, arena)
+        && UpsfArenaMapping::map(from.status().current_state().tsf_network_connection(), to.status.current_state.tsf_network_connection, to.status.current_state.tsf_network_connection_size, arena);
+}
+
+bool UpsfArenaMapping::map(
+    const wt474_messages::v1::SessionContext& from,
+    upsf_var_session_context_t& to,
+    upsf_arena_t& arena)
+{
+    /* session_context: spec */
+    to.spec.required_quality = from.spec().required_quality();
+    to.spec.session_filter.svlan = from.spec().session_filter().svlan();
+    to.spec.session_filter.cvlan = from.spec().session_filter().cvlan();
+
+    /* session_context: strings and lists */
+    return UpsfArenaMapping::map(from.name(), to.name, arena)
+        && UpsfArenaMapping::map(from.metadata(), to.metadata, arena)
+        && UpsfArenaMapping::map(from.spec().traffic_steering_function(), to.spec.traffic_steering_function, arena)
+        && UpsfArenaMapping::map(from.spec().required_service_group(), to.spec.required_service_group, to.spec.required_service_group_size, arena)
+        && UpsfArenaMapping::map(from.spec().circuit_id(), to.spec.circuit_id, arena)
+        && UpsfArenaMapping::map(from.spec().remote_id(), to.spec.remote_id, arena)
+        && UpsfArenaMapping::map(from.spec().session_filter().source_mac_address(), to.spec.session_filter.source_mac_address, arena)
+        && UpsfArenaMapping::map(from.spec().desired_state().shard(), to.spec.desired_shard, arena)
+        && UpsfArenaMapping::map(from.spec().network_connection(), to.spec.network_connection, arena)
+        && UpsfArenaMapping::map(from.status().current_state().user_plane_shard(), to.status.current_user_plane_shard, arena)
+        && UpsfArenaMapping::map(from.status().current_state().tsf_shard(), to.status.current_tsf_shard, arena);
+}
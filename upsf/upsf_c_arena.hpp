@@ -0,0 +1,163 @@
+/* upsf_c_arena.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_ARENA_HPP
+#define UPSF_ARENA_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "upsf.h"
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+namespace upsf {
+
+class UpsfArenaMapping {
+public:
+    /* arena: n zeroed entries, nullptr if n is 0 or the arena is exhausted */
+    template <typename T>
+    static T* alloc(
+        upsf_arena_t& arena,
+        size_t n)
+    {
+        if (n == 0) {
+            return nullptr;
+        }
+        uintptr_t start = reinterpret_cast<uintptr_t>(arena.base);
+        uintptr_t addr = (start + arena.used + alignof(T) - 1) & ~(uintptr_t)(alignof(T) - 1);
+        size_t used = (addr - start) + n * sizeof(T);
+        if (used > arena.size) {
+            return nullptr;
+        }
+        arena.used = used;
+        memset(reinterpret_cast<void*>(addr), 0, n * sizeof(T));
+        return reinterpret_cast<T*>(addr);
+    };
+
+    /* string */
+    static bool map(
+        const std::string& from,
+        upsf_var_string_t& to,
+        upsf_arena_t& arena);
+
+    /* repeated string */
+    static bool map(
+        const google::protobuf::RepeatedPtrField<std::string>& from,
+        upsf_var_string_t*& to,
+        size_t& to_size,
+        upsf_arena_t& arena);
+
+    /* map<string, string> */
+    static bool map(
+        const google::protobuf::Map<std::string, std::string>& from,
+        upsf_var_key_value_t*& to,
+        size_t& to_size,
+        upsf_arena_t& arena);
+
+    /* map<string, bool> */
+    static bool map(
+        const google::protobuf::Map<std::string, bool>& from,
+        upsf_var_key_value_t*& to,
+        size_t& to_size,
+        upsf_arena_t& arena);
+
+    /* metadata */
+    static bool map(
+        const wt474_messages::v1::MetaData& from,
+        upsf_var_metadata_t& to,
+        upsf_arena_t& arena);
+
+    /* network_connection: spec: endpoint */
+    static bool map(
+        const wt474_messages::v1::NetworkConnection::Spec::Endpoint& from,
+        upsf_var_network_connection_spec_endpoint_t& to,
+        upsf_arena_t& arena);
+
+    /* network_connection: spec: repeated endpoint */
+    static bool map(
+        const google::protobuf::RepeatedPtrField<wt474_messages::v1::NetworkConnection::Spec::Endpoint>& from,
+        upsf_var_network_connection_spec_endpoint_t*& to,
+        size_t& to_size,
+        upsf_arena_t& arena);
+
+    /* service gateway */
+    static bool map(
+        const wt474_messages::v1::ServiceGateway& from,
+        upsf_var_service_gateway_t& to,
+        upsf_arena_t& arena);
+
+    /* service gateway user plane */
+    static bool map(
+        const wt474_messages::v1::ServiceGatewayUserPlane& from,
+        upsf_var_service_gateway_user_plane_t& to,
+        upsf_arena_t& arena);
+
+    /* traffic_steering_function */
+    static bool map(
+        const wt474_messages::v1::TrafficSteeringFunction& from,
+        upsf_var_traffic_steering_function_t& to,
+        upsf_arena_t& arena);
+
+    /* network_connection */
+    static bool map(
+        const wt474_messages::v1::NetworkConnection& from,
+        upsf_var_network_connection_t& to,
+        upsf_arena_t& arena);
+
+    /* network_connection: spec */
+    static bool map(
+        const wt474_messages::v1::NetworkConnection::Spec& from,
+        upsf_var_network_connection_spec_t& to,
+        upsf_arena_t& arena);
+
+    /* shard */
+    static bool map(
+        const wt474_messages::v1::Shard& from,
+        upsf_var_shard_t& to,
+        upsf_arena_t& arena);
+
+    /* session_context */
+    static bool map(
+        const wt474_messages::v1::SessionContext& from,
+        upsf_var_session_context_t& to,
+        upsf_arena_t& arena);
+};
+
+}; // end namespace upsf
+
+#endif
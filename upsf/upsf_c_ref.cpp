@@ -0,0 +1,567 @@
+/* upsf_c_ref.cpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "upsf.h"
+#include "upsf_c_ref.hpp"
+#include "upsf_item.hpp"
+
+#include <iterator>
+
+/**
+ * referenced item, default instance for a NULL reference
+ */
+static const wt474_messages::v1::Item& ref_item(
+    const upsf_item_ref_t* ref)
+{
+    if (!ref) {
+        return wt474_messages::v1::Item::default_instance();
+    }
+    return *ref->item;
+}
+
+/**
+ * pointer into string storage, length optional
+ */
+static const char* ref_string(
+    const std::string& s,
+    size_t* len)
+{
+    if (len) {
+        *len = s.size();
+    }
+    return s.c_str();
+}
+
+/**
+ * pointer into repeated string storage, NULL if out of range
+ */
+static const char* ref_string_at(
+    const google::protobuf::RepeatedPtrField<std::string>& strings,
+    size_t i,
+    size_t* len)
+{
+    if (i >= (size_t)strings.size()) {
+        if (len) {
+            *len = 0;
+        }
+        return nullptr;
+    }
+    return ref_string(strings.Get(i), len);
+}
+
+/**
+ * endpoint behind an opaque endpoint reference, default instance for NULL
+ */
+static const wt474_messages::v1::NetworkConnection::Spec::Endpoint& ref_endpoint(
+    const upsf_endpoint_ref_t* ep)
+{
+    if (!ep) {
+        return wt474_messages::v1::NetworkConnection::Spec::Endpoint::default_instance();
+    }
+    return *reinterpret_cast<const wt474_messages::v1::NetworkConnection::Spec::Endpoint*>(ep);
+}
+
+/**
+ * opaque reference to an endpoint held by a referenced item
+ */
+static const upsf_endpoint_ref_t* endpoint_ref(
+    const wt474_messages::v1::NetworkConnection::Spec::Endpoint& ep)
+{
+    return reinterpret_cast<const upsf_endpoint_ref_t*>(&ep);
+}
+
+/**
+ * iterator to the i-th map entry, end() if out of range
+ */
+template <typename T>
+static typename google::protobuf::Map<std::string, T>::const_iterator ref_map_at(
+    const google::protobuf::Map<std::string, T>& map,
+    size_t i)
+{
+    if (i >= map.size()) {
+        return map.end();
+    }
+    return std::next(map.begin(), i);
+}
+
+/******************************************************************
+ * References
+ ******************************************************************/
+
+upsf_item_ref_t* upsf_item_ref_acquire(upsf_item_ref_t* ref)
+{
+    if (ref) {
+        ref->refcnt.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ref;
+}
+
+void upsf_item_ref_release(upsf_item_ref_t* ref)
+{
+    if (ref && (ref->refcnt.fetch_sub(1, std::memory_order_acq_rel) == 1)) {
+        delete ref;
+    }
+}
+
+enum upsf_item_type_t upsf_item_ref_type(const upsf_item_ref_t* ref)
+{
+    wt474_upsf_service::v1::ItemType itemtype;
+    if (!upsf::item_type(ref_item(ref), itemtype)) {
+        return UPSF_ITEM_TYPE_MAX;
+    }
+    return (upsf_item_type_t)itemtype;
+}
+
+const char* upsf_item_ref_name(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(upsf::item_name(ref_item(ref)), len);
+}
+
+const char* upsf_item_ref_description(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(upsf::item_metadata(ref_item(ref)).description(), len);
+}
+
+enum upsf_derived_state_t upsf_item_ref_derived_state(const upsf_item_ref_t* ref)
+{
+    return (upsf_derived_state_t)upsf::item_metadata(ref_item(ref)).derived_state();
+}
+
+/******************************************************************
+ * Service gateway user plane
+ ******************************************************************/
+
+const char* upsf_service_gateway_user_plane_service_gateway_name(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).service_gateway_user_plane().service_gateway_name(), len);
+}
+
+int upsf_service_gateway_user_plane_max_session_count(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).service_gateway_user_plane().spec().max_session_count();
+}
+
+int upsf_service_gateway_user_plane_max_shards(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).service_gateway_user_plane().spec().max_shards();
+}
+
+size_t upsf_service_gateway_user_plane_supported_service_group_size(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).service_gateway_user_plane().spec().supported_service_group_size();
+}
+
+const char* upsf_service_gateway_user_plane_supported_service_group_at(const upsf_item_ref_t* ref, size_t i, size_t* len)
+{
+    return ref_string_at(ref_item(ref).service_gateway_user_plane().spec().supported_service_group(), i, len);
+}
+
+int upsf_service_gateway_user_plane_allocated_session_count(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).service_gateway_user_plane().status().allocated_session_count();
+}
+
+int upsf_service_gateway_user_plane_allocated_shards(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).service_gateway_user_plane().status().allocated_shards();
+}
+
+const upsf_endpoint_ref_t* upsf_service_gateway_user_plane_default_endpoint(const upsf_item_ref_t* ref)
+{
+    return endpoint_ref(ref_item(ref).service_gateway_user_plane().spec().default_endpoint());
+}
+
+/******************************************************************
+ * Traffic steering function
+ ******************************************************************/
+
+const upsf_endpoint_ref_t* upsf_traffic_steering_function_default_endpoint(const upsf_item_ref_t* ref)
+{
+    return endpoint_ref(ref_item(ref).traffic_steering_function().spec().default_endpoint());
+}
+
+/******************************************************************
+ * Network connection
+ ******************************************************************/
+
+int upsf_network_connection_maximum_supported_quality(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).network_connection().spec().maximum_supported_quality();
+}
+
+enum upsf_nc_spec_type_t upsf_network_connection_nc_spec_type(const upsf_item_ref_t* ref)
+{
+    const wt474_messages::v1::NetworkConnection::Spec& spec = ref_item(ref).network_connection().spec();
+    switch (spec.nc_spec_case()) {
+    case wt474_messages::v1::NetworkConnection::Spec::kSsPtp:
+        return UPSF_NC_SPEC_TYPE_SS_PTP;
+    case wt474_messages::v1::NetworkConnection::Spec::kSsMptpc:
+        return UPSF_NC_SPEC_TYPE_SS_MPTP;
+    case wt474_messages::v1::NetworkConnection::Spec::kMsPtp:
+        return UPSF_NC_SPEC_TYPE_MS_PTP;
+    case wt474_messages::v1::NetworkConnection::Spec::kMsMptp:
+        return UPSF_NC_SPEC_TYPE_MS_MPTP;
+    default:
+        return UPSF_NC_SPEC_TYPE_MAX;
+    }
+}
+
+size_t upsf_network_connection_sgup_endpoint_size(const upsf_item_ref_t* ref)
+{
+    const wt474_messages::v1::NetworkConnection::Spec& spec = ref_item(ref).network_connection().spec();
+    if (spec.has_ss_ptp()) {
+        return spec.ss_ptp().sgup_endpoint_size();
+    } else if (spec.has_ss_mptpc()) {
+        return spec.ss_mptpc().sgup_endpoint_size();
+    } else if (spec.has_ms_ptp() || spec.has_ms_mptp()) {
+        return 1;
+    }
+    return 0;
+}
+
+const upsf_endpoint_ref_t* upsf_network_connection_sgup_endpoint_at(const upsf_item_ref_t* ref, size_t i)
+{
+    const wt474_messages::v1::NetworkConnection::Spec& spec = ref_item(ref).network_connection().spec();
+    if (i >= upsf_network_connection_sgup_endpoint_size(ref)) {
+        return nullptr;
+    } else if (spec.has_ss_ptp()) {
+        return endpoint_ref(spec.ss_ptp().sgup_endpoint(i));
+    } else if (spec.has_ss_mptpc()) {
+        return endpoint_ref(spec.ss_mptpc().sgup_endpoint(i));
+    } else if (spec.has_ms_ptp()) {
+        return endpoint_ref(spec.ms_ptp().sgup_endpoint());
+    }
+    return endpoint_ref(spec.ms_mptp().sgup_endpoint());
+}
+
+size_t upsf_network_connection_tsf_endpoint_size(const upsf_item_ref_t* ref)
+{
+    const wt474_messages::v1::NetworkConnection::Spec& spec = ref_item(ref).network_connection().spec();
+    if (spec.has_ss_mptpc()) {
+        return spec.ss_mptpc().tsf_endpoint_size();
+    } else if (spec.has_ms_mptp()) {
+        return spec.ms_mptp().tsf_endpoint_size();
+    } else if (spec.has_ss_ptp() || spec.has_ms_ptp()) {
+        return 1;
+    }
+    return 0;
+}
+
+const upsf_endpoint_ref_t* upsf_network_connection_tsf_endpoint_at(const upsf_item_ref_t* ref, size_t i)
+{
+    const wt474_messages::v1::NetworkConnection::Spec& spec = ref_item(ref).network_connection().spec();
+    if (i >= upsf_network_connection_tsf_endpoint_size(ref)) {
+        return nullptr;
+    } else if (spec.has_ss_mptpc()) {
+        return endpoint_ref(spec.ss_mptpc().tsf_endpoint(i));
+    } else if (spec.has_ms_mptp()) {
+        return endpoint_ref(spec.ms_mptp().tsf_endpoint(i));
+    } else if (spec.has_ss_ptp()) {
+        return endpoint_ref(spec.ss_ptp().tsf_endpoint());
+    }
+    return endpoint_ref(spec.ms_ptp().tsf_endpoint());
+}
+
+size_t upsf_network_connection_nc_active_size(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).network_connection().status().nc_active_size();
+}
+
+const char* upsf_network_connection_nc_active_at(const upsf_item_ref_t* ref, size_t i, size_t* len, int* active)
+{
+    const auto& nc_active = ref_item(ref).network_connection().status().nc_active();
+    auto it = ref_map_at(nc_active, i);
+    if (it == nc_active.end()) {
+        if (len) {
+            *len = 0;
+        }
+        if (active) {
+            *active = 0;
+        }
+        return nullptr;
+    }
+    if (active) {
+        *active = it->second ? 1 : 0;
+    }
+    return ref_string(it->first, len);
+}
+
+int upsf_network_connection_nc_active(const upsf_item_ref_t* ref, const char* key)
+{
+    const auto& nc_active = ref_item(ref).network_connection().status().nc_active();
+    auto it = key ? nc_active.find(key) : nc_active.end();
+    return (it != nc_active.end() && it->second) ? 1 : 0;
+}
+
+int upsf_network_connection_allocated_shards(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).network_connection().status().allocated_shards();
+}
+
+/******************************************************************
+ * Endpoint
+ ******************************************************************/
+
+const char* upsf_endpoint_name(const upsf_endpoint_ref_t* ep, size_t* len)
+{
+    return ref_string(ref_endpoint(ep).endpoint_name(), len);
+}
+
+enum upsf_ep_type_t upsf_endpoint_type(const upsf_endpoint_ref_t* ep)
+{
+    const wt474_messages::v1::NetworkConnection::Spec::Endpoint& endpoint = ref_endpoint(ep);
+    if (endpoint.has_vtep()) {
+        return UPSF_EP_TYPE_VTEP;
+    } else if (endpoint.has_l2vpn()) {
+        return UPSF_EP_TYPE_L2VPN;
+    } else if (endpoint.has_port_vlan()) {
+        return UPSF_EP_TYPE_PORT_VLAN;
+    }
+    return UPSF_EP_TYPE_UNSPECIFIED;
+}
+
+const char* upsf_endpoint_vtep_ip_address(const upsf_endpoint_ref_t* ep, size_t* len)
+{
+    return ref_string(ref_endpoint(ep).vtep().ip_address(), len);
+}
+
+int upsf_endpoint_vtep_udp_port(const upsf_endpoint_ref_t* ep)
+{
+    return ref_endpoint(ep).vtep().udp_port();
+}
+
+int upsf_endpoint_vtep_vni(const upsf_endpoint_ref_t* ep)
+{
+    return ref_endpoint(ep).vtep().vni();
+}
+
+int upsf_endpoint_l2vpn_vpn_id(const upsf_endpoint_ref_t* ep)
+{
+    return ref_endpoint(ep).l2vpn().vpn_id();
+}
+
+const char* upsf_endpoint_port_vlan_logical_port(const upsf_endpoint_ref_t* ep, size_t* len)
+{
+    return ref_string(ref_endpoint(ep).port_vlan().logical_port(), len);
+}
+
+int upsf_endpoint_port_vlan_svlan(const upsf_endpoint_ref_t* ep)
+{
+    return ref_endpoint(ep).port_vlan().svlan();
+}
+
+int upsf_endpoint_port_vlan_cvlan(const upsf_endpoint_ref_t* ep)
+{
+    return ref_endpoint(ep).port_vlan().cvlan();
+}
+
+/******************************************************************
+ * Shard
+ ******************************************************************/
+
+int upsf_shard_max_session_count(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).shard().spec().max_session_count();
+}
+
+const char* upsf_shard_virtual_mac(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).shard().spec().virtual_mac(), len);
+}
+
+const char* upsf_shard_desired_service_gateway_user_plane(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).shard().spec().desired_state().service_gateway_user_plane(), len);
+}
+
+size_t upsf_shard_desired_network_connection_size(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).shard().spec().desired_state().network_connection_size();
+}
+
+const char* upsf_shard_desired_network_connection_at(const upsf_item_ref_t* ref, size_t i, size_t* len)
+{
+    return ref_string_at(ref_item(ref).shard().spec().desired_state().network_connection(), i, len);
+}
+
+size_t upsf_shard_prefix_size(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).shard().spec().prefix_size();
+}
+
+const char* upsf_shard_prefix_at(const upsf_item_ref_t* ref, size_t i, size_t* len)
+{
+    return ref_string_at(ref_item(ref).shard().spec().prefix(), i, len);
+}
+
+int upsf_shard_allocated_session_count(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).shard().status().allocated_session_count();
+}
+
+int upsf_shard_maximum_allocated_quality(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).shard().status().maximum_allocated_quality();
+}
+
+size_t upsf_shard_service_groups_supported_size(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).shard().status().service_groups_supported_size();
+}
+
+const char* upsf_shard_service_groups_supported_at(const upsf_item_ref_t* ref, size_t i, size_t* len)
+{
+    return ref_string_at(ref_item(ref).shard().status().service_groups_supported(), i, len);
+}
+
+const char* upsf_shard_current_service_gateway_user_plane(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).shard().status().current_state().service_gateway_user_plane(), len);
+}
+
+size_t upsf_shard_current_tsf_network_connection_size(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).shard().status().current_state().tsf_network_connection_size();
+}
+
+const char* upsf_shard_current_tsf_network_connection_at(const upsf_item_ref_t* ref, size_t i, size_t* len, const char** value, size_t* value_len)
+{
+    const auto& tsf_network_connection = ref_item(ref).shard().status().current_state().tsf_network_connection();
+    auto it = ref_map_at(tsf_network_connection, i);
+    if (it == tsf_network_connection.end()) {
+        if (len) {
+            *len = 0;
+        }
+        if (value) {
+            *value = nullptr;
+        }
+        if (value_len) {
+            *value_len = 0;
+        }
+        return nullptr;
+    }
+    if (value) {
+        *value = ref_string(it->second, value_len);
+    }
+    return ref_string(it->first, len);
+}
+
+const char* upsf_shard_current_tsf_network_connection(const upsf_item_ref_t* ref, const char* tsf, size_t* len)
+{
+    const auto& tsf_network_connection = ref_item(ref).shard().status().current_state().tsf_network_connection();
+    auto it = tsf ? tsf_network_connection.find(tsf) : tsf_network_connection.end();
+    if (it == tsf_network_connection.end()) {
+        if (len) {
+            *len = 0;
+        }
+        return nullptr;
+    }
+    return ref_string(it->second, len);
+}
+
+enum upsf_mbb_state_t upsf_shard_mbb_state(const upsf_item_ref_t* ref)
+{
+    return (upsf_mbb_state_t)ref_item(ref).shard().mbb().mbb_state();
+}
+
+/******************************************************************
+ * Session context
+ ******************************************************************/
+
+const char* upsf_session_context_traffic_steering_function(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).session_context().spec().traffic_steering_function(), len);
+}
+
+size_t upsf_session_context_required_service_group_size(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).session_context().spec().required_service_group_size();
+}
+
+const char* upsf_session_context_required_service_group_at(const upsf_item_ref_t* ref, size_t i, size_t* len)
+{
+    return ref_string_at(ref_item(ref).session_context().spec().required_service_group(), i, len);
+}
+
+int upsf_session_context_required_quality(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).session_context().spec().required_quality();
+}
+
+const char* upsf_session_context_circuit_id(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).session_context().spec().circuit_id(), len);
+}
+
+const char* upsf_session_context_remote_id(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).session_context().spec().remote_id(), len);
+}
+
+const char* upsf_session_context_source_mac_address(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).session_context().spec().session_filter().source_mac_address(), len);
+}
+
+int upsf_session_context_svlan(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).session_context().spec().session_filter().svlan();
+}
+
+int upsf_session_context_cvlan(const upsf_item_ref_t* ref)
+{
+    return ref_item(ref).session_context().spec().session_filter().cvlan();
+}
+
+const char* upsf_session_context_desired_shard(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).session_context().spec().desired_state().shard(), len);
+}
+
+const char* upsf_session_context_network_connection(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).session_context().spec().network_connection(), len);
+}
+
+const char* upsf_session_context_current_user_plane_shard(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).session_context().status().current_state().user_plane_shard(), len);
+}
+
+const char* upsf_session_context_current_tsf_shard(const upsf_item_ref_t* ref, size_t* len)
+{
+    return ref_string(ref_item(ref).session_context().status().current_state().tsf_shard(), len);
+}
@@ -35,10 +35,24 @@
 
 #include "upsf.h"
 #include "upsf.hpp"
+#include "upsf_c_arena.hpp"
 #include "upsf_c_mapping.hpp"
+#include "upsf_c_ref.hpp"
+#include "upsf_cas.hpp"
+#include "upsf_hub.hpp"
+#include "upsf_item.hpp"
+#include "upsf_lookup.hpp"
+#include "upsf_shm.hpp"
 #include "upsf_stream.hpp"
+#include "upsf_writer.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <new>
 #include <shared_mutex>
 #include <stdlib.h>
 #include <string>
@@ -46,6 +60,91 @@
 
 #include <sstream>
 
+/* delivery queue depth of batch subscribers in units of batch size */
+#define UPSF_BATCH_QUEUE_DEPTH 4
+
+/* alignment of subscriber output buffers */
+#define UPSF_CACHE_LINE_SIZE 64
+
+/* number of items mapped by a worker at once for parallel lists */
+#define UPSF_LIST_CHUNK_SIZE 256
+
+/* parallel list queue depth in chunks per worker */
+#define UPSF_LIST_QUEUE_DEPTH 2
+
+/**
+ * cache line aligned, zero initialized array of mapping output buffers,
+ * reused across notifications by mapping with reset=false
+ */
+template <typename T>
+class UpsfBuffer final {
+public:
+    UpsfBuffer()
+        : items(nullptr) {};
+
+    UpsfBuffer(const UpsfBuffer&) = delete;
+    UpsfBuffer& operator=(const UpsfBuffer&) = delete;
+
+    ~UpsfBuffer()
+    {
+        free(items);
+    };
+
+    void resize(size_t n)
+    {
+        free(items);
+        items = nullptr;
+        if (n == 0) {
+            return;
+        }
+        size_t len = ((n * sizeof(T) + UPSF_CACHE_LINE_SIZE - 1) / UPSF_CACHE_LINE_SIZE) * UPSF_CACHE_LINE_SIZE;
+        items = static_cast<T*>(aligned_alloc(UPSF_CACHE_LINE_SIZE, len));
+        if (items == nullptr) {
+            throw std::bad_alloc();
+        }
+        memset(items, 0, len);
+    };
+
+    T* data()
+    {
+        return items;
+    };
+
+    T& operator[](size_t i)
+    {
+        return items[i];
+    };
+
+private:
+    T* items;
+};
+
+/**
+ * coalesced calls shared by all slots connected to the same UPSF address
+ */
+static std::shared_ptr<upsf::UpsfFlights> upsf_flights(const std::string& upsf_addr)
+{
+    static std::mutex flights_mutex;
+    static std::map<std::string, std::weak_ptr<upsf::UpsfFlights>> flights;
+
+    std::scoped_lock lock(flights_mutex);
+    std::shared_ptr<upsf::UpsfFlights> result = flights[upsf_addr].lock();
+    if (!result) {
+        result = std::make_shared<upsf::UpsfFlights>();
+        flights[upsf_addr] = result;
+    }
+    return result;
+}
+
+/**
+ * compare-and-set updates of all slots are serialized by item name
+ */
+static std::shared_ptr<upsf::UpsfCompareAndSet::Stripes> upsf_cas_stripes()
+{
+    static std::shared_ptr<upsf::UpsfCompareAndSet::Stripes> stripes = std::make_shared<upsf::UpsfCompareAndSet::Stripes>();
+    return stripes;
+}
+
 class UpsfSlot final {
 public:
     UpsfSlot(const std::string& upsf_addr)
@@ -54,7 +153,9 @@ public:
               new upsf::UpsfClient(
                   grpc::CreateChannel(
                       upsf_addr,
-                      grpc::InsecureChannelCredentials()))))
+                      grpc::InsecureChannelCredentials()),
+                  upsf_flights(upsf_addr))))
+        , cas(*client, nullptr, upsf_cas_stripes())
     {
     }
 
@@ -67,9 +168,57 @@ public:
 
     std::string upsf_addr;
     std::unique_ptr<upsf::UpsfClient> client;
+    upsf::UpsfCompareAndSet cas;
     std::shared_mutex upsf_slot_mutex;
 };
 
+/**
+ * map subscribe filter onto subscriber's ReadReq parameters
+ */
+static void upsf_set_subscribe_filter(
+    upsf::UpsfSubscriber& subscriber,
+    const upsf_subscribe_filter_t* filter,
+    const std::vector<wt474_upsf_service::v1::ItemType>& cb_itemtypes)
+{
+    /* item types: explicit list or derived from non-NULL callbacks */
+    subscriber.itemtypes.clear();
+    if (filter && filter->item_types_size > 0) {
+        size_t n = std::min(filter->item_types_size, size_t(UPSF_ITEM_TYPE_MAX));
+        for (size_t i = 0; i < n; i++) {
+            subscriber.itemtypes.push_back(wt474_upsf_service::v1::ItemType(filter->item_types[i]));
+        }
+    } else {
+        subscriber.itemtypes = cb_itemtypes;
+    }
+
+    if (!filter) {
+        return;
+    }
+
+    /* derived states: keep defaults unless specified */
+    if (filter->derived_states_size > 0) {
+        subscriber.derivedstates.clear();
+        size_t n = std::min(filter->derived_states_size, size_t(UPSF_DERIVED_STATE_MAX));
+        for (size_t i = 0; i < n; i++) {
+            subscriber.derivedstates.push_back(wt474_messages::v1::DerivedState(filter->derived_states[i]));
+        }
+    }
+
+    /* item parents */
+    subscriber.parents.clear();
+    size_t n_parents = std::min(filter->parents_size, size_t(UPSF_MAX_NUM_SUBSCRIBE_PARENTS));
+    for (size_t i = 0; i < n_parents; i++) {
+        subscriber.parents.push_back(std::string(filter->parents[i].str));
+    }
+
+    /* item names */
+    subscriber.names.clear();
+    size_t n_names = std::min(filter->names_size, size_t(UPSF_MAX_NUM_SUBSCRIBE_NAMES));
+    for (size_t i = 0; i < n_names; i++) {
+        subscriber.names.push_back(std::string(filter->names[i].str));
+    }
+}
+
 class UpsfSubscriberWrapper : public upsf::UpsfSubscriber {
 public:
     UpsfSubscriberWrapper(
@@ -87,20 +236,71 @@ public:
         , network_connection_cb(network_connection_cb)
         , service_gateway_user_plane_cb(service_gateway_user_plane_cb)
         , traffic_steering_function_cb(traffic_steering_function_cb)
-        , service_gateway_cb(service_gateway_cb) {};
+        , service_gateway_cb(service_gateway_cb)
+    {
+        /* output buffers for non-NULL callbacks, reused across notifications */
+        shard_buf.resize(shard_cb ? 1 : 0);
+        session_context_buf.resize(session_context_cb ? 1 : 0);
+        network_connection_buf.resize(network_connection_cb ? 1 : 0);
+        service_gateway_user_plane_buf.resize(service_gateway_user_plane_cb ? 1 : 0);
+        traffic_steering_function_buf.resize(traffic_steering_function_cb ? 1 : 0);
+        service_gateway_buf.resize(service_gateway_cb ? 1 : 0);
+    };
+
+    UpsfSubscriberWrapper(
+        const upsf_subscribe_filter_t* filter,
+        void* userdata = nullptr,
+        upsf_shard_cb_t shard_cb = nullptr,
+        upsf_session_context_cb_t session_context_cb = nullptr,
+        upsf_network_connection_cb_t network_connection_cb = nullptr,
+        upsf_service_gateway_user_plane_cb_t service_gateway_user_plane_cb = nullptr,
+        upsf_traffic_steering_function_cb_t traffic_steering_function_cb = nullptr,
+        upsf_service_gateway_cb_t service_gateway_cb = nullptr)
+        : UpsfSubscriberWrapper(
+            userdata,
+            shard_cb,
+            session_context_cb,
+            network_connection_cb,
+            service_gateway_user_plane_cb,
+            traffic_steering_function_cb,
+            service_gateway_cb)
+    {
+        set_filter(filter);
+    };
 
 public:
+    /**
+     * map subscribe filter onto ReadReq parameters
+     */
+    void set_filter(const upsf_subscribe_filter_t* filter)
+    {
+        /* default item types: derived from non-NULL callbacks */
+        std::vector<wt474_upsf_service::v1::ItemType> cb_itemtypes;
+        if (service_gateway_cb)
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::service_gateway);
+        if (service_gateway_user_plane_cb)
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::service_gateway_user_plane);
+        if (traffic_steering_function_cb)
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::traffic_steering_function);
+        if (network_connection_cb)
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::network_connection);
+        if (shard_cb)
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::shard);
+        if (session_context_cb)
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::session_context);
+
+        upsf_set_subscribe_filter(*this, filter, cb_itemtypes);
+    };
+
     virtual void notify(
         const wt474_messages::v1::ServiceGateway& service_gateway)
     {
         if (!service_gateway_cb) {
             return;
         }
-        upsf_service_gateway_t upsf_service_gateway;
+        upsf::UpsfMapping::map(service_gateway, service_gateway_buf[0], /*reset=*/false);
 
-        upsf::UpsfMapping::map(service_gateway, upsf_service_gateway);
-
-        (*service_gateway_cb)(&upsf_service_gateway, userdata);
+        (*service_gateway_cb)(&service_gateway_buf[0], userdata);
     };
 
     virtual void notify(
@@ -109,11 +309,9 @@ public:
         if (!service_gateway_user_plane_cb) {
             return;
         }
-        upsf_service_gateway_user_plane_t upsf_service_gateway_user_plane;
-
-        upsf::UpsfMapping::map(service_gateway_user_plane, upsf_service_gateway_user_plane);
+        upsf::UpsfMapping::map(service_gateway_user_plane, service_gateway_user_plane_buf[0], /*reset=*/false);
 
-        (*service_gateway_user_plane_cb)(&upsf_service_gateway_user_plane, userdata);
+        (*service_gateway_user_plane_cb)(&service_gateway_user_plane_buf[0], userdata);
     };
 
     virtual void notify(
@@ -122,11 +320,9 @@ public:
         if (!shard_cb) {
             return;
         }
-        upsf_shard_t upsf_shard;
+        upsf::UpsfMapping::map(shard, shard_buf[0], /*reset=*/false);
 
-        upsf::UpsfMapping::map(shard, upsf_shard);
-
-        (*shard_cb)(&upsf_shard, userdata);
+        (*shard_cb)(&shard_buf[0], userdata);
     };
 
     virtual void notify(
@@ -135,11 +331,9 @@ public:
         if (!session_context_cb) {
             return;
         }
-        upsf_session_context_t upsf_session_context;
-
-        upsf::UpsfMapping::map(session_context, upsf_session_context);
+        upsf::UpsfMapping::map(session_context, session_context_buf[0], /*reset=*/false);
 
-        (*session_context_cb)(&upsf_session_context, userdata);
+        (*session_context_cb)(&session_context_buf[0], userdata);
     };
 
     virtual void notify(
@@ -148,11 +342,9 @@ public:
         if (!network_connection_cb) {
             return;
         }
-        upsf_network_connection_t upsf_network_connection;
+        upsf::UpsfMapping::map(network_connection, network_connection_buf[0], /*reset=*/false);
 
-        upsf::UpsfMapping::map(network_connection, upsf_network_connection);
-
-        (*network_connection_cb)(&upsf_network_connection, userdata);
+        (*network_connection_cb)(&network_connection_buf[0], userdata);
     };
 
     virtual void notify(
@@ -161,11 +353,9 @@ public:
         if (!traffic_steering_function_cb) {
             return;
         }
-        upsf_traffic_steering_function_t upsf_traffic_steering_function;
-
-        upsf::UpsfMapping::map(traffic_steering_function, upsf_traffic_steering_function);
+        upsf::UpsfMapping::map(traffic_steering_function, traffic_steering_function_buf[0], /*reset=*/false);
 
-        (*traffic_steering_function_cb)(&upsf_traffic_steering_function, userdata);
+        (*traffic_steering_function_cb)(&traffic_steering_function_buf[0], userdata);
     };
 
 public:
@@ -176,8 +366,405 @@ public:
     upsf_service_gateway_user_plane_cb_t service_gateway_user_plane_cb;
     upsf_traffic_steering_function_cb_t traffic_steering_function_cb;
     upsf_service_gateway_cb_t service_gateway_cb;
+
+private:
+    // output buffers, allocated once per subscription
+    UpsfBuffer<upsf_shard_t> shard_buf;
+    UpsfBuffer<upsf_session_context_t> session_context_buf;
+    UpsfBuffer<upsf_network_connection_t> network_connection_buf;
+    UpsfBuffer<upsf_service_gateway_user_plane_t> service_gateway_user_plane_buf;
+    UpsfBuffer<upsf_traffic_steering_function_t> traffic_steering_function_buf;
+    UpsfBuffer<upsf_service_gateway_t> service_gateway_buf;
+};
+
+/**
+ * UpsfBatchSubscriberWrapper maps items into per-subscription buffers and
+ * hands them out in batches of a single item type. The reader queues items
+ * and a delivery thread drains the queue, so a batch holds whatever arrived
+ * while the previous one was processed: large batches during initial sync,
+ * no added latency for single updates.
+ */
+class UpsfBatchSubscriberWrapper : public upsf::UpsfSubscriber {
+public:
+    UpsfBatchSubscriberWrapper(
+        const upsf_subscribe_filter_t* filter,
+        void* userdata,
+        size_t batch_size,
+        upsf_shard_batch_cb_t shard_batch_cb,
+        upsf_session_context_batch_cb_t session_context_batch_cb,
+        upsf_network_connection_batch_cb_t network_connection_batch_cb,
+        upsf_service_gateway_user_plane_batch_cb_t service_gateway_user_plane_batch_cb,
+        upsf_traffic_steering_function_batch_cb_t traffic_steering_function_batch_cb,
+        upsf_service_gateway_batch_cb_t service_gateway_batch_cb)
+        : UpsfSubscriber(/*watch=*/true)
+        , userdata(userdata)
+        , batch_size(batch_size > 0 ? batch_size : UPSF_DEFAULT_BATCH_SIZE)
+        , shard_batch_cb(shard_batch_cb)
+        , session_context_batch_cb(session_context_batch_cb)
+        , network_connection_batch_cb(network_connection_batch_cb)
+        , service_gateway_user_plane_batch_cb(service_gateway_user_plane_batch_cb)
+        , traffic_steering_function_batch_cb(traffic_steering_function_batch_cb)
+        , service_gateway_batch_cb(service_gateway_batch_cb)
+        , batch_type(wt474_upsf_service::v1::ItemType::service_gateway)
+        , batch_len(0)
+        , stopped(false)
+    {
+        /* default item types and batch buffers: non-NULL callbacks only */
+        std::vector<wt474_upsf_service::v1::ItemType> cb_itemtypes;
+        if (service_gateway_batch_cb) {
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::service_gateway);
+            service_gateways.resize(this->batch_size);
+        }
+        if (service_gateway_user_plane_batch_cb) {
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::service_gateway_user_plane);
+            service_gateway_user_planes.resize(this->batch_size);
+        }
+        if (traffic_steering_function_batch_cb) {
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::traffic_steering_function);
+            traffic_steering_functions.resize(this->batch_size);
+        }
+        if (network_connection_batch_cb) {
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::network_connection);
+            network_connections.resize(this->batch_size);
+        }
+        if (shard_batch_cb) {
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::shard);
+            shards.resize(this->batch_size);
+        }
+        if (session_context_batch_cb) {
+            cb_itemtypes.push_back(wt474_upsf_service::v1::ItemType::session_context);
+            session_contexts.resize(this->batch_size);
+        }
+
+        upsf_set_subscribe_filter(*this, filter, cb_itemtypes);
+    };
+
+public:
+    /**
+     * queue item for delivery, blocks while the queue is full
+     */
+    void enqueue(
+        const std::shared_ptr<const wt474_messages::v1::Item>& item)
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        queue_space.wait(lock, [this] { return queue.size() < UPSF_BATCH_QUEUE_DEPTH * batch_size; });
+        queue.push_back(item);
+        queue_ready.notify_one();
+    };
+
+    /**
+     * terminate delivery once the queue has been drained
+     */
+    void stop()
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        stopped = true;
+        queue_ready.notify_one();
+    };
+
+    /**
+     * delivery loop, returns after stop()
+     */
+    void deliver()
+    {
+        std::deque<std::shared_ptr<const wt474_messages::v1::Item>> items;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_ready.wait(lock, [this] { return stopped || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                items.swap(queue);
+                queue_space.notify_one();
+            }
+            for (auto& item : items) {
+                add(*item);
+            }
+            flush();
+            items.clear();
+        }
+    };
+
+private:
+    /**
+     * map item into current batch, flush on item type change or full batch
+     */
+    void add(
+        const wt474_messages::v1::Item& item)
+    {
+        wt474_upsf_service::v1::ItemType itemtype;
+        if (!upsf::item_type(item, itemtype)) {
+            return;
+        }
+        if ((itemtype != batch_type) || (batch_len == batch_size)) {
+            flush();
+        }
+        batch_type = itemtype;
+
+        switch (itemtype) {
+        case wt474_upsf_service::v1::ItemType::service_gateway:
+            if (service_gateway_batch_cb) {
+                upsf::UpsfMapping::map(item.service_gateway(), service_gateways[batch_len++], /*reset=*/false);
+            }
+            break;
+        case wt474_upsf_service::v1::ItemType::service_gateway_user_plane:
+            if (service_gateway_user_plane_batch_cb) {
+                upsf::UpsfMapping::map(item.service_gateway_user_plane(), service_gateway_user_planes[batch_len++], /*reset=*/false);
+            }
+            break;
+        case wt474_upsf_service::v1::ItemType::traffic_steering_function:
+            if (traffic_steering_function_batch_cb) {
+                upsf::UpsfMapping::map(item.traffic_steering_function(), traffic_steering_functions[batch_len++], /*reset=*/false);
+            }
+            break;
+        case wt474_upsf_service::v1::ItemType::network_connection:
+            if (network_connection_batch_cb) {
+                upsf::UpsfMapping::map(item.network_connection(), network_connections[batch_len++], /*reset=*/false);
+            }
+            break;
+        case wt474_upsf_service::v1::ItemType::shard:
+            if (shard_batch_cb) {
+                upsf::UpsfMapping::map(item.shard(), shards[batch_len++], /*reset=*/false);
+            }
+            break;
+        case wt474_upsf_service::v1::ItemType::session_context:
+            if (session_context_batch_cb) {
+                upsf::UpsfMapping::map(item.session_context(), session_contexts[batch_len++], /*reset=*/false);
+            }
+            break;
+        default:
+            break;
+        }
+    };
+
+    /**
+     * hand out current batch
+     */
+    void flush()
+    {
+        if (batch_len == 0) {
+            return;
+        }
+
+        switch (batch_type) {
+        case wt474_upsf_service::v1::ItemType::service_gateway:
+            (*service_gateway_batch_cb)(service_gateways.data(), batch_len, userdata);
+            break;
+        case wt474_upsf_service::v1::ItemType::service_gateway_user_plane:
+            (*service_gateway_user_plane_batch_cb)(service_gateway_user_planes.data(), batch_len, userdata);
+            break;
+        case wt474_upsf_service::v1::ItemType::traffic_steering_function:
+            (*traffic_steering_function_batch_cb)(traffic_steering_functions.data(), batch_len, userdata);
+            break;
+        case wt474_upsf_service::v1::ItemType::network_connection:
+            (*network_connection_batch_cb)(network_connections.data(), batch_len, userdata);
+            break;
+        case wt474_upsf_service::v1::ItemType::shard:
+            (*shard_batch_cb)(shards.data(), batch_len, userdata);
+            break;
+        case wt474_upsf_service::v1::ItemType::session_context:
+            (*session_context_batch_cb)(session_contexts.data(), batch_len, userdata);
+            break;
+        default:
+            break;
+        }
+        batch_len = 0;
+    };
+
+public:
+    void* userdata;
+    size_t batch_size;
+    upsf_shard_batch_cb_t shard_batch_cb;
+    upsf_session_context_batch_cb_t session_context_batch_cb;
+    upsf_network_connection_batch_cb_t network_connection_batch_cb;
+    upsf_service_gateway_user_plane_batch_cb_t service_gateway_user_plane_batch_cb;
+    upsf_traffic_steering_function_batch_cb_t traffic_steering_function_batch_cb;
+    upsf_service_gateway_batch_cb_t service_gateway_batch_cb;
+
+private:
+    // batch buffers, allocated once per subscription and reused across batches
+    UpsfBuffer<upsf_shard_t> shards;
+    UpsfBuffer<upsf_session_context_t> session_contexts;
+    UpsfBuffer<upsf_network_connection_t> network_connections;
+    UpsfBuffer<upsf_service_gateway_user_plane_t> service_gateway_user_planes;
+    UpsfBuffer<upsf_traffic_steering_function_t> traffic_steering_functions;
+    UpsfBuffer<upsf_service_gateway_t> service_gateways;
+    // current batch
+    wt474_upsf_service::v1::ItemType batch_type;
+    size_t batch_len;
+    // delivery queue
+    std::deque<std::shared_ptr<const wt474_messages::v1::Item>> queue;
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    std::condition_variable queue_space;
+    bool stopped;
+};
+
+/**
+ * lookup cache shared by all threads, fed by a dedicated watch stream
+ */
+class UpsfLookupCacheSlot final {
+public:
+    UpsfLookupCacheSlot(
+        const std::string& upsf_addr,
+        std::chrono::milliseconds ttl,
+        std::chrono::milliseconds negative_ttl)
+        : cache(ttl, negative_ttl)
+        , hub(grpc::CreateChannel(upsf_addr, grpc::InsecureChannelCredentials()),
+              cache.itemtypes, cache.derivedstates)
+        , stopped(false)
+    {
+        hub.attach(cache);
+        /* results are cached only while the watch stream is established */
+        hub.set_callbacks(
+            [this]() { cache.set_enabled(true); },
+            [this]() { cache.set_enabled(false); });
+        thread = std::thread([this]() {
+            while (!stopped) {
+                hub.run();
+                for (int i = 0; i < 10 && !stopped; i++) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            }
+        });
+    }
+
+    ~UpsfLookupCacheSlot()
+    {
+        stopped = true;
+        hub.stop();
+        thread.join();
+    }
+
+    upsf::UpsfLookupCache cache;
+    upsf::UpsfSubscriptionHub hub;
+    std::thread thread;
+    std::atomic<bool> stopped;
+};
+
+std::shared_ptr<UpsfLookupCacheSlot> upsf_lookup_cache;
+
+/**
+ * write-behind shared by all threads, written by a dedicated thread
+ */
+class UpsfWriteBehindSlot final {
+public:
+    UpsfWriteBehindSlot(
+        const std::string& upsf_addr,
+        std::chrono::milliseconds window,
+        void* userdata,
+        upsf_write_behind_cb_t write_cb)
+        : writer(grpc::CreateChannel(upsf_addr, grpc::InsecureChannelCredentials()), window)
+    {
+        if (write_cb) {
+            writer.set_callbacks(
+                [userdata, write_cb](const wt474_messages::v1::Item& request, const wt474_messages::v1::Item&) {
+                    notify(request, 1, userdata, write_cb);
+                },
+                [userdata, write_cb](const wt474_messages::v1::Item& request) {
+                    notify(request, 0, userdata, write_cb);
+                });
+        }
+        thread = std::thread([this]() { writer.run(); });
+    }
+
+    ~UpsfWriteBehindSlot()
+    {
+        /* run() flushes pending updates before returning */
+        writer.stop();
+        thread.join();
+    }
+
+    static void notify(
+        const wt474_messages::v1::Item& request,
+        int success,
+        void* userdata,
+        upsf_write_behind_cb_t write_cb)
+    {
+        wt474_upsf_service::v1::ItemType itemtype;
+        if (!upsf::item_type(request, itemtype)) {
+            return;
+        }
+        write_cb(upsf_item_type_t(itemtype), upsf::item_name(request).c_str(), success, userdata);
+    }
+
+    upsf::UpsfWriteBehind writer;
+    std::thread thread;
 };
 
+std::shared_ptr<UpsfWriteBehindSlot> upsf_write_behind;
+
+/**
+ * shared memory replica serving get and list calls of all threads
+ */
+std::shared_ptr<upsf::UpsfShmCache> upsf_shm_cache;
+
+/**
+ * get item of type M named as elem from the shared memory replica,
+ * returns false if not attached or not present
+ */
+template <typename M, typename C>
+static bool upsf_shm_get(C* elem)
+{
+    std::shared_ptr<upsf::UpsfShmCache> shm = std::atomic_load(&upsf_shm_cache);
+    if (!shm) {
+        return false;
+    }
+
+    /* decoded into a thread local instance keeping its field storage */
+    static thread_local wt474_messages::v1::Item item;
+    if (!shm->view().get(upsf::message_item_type<M>(), std::string(elem->name.str), item)) {
+        return false;
+    }
+    const M* m = upsf::item_message<M>(item);
+    if (!m) {
+        return false;
+    }
+
+    /* map cpp-object to c-struct */
+    upsf::UpsfMapping::map(*m, *elem);
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " shm reply=" << m->name() << std::endl;
+
+    return true;
+}
+
+/**
+ * list items of type M from the shared memory replica, returns -1 if not
+ * attached or nothing was published yet
+ */
+template <typename M, typename C>
+static int upsf_shm_list(C* elems, size_t n_elems)
+{
+    std::shared_ptr<upsf::UpsfShmCache> shm = std::atomic_load(&upsf_shm_cache);
+    if (!shm) {
+        return -1;
+    }
+    upsf::UpsfShmCache::View view = shm->view();
+    if (view.generation() == 0) {
+        return -1;
+    }
+
+    /* clear buffer */
+    memset(elems, 0, sizeof(C) * n_elems);
+
+    size_t i = 0;
+    view.for_each(upsf::message_item_type<M>(),
+        [elems, n_elems, &i](const upsf::UpsfCache::ItemPtr& item) {
+            if (i >= n_elems) {
+                return false;
+            }
+            const M* m = upsf::item_message<M>(*item);
+            if (m) {
+                /* map cpp-object to c-struct, elems were cleared already */
+                upsf::UpsfMapping::map(*m, elems[i++], false);
+            }
+            return true;
+        });
+
+    return view.size(upsf::message_item_type<M>());
+}
+
 #define UPSF_MAX_SLOTS 128
 std::map<pthread_t, std::shared_ptr<UpsfSlot>> upsf_slots;
 std::shared_mutex upsf_slots_mutex;
@@ -219,6 +806,26 @@ const char* upsf_mbb_state_names[] = {
     "void",
 };
 
+/**
+ * get number of reads by name and lookups of the calling thread's UPSF
+ * connection served by a concurrent identical call of another thread
+ */
+int upsf_get_coalesced(uint64_t* reads, uint64_t* lookups)
+{
+    std::shared_lock rlock(upsf_slots_mutex);
+    auto it = upsf_slots.find(pthread_self());
+    if (it == upsf_slots.end()) {
+        return -1;
+    }
+    if (reads) {
+        *reads = it->second->client->get_coalesced_reads();
+    }
+    if (lookups) {
+        *lookups = it->second->client->get_coalesced_lookups();
+    }
+    return 0;
+}
+
 const char* upsf_derived_state_to_name(int derived_state)
 {
     derived_state = derived_state < UPSF_DERIVED_STATE_MAX ? derived_state : UPSF_DERIVED_STATE_MAX;
@@ -312,6 +919,32 @@ int upsf_exists()
     return 1;
 }
 
+/**
+ * dump item as text into str without heap allocations once warmed up:
+ * the thread local proto instance keeps its field storage across calls
+ * and the text is formatted straight into str
+ */
+template <typename M, typename S, typename C>
+static char* upsf_dump(char* str, size_t size, const C* elem)
+{
+    /* sanity check */
+    if (!elem || !str || size == 0) {
+        return nullptr;
+    }
+
+    /* map item */
+    static thread_local M item;
+    item.Clear();
+    upsf::UpsfMapping::map(*elem, item);
+
+    upsf::UpsfCharBuffer buf(str, size);
+    std::ostream os(&buf);
+    os << S(item);
+    buf.terminate();
+
+    return str;
+}
+
 /******************************************************************
  * ServiceGateway
  ******************************************************************/
@@ -399,6 +1032,11 @@ upsf_service_gateway_t* upsf_get_service_gateway(upsf_service_gateway_t* upsf_se
         return nullptr;
     }
 
+    /* served from a shared memory replica if attached */
+    if (upsf_shm_get<wt474_messages::v1::ServiceGateway>(upsf_service_gateway)) {
+        return upsf_service_gateway;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -470,6 +1108,12 @@ int upsf_list_service_gateways(upsf_service_gateway_t* elems, size_t n_elems)
         return -1;
     }
 
+    /* served from a shared memory replica if attached and published */
+    int n = upsf_shm_list<wt474_messages::v1::ServiceGateway>(elems, n_elems);
+    if (n >= 0) {
+        return n;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -501,21 +1145,7 @@ int upsf_list_service_gateways(upsf_service_gateway_t* elems, size_t n_elems)
 
 char* upsf_dump_service_gateway(char* str, size_t size, upsf_service_gateway_t* upsf_service_gateway)
 {
-    /* sanity check */
-    if (!upsf_service_gateway || !str || size == 0) {
-        return nullptr;
-    }
-
-    /* map service_gateway */
-    wt474_messages::v1::ServiceGateway service_gateway;
-    upsf::UpsfMapping::map(*upsf_service_gateway, service_gateway);
-
-    std::stringstream sstr;
-    sstr << upsf::ServiceGatewayStream(service_gateway);
-
-    strncpy(str, sstr.str().c_str(), std::min(size, sstr.str().size()));
-
-    return str;
+    return upsf_dump<wt474_messages::v1::ServiceGateway, upsf::ServiceGatewayStream>(str, size, upsf_service_gateway);
 }
 
 /******************************************************************
@@ -568,6 +1198,16 @@ upsf_service_gateway_user_plane_t* upsf_update_service_gateway_user_plane(upsf_s
         return nullptr;
     }
 
+    /* deferred write, if enabled */
+    std::shared_ptr<UpsfWriteBehindSlot> write_behind = std::atomic_load(&upsf_write_behind);
+    if (write_behind) {
+        wt474_messages::v1::ServiceGatewayUserPlane request;
+        upsf::UpsfMapping::map(*service_gateway_user_plane, request);
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " deferred request=" << upsf::ServiceGatewayUserPlaneStream(request) << std::endl;
+        write_behind->writer.update(request);
+        return service_gateway_user_plane;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -595,6 +1235,49 @@ upsf_service_gateway_user_plane_t* upsf_update_service_gateway_user_plane(upsf_s
     return service_gateway_user_plane;
 }
 
+/**
+ * UpdateV1 if unchanged
+ */
+int upsf_update_service_gateway_user_plane_if_unchanged(upsf_service_gateway_user_plane_t* service_gateway_user_plane)
+{
+    /* target buffer */
+    if (!service_gateway_user_plane) {
+        return -1;
+    }
+
+    /* get UpsfSlot instance */
+    pthread_t tid = pthread_self();
+    std::shared_lock rlock(upsf_slots_mutex);
+    if (upsf_slots.find(tid) == upsf_slots.end()) {
+        return -1;
+    }
+    UpsfSlot* slot = upsf_slots[tid].get();
+    std::unique_lock slock(slot->upsf_slot_mutex);
+
+    wt474_messages::v1::ServiceGatewayUserPlane request;
+    wt474_messages::v1::ServiceGatewayUserPlane reply;
+    grpc::Status status;
+
+    upsf::UpsfMapping::map(*service_gateway_user_plane, request);
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " request=" << upsf::ServiceGatewayUserPlaneStream(request) << std::endl;
+
+    /* call upsf client instance */
+    if (!slot->cas.UpdateV1(request, reply, status)) {
+        if (!upsf::UpsfCompareAndSet::is_conflict(status)) {
+            return -1;
+        }
+        /* conflict: return current copy */
+        upsf::UpsfMapping::map(reply, *service_gateway_user_plane);
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " current=" << upsf::ServiceGatewayUserPlaneStream(reply) << std::endl;
+        return 1;
+    }
+
+    upsf::UpsfMapping::map(reply, *service_gateway_user_plane);
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " reply=" << upsf::ServiceGatewayUserPlaneStream(reply) << std::endl;
+
+    return 0;
+}
+
 /**
  * ReadV1
  */
@@ -605,6 +1288,11 @@ upsf_service_gateway_user_plane_t* upsf_get_service_gateway_user_plane(upsf_serv
         return nullptr;
     }
 
+    /* served from a shared memory replica if attached */
+    if (upsf_shm_get<wt474_messages::v1::ServiceGatewayUserPlane>(upsf_service_gateway_user_plane)) {
+        return upsf_service_gateway_user_plane;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -676,6 +1364,12 @@ int upsf_list_service_gateway_user_planes(upsf_service_gateway_user_plane_t* ele
         return -1;
     }
 
+    /* served from a shared memory replica if attached and published */
+    int n = upsf_shm_list<wt474_messages::v1::ServiceGatewayUserPlane>(elems, n_elems);
+    if (n >= 0) {
+        return n;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -707,26 +1401,12 @@ int upsf_list_service_gateway_user_planes(upsf_service_gateway_user_plane_t* ele
 
 char* upsf_dump_service_gateway_user_plane(char* str, size_t size, upsf_service_gateway_user_plane_t* upsf_service_gateway_user_plane)
 {
-    /* sanity check */
-    if (!upsf_service_gateway_user_plane || !str || size == 0) {
-        return nullptr;
-    }
+    return upsf_dump<wt474_messages::v1::ServiceGatewayUserPlane, upsf::ServiceGatewayUserPlaneStream>(str, size, upsf_service_gateway_user_plane);
+}
 
-    /* map service_gateway_user_plane */
-    wt474_messages::v1::ServiceGatewayUserPlane service_gateway_user_plane;
-    upsf::UpsfMapping::map(*upsf_service_gateway_user_plane, service_gateway_user_plane);
-
-    std::stringstream sstr;
-    sstr << upsf::ServiceGatewayUserPlaneStream(service_gateway_user_plane);
-
-    strncpy(str, sstr.str().c_str(), std::min(size, sstr.str().size()));
-
-    return str;
-}
-
-/******************************************************************
- * TrafficSteeringFunction
- ******************************************************************/
+/******************************************************************
+ * TrafficSteeringFunction
+ ******************************************************************/
 
 /**
  * CreateV1
@@ -811,6 +1491,11 @@ upsf_traffic_steering_function_t* upsf_get_traffic_steering_function(upsf_traffi
         return nullptr;
     }
 
+    /* served from a shared memory replica if attached */
+    if (upsf_shm_get<wt474_messages::v1::TrafficSteeringFunction>(upsf_traffic_steering_function)) {
+        return upsf_traffic_steering_function;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -882,6 +1567,12 @@ int upsf_list_traffic_steering_functions(upsf_traffic_steering_function_t* elems
         return -1;
     }
 
+    /* served from a shared memory replica if attached and published */
+    int n = upsf_shm_list<wt474_messages::v1::TrafficSteeringFunction>(elems, n_elems);
+    if (n >= 0) {
+        return n;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -913,21 +1604,7 @@ int upsf_list_traffic_steering_functions(upsf_traffic_steering_function_t* elems
 
 char* upsf_dump_traffic_steering_function(char* str, size_t size, upsf_traffic_steering_function_t* upsf_traffic_steering_function)
 {
-    /* sanity check */
-    if (!upsf_traffic_steering_function || !str || size == 0) {
-        return nullptr;
-    }
-
-    /* map traffic_steering_function */
-    wt474_messages::v1::TrafficSteeringFunction traffic_steering_function;
-    upsf::UpsfMapping::map(*upsf_traffic_steering_function, traffic_steering_function);
-
-    std::stringstream sstr;
-    sstr << upsf::TrafficSteeringFunctionStream(traffic_steering_function);
-
-    strncpy(str, sstr.str().c_str(), std::min(size, sstr.str().size()));
-
-    return str;
+    return upsf_dump<wt474_messages::v1::TrafficSteeringFunction, upsf::TrafficSteeringFunctionStream>(str, size, upsf_traffic_steering_function);
 }
 
 /******************************************************************
@@ -1017,6 +1694,11 @@ upsf_network_connection_t* upsf_get_network_connection(upsf_network_connection_t
         return nullptr;
     }
 
+    /* served from a shared memory replica if attached */
+    if (upsf_shm_get<wt474_messages::v1::NetworkConnection>(upsf_network_connection)) {
+        return upsf_network_connection;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -1088,6 +1770,12 @@ int upsf_list_network_connections(upsf_network_connection_t* elems, size_t n_ele
         return -1;
     }
 
+    /* served from a shared memory replica if attached and published */
+    int n = upsf_shm_list<wt474_messages::v1::NetworkConnection>(elems, n_elems);
+    if (n >= 0) {
+        return n;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -1119,21 +1807,7 @@ int upsf_list_network_connections(upsf_network_connection_t* elems, size_t n_ele
 
 char* upsf_dump_network_connection(char* str, size_t size, upsf_network_connection_t* upsf_network_connection)
 {
-    /* sanity check */
-    if (!upsf_network_connection || !str || size == 0) {
-        return nullptr;
-    }
-
-    /* map network_connection */
-    wt474_messages::v1::NetworkConnection network_connection;
-    upsf::UpsfMapping::map(*upsf_network_connection, network_connection);
-
-    std::stringstream sstr;
-    sstr << upsf::NetworkConnectionStream(network_connection);
-
-    strncpy(str, sstr.str().c_str(), std::min(size, sstr.str().size()));
-
-    return str;
+    return upsf_dump<wt474_messages::v1::NetworkConnection, upsf::NetworkConnectionStream>(str, size, upsf_network_connection);
 }
 
 /******************************************************************
@@ -1186,6 +1860,16 @@ upsf_shard_t* upsf_update_shard(upsf_shard_t* shard)
         return nullptr;
     }
 
+    /* deferred write, if enabled */
+    std::shared_ptr<UpsfWriteBehindSlot> write_behind = std::atomic_load(&upsf_write_behind);
+    if (write_behind) {
+        wt474_messages::v1::Shard request;
+        upsf::UpsfMapping::map(*shard, request);
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " deferred request=" << upsf::ShardStream(request) << std::endl;
+        write_behind->writer.update(request);
+        return shard;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -1213,6 +1897,49 @@ upsf_shard_t* upsf_update_shard(upsf_shard_t* shard)
     return shard;
 }
 
+/**
+ * UpdateV1 if unchanged
+ */
+int upsf_update_shard_if_unchanged(upsf_shard_t* shard)
+{
+    /* target buffer */
+    if (!shard) {
+        return -1;
+    }
+
+    /* get UpsfSlot instance */
+    pthread_t tid = pthread_self();
+    std::shared_lock rlock(upsf_slots_mutex);
+    if (upsf_slots.find(tid) == upsf_slots.end()) {
+        return -1;
+    }
+    UpsfSlot* slot = upsf_slots[tid].get();
+    std::unique_lock slock(slot->upsf_slot_mutex);
+
+    wt474_messages::v1::Shard request;
+    wt474_messages::v1::Shard reply;
+    grpc::Status status;
+
+    upsf::UpsfMapping::map(*shard, request);
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " request=" << upsf::ShardStream(request) << std::endl;
+
+    /* call upsf client instance */
+    if (!slot->cas.UpdateV1(request, reply, status)) {
+        if (!upsf::UpsfCompareAndSet::is_conflict(status)) {
+            return -1;
+        }
+        /* conflict: return current copy */
+        upsf::UpsfMapping::map(reply, *shard);
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " current=" << upsf::ShardStream(reply) << std::endl;
+        return 1;
+    }
+
+    upsf::UpsfMapping::map(reply, *shard);
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " reply=" << upsf::ShardStream(reply) << std::endl;
+
+    return 0;
+}
+
 /**
  * ReadV1
  */
@@ -1223,6 +1950,11 @@ upsf_shard_t* upsf_get_shard(upsf_shard_t* upsf_shard)
         return nullptr;
     }
 
+    /* served from a shared memory replica if attached */
+    if (upsf_shm_get<wt474_messages::v1::Shard>(upsf_shard)) {
+        return upsf_shard;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -1294,6 +2026,12 @@ int upsf_list_shards(upsf_shard_t* elems, size_t n_elems)
         return -1;
     }
 
+    /* served from a shared memory replica if attached and published */
+    int n = upsf_shm_list<wt474_messages::v1::Shard>(elems, n_elems);
+    if (n >= 0) {
+        return n;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -1325,21 +2063,7 @@ int upsf_list_shards(upsf_shard_t* elems, size_t n_elems)
 
 char* upsf_dump_shard(char* str, size_t size, upsf_shard_t* upsf_shard)
 {
-    /* sanity check */
-    if (!upsf_shard || !str || size == 0) {
-        return nullptr;
-    }
-
-    /* map shard */
-    wt474_messages::v1::Shard shard;
-    upsf::UpsfMapping::map(*upsf_shard, shard);
-
-    std::stringstream sstr;
-    sstr << upsf::ShardStream(shard);
-
-    strncpy(str, sstr.str().c_str(), std::min(size, sstr.str().size()));
-
-    return str;
+    return upsf_dump<wt474_messages::v1::Shard, upsf::ShardStream>(str, size, upsf_shard);
 }
 
 /******************************************************************
@@ -1429,6 +2153,11 @@ upsf_session_context_t* upsf_get_session_context(upsf_session_context_t* upsf_se
         return nullptr;
     }
 
+    /* served from a shared memory replica if attached */
+    if (upsf_shm_get<wt474_messages::v1::SessionContext>(upsf_session_context)) {
+        return upsf_session_context;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -1500,6 +2229,12 @@ int upsf_list_session_contexts(upsf_session_context_t* elems, size_t n_elems)
         return -1;
     }
 
+    /* served from a shared memory replica if attached and published */
+    int n = upsf_shm_list<wt474_messages::v1::SessionContext>(elems, n_elems);
+    if (n >= 0) {
+        return n;
+    }
+
     /* get UpsfSlot instance */
     pthread_t tid = pthread_self();
     std::shared_lock rlock(upsf_slots_mutex);
@@ -1531,21 +2266,7 @@ int upsf_list_session_contexts(upsf_session_context_t* elems, size_t n_elems)
 
 char* upsf_dump_session_context(char* str, size_t size, upsf_session_context_t* upsf_session_context)
 {
-    /* sanity check */
-    if (!upsf_session_context || !str || size == 0) {
-        return nullptr;
-    }
-
-    /* map session_context */
-    wt474_messages::v1::SessionContext session_context;
-    upsf::UpsfMapping::map(*upsf_session_context, session_context);
-
-    std::stringstream sstr;
-    sstr << upsf::SessionContextStream(session_context);
-
-    strncpy(str, sstr.str().c_str(), std::min(size, sstr.str().size()));
-
-    return str;
+    return upsf_dump<wt474_messages::v1::SessionContext, upsf::SessionContextStream>(str, size, upsf_session_context);
 }
 
 /******************************************************************
@@ -1577,8 +2298,13 @@ upsf_session_context_t* upsf_lookup(upsf_session_context_t* upsf_session_context
     upsf::UpsfMapping::map(upsf_session_context->spec, request);
 
     VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " request=" << upsf::SessionContextSpecStream(request) << std::endl;
-    /* call upsf client instance */
-    if (!slot->client->LookupV1(request, reply)) {
+    /* call upsf client instance, via the lookup cache if enabled */
+    std::shared_ptr<UpsfLookupCacheSlot> lookup_cache = std::atomic_load(&upsf_lookup_cache);
+    if (lookup_cache) {
+        if (!lookup_cache->cache.LookupV1(*slot->client, request, reply)) {
+            return nullptr;
+        }
+    } else if (!slot->client->LookupV1(request, reply)) {
         return nullptr;
     }
     VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " reply=" << upsf::SessionContextStream(reply) << std::endl;
@@ -1594,6 +2320,183 @@ upsf_session_context_t* upsf_lookup(upsf_session_context_t* upsf_session_context
     return upsf_session_context;
 }
 
+/**
+ * enable lookup cache for all threads
+ */
+int upsf_lookup_cache_enable(
+    const char* upsf_host,
+    const int upsf_port,
+    uint32_t ttl_ms,
+    uint32_t negative_ttl_ms)
+{
+    if (!upsf_host) {
+        return -1;
+    }
+
+    /* upsf address */
+    std::stringstream upsfaddr;
+    upsfaddr << upsf_host << ":" << upsf_port;
+
+    std::shared_ptr<UpsfLookupCacheSlot> lookup_cache = std::make_shared<UpsfLookupCacheSlot>(
+        upsfaddr.str(), std::chrono::milliseconds(ttl_ms), std::chrono::milliseconds(negative_ttl_ms));
+    std::atomic_store(&upsf_lookup_cache, lookup_cache);
+
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " upsf=" << upsfaddr.str() << " ttl=" << ttl_ms << "ms negative_ttl=" << negative_ttl_ms << "ms" << std::endl;
+
+    return 0;
+}
+
+/**
+ * disable lookup cache
+ */
+int upsf_lookup_cache_disable()
+{
+    std::shared_ptr<UpsfLookupCacheSlot> lookup_cache;
+    std::atomic_store(&upsf_lookup_cache, lookup_cache);
+    return 0;
+}
+
+/**
+ * get lookup cache statistics
+ */
+int upsf_lookup_cache_stats(
+    uint64_t* hits,
+    uint64_t* misses,
+    uint64_t* invalidations)
+{
+    std::shared_ptr<UpsfLookupCacheSlot> lookup_cache = std::atomic_load(&upsf_lookup_cache);
+    if (!lookup_cache) {
+        return -1;
+    }
+    if (hits) {
+        *hits = lookup_cache->cache.get_hits();
+    }
+    if (misses) {
+        *misses = lookup_cache->cache.get_misses();
+    }
+    if (invalidations) {
+        *invalidations = lookup_cache->cache.get_invalidations();
+    }
+    return 0;
+}
+
+/******************************************************************
+ * Write-behind
+ ******************************************************************/
+
+/**
+ * enable write-behind for shard and user plane updates of all threads
+ */
+int upsf_write_behind_enable(
+    const char* upsf_host,
+    const int upsf_port,
+    uint32_t window_ms,
+    void* userdata,
+    upsf_write_behind_cb_t write_cb)
+{
+    if (!upsf_host) {
+        return -1;
+    }
+
+    /* upsf address */
+    std::stringstream upsfaddr;
+    upsfaddr << upsf_host << ":" << upsf_port;
+
+    std::shared_ptr<UpsfWriteBehindSlot> write_behind = std::make_shared<UpsfWriteBehindSlot>(
+        upsfaddr.str(), std::chrono::milliseconds(window_ms), userdata, write_cb);
+    write_behind = std::atomic_exchange(&upsf_write_behind, write_behind);
+
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " upsf=" << upsfaddr.str() << " window=" << window_ms << "ms" << std::endl;
+
+    /* previous instance flushes on destruction */
+    return 0;
+}
+
+/**
+ * disable write-behind, pending updates are written
+ */
+int upsf_write_behind_disable()
+{
+    std::shared_ptr<UpsfWriteBehindSlot> write_behind;
+    std::atomic_store(&upsf_write_behind, write_behind);
+    return 0;
+}
+
+/**
+ * write all pending updates
+ */
+int upsf_write_behind_flush()
+{
+    std::shared_ptr<UpsfWriteBehindSlot> write_behind = std::atomic_load(&upsf_write_behind);
+    if (!write_behind) {
+        return 0;
+    }
+    return write_behind->writer.flush() ? 0 : -1;
+}
+
+/**
+ * get write-behind statistics
+ */
+int upsf_write_behind_stats(
+    uint64_t* updates,
+    uint64_t* dropped,
+    uint64_t* merged,
+    uint64_t* written,
+    uint64_t* failed)
+{
+    std::shared_ptr<UpsfWriteBehindSlot> write_behind = std::atomic_load(&upsf_write_behind);
+    if (!write_behind) {
+        return -1;
+    }
+    if (updates) {
+        *updates = write_behind->writer.get_updates();
+    }
+    if (dropped) {
+        *dropped = write_behind->writer.get_dropped();
+    }
+    if (merged) {
+        *merged = write_behind->writer.get_merged();
+    }
+    if (written) {
+        *written = write_behind->writer.get_written();
+    }
+    if (failed) {
+        *failed = write_behind->writer.get_failed();
+    }
+    return 0;
+}
+
+/******************************************************************
+ * Shared memory replica
+ ******************************************************************/
+
+/**
+ * serve get and list calls of all threads from a shared memory replica
+ */
+int upsf_shm_attach(const char* name)
+{
+    if (!name || name[0] != '/') {
+        return -1;
+    }
+
+    std::shared_ptr<upsf::UpsfShmCache> shm = std::make_shared<upsf::UpsfShmCache>(name);
+    std::atomic_store(&upsf_shm_cache, shm);
+
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " name=" << name << std::endl;
+
+    return 0;
+}
+
+/**
+ * serve get and list calls from UPSF again
+ */
+int upsf_shm_detach()
+{
+    std::shared_ptr<upsf::UpsfShmCache> shm;
+    std::atomic_store(&upsf_shm_cache, shm);
+    return 0;
+}
+
 /******************************************************************
  * Subscribe
  ******************************************************************/
@@ -1609,19 +2512,39 @@ int upsf_subscribe(
     upsf_traffic_steering_function_cb_t traffic_steering_function_cb,
     upsf_service_gateway_cb_t service_gateway_cb)
 {
+    return upsf_subscribe_ex(
+        upsf_host,
+        upsf_port,
+        userdata,
+        nullptr,
+        shard_cb,
+        session_context_cb,
+        network_connection_cb,
+        service_gateway_user_plane_cb,
+        traffic_steering_function_cb,
+        service_gateway_cb);
+}
+
+int upsf_subscribe_ex(
+    const char* upsf_host,
+    const int upsf_port,
+    void* userdata,
+    const upsf_subscribe_filter_t* filter,
+    upsf_shard_cb_t shard_cb,
+    upsf_session_context_cb_t session_context_cb,
+    upsf_network_connection_cb_t network_connection_cb,
+    upsf_service_gateway_user_plane_cb_t service_gateway_user_plane_cb,
+    upsf_traffic_steering_function_cb_t traffic_steering_function_cb,
+    upsf_service_gateway_cb_t service_gateway_cb)
+{
 
     /* upsf address */
     std::stringstream upsfaddr;
     upsfaddr << upsf_host << ":" << upsf_port;
 
-    /* UpsfClient instance */
-    upsf::UpsfClient client(
-        grpc::CreateChannel(
-            upsfaddr.str(),
-            grpc::InsecureChannelCredentials()));
-
     /* upsf subscriber wrapper */
     UpsfSubscriberWrapper subscriber(
+        filter,
         userdata,
         shard_cb,
         session_context_cb,
@@ -1630,6 +2553,18 @@ int upsf_subscribe(
         traffic_steering_function_cb,
         service_gateway_cb);
 
+    /* nothing to subscribe to */
+    if (subscriber.itemtypes.empty()) {
+        LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " no item types selected, neither by filter nor by callbacks" << std::endl;
+        return -1;
+    }
+
+    /* UpsfClient instance */
+    upsf::UpsfClient client(
+        grpc::CreateChannel(
+            upsfaddr.str(),
+            grpc::InsecureChannelCredentials()));
+
     /* serve subscriber, does not return unless an error occurs */
     if (client.ReadV1(subscriber) == false) {
         return -1;
@@ -1637,3 +2572,894 @@ int upsf_subscribe(
 
     return 0;
 }
+
+int upsf_subscribe_batch(
+    const char* upsf_host,
+    const int upsf_port,
+    void* userdata,
+    const upsf_subscribe_filter_t* filter,
+    size_t batch_size,
+    upsf_shard_batch_cb_t shard_batch_cb,
+    upsf_session_context_batch_cb_t session_context_batch_cb,
+    upsf_network_connection_batch_cb_t network_connection_batch_cb,
+    upsf_service_gateway_user_plane_batch_cb_t service_gateway_user_plane_batch_cb,
+    upsf_traffic_steering_function_batch_cb_t traffic_steering_function_batch_cb,
+    upsf_service_gateway_batch_cb_t service_gateway_batch_cb)
+{
+
+    /* upsf address */
+    std::stringstream upsfaddr;
+    upsfaddr << upsf_host << ":" << upsf_port;
+
+    /* upsf batch subscriber wrapper */
+    UpsfBatchSubscriberWrapper subscriber(
+        filter,
+        userdata,
+        batch_size,
+        shard_batch_cb,
+        session_context_batch_cb,
+        network_connection_batch_cb,
+        service_gateway_user_plane_batch_cb,
+        traffic_steering_function_batch_cb,
+        service_gateway_batch_cb);
+
+    /* nothing to subscribe to */
+    if (subscriber.itemtypes.empty()) {
+        LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " no item types selected, neither by filter nor by callbacks" << std::endl;
+        return -1;
+    }
+
+    /* UpsfClient instance */
+    upsf::UpsfClient client(
+        grpc::CreateChannel(
+            upsfaddr.str(),
+            grpc::InsecureChannelCredentials()));
+
+    wt474_upsf_service::v1::ReadReq req;
+    subscriber.get_request(req);
+
+    /* batch delivery thread */
+    std::thread delivery(&UpsfBatchSubscriberWrapper::deliver, &subscriber);
+
+    /* serve subscriber, does not return unless an error occurs */
+    int rc = 0;
+    do {
+        grpc::ClientContext context;
+        if (client.ReadV1(req, context,
+                [&subscriber](const std::shared_ptr<const wt474_messages::v1::Item>& item) {
+                    subscriber.enqueue(item);
+                    return true;
+                })
+            == false) {
+            rc = -1;
+            break;
+        }
+    } while (subscriber.get_watch());
+
+    subscriber.stop();
+    delivery.join();
+
+    return rc;
+}
+
+/******************************************************************
+ * Item references
+ ******************************************************************/
+
+upsf_item_ref_t* upsf_get_item_ref(enum upsf_item_type_t item_type, const char* name)
+{
+    /* sanity check */
+    if (!name || (item_type < 0) || (item_type >= UPSF_ITEM_TYPE_MAX)) {
+        return nullptr;
+    }
+
+    /* served from a shared memory replica if attached */
+    std::shared_ptr<upsf::UpsfShmCache> shm = std::atomic_load(&upsf_shm_cache);
+    if (shm) {
+        upsf::UpsfCache::ItemPtr item = shm->get(wt474_upsf_service::v1::ItemType(item_type), name);
+        if (item) {
+            return new upsf_item_ref_s(item);
+        }
+    }
+
+    /* get UpsfSlot instance */
+    pthread_t tid = pthread_self();
+    std::shared_lock rlock(upsf_slots_mutex);
+    if (upsf_slots.find(tid) == upsf_slots.end()) {
+        return nullptr;
+    }
+    UpsfSlot* slot = upsf_slots[tid].get();
+    std::unique_lock slock(slot->upsf_slot_mutex);
+
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " request=" << upsf_item_type_to_name(item_type) << ":" << name << std::endl;
+
+    wt474_upsf_service::v1::ReadReq req;
+    req.add_itemtype(wt474_upsf_service::v1::ItemType(item_type));
+    req.add_name()->set_value(name);
+    req.set_watch(false);
+
+    /* call upsf client instance, keep first matching item */
+    std::shared_ptr<const wt474_messages::v1::Item> reply;
+    grpc::ClientContext context;
+    if (!slot->client->ReadV1(req, context,
+            [&reply, name](const std::shared_ptr<const wt474_messages::v1::Item>& item) {
+                if (upsf::item_name(*item) != name) {
+                    return true;
+                }
+                reply = item;
+                return false;
+            })) {
+        return nullptr;
+    }
+
+    /* not found */
+    if (!reply) {
+        return nullptr;
+    }
+
+    return new upsf_item_ref_s(reply);
+}
+
+int upsf_subscribe_ref(
+    const char* upsf_host,
+    const int upsf_port,
+    void* userdata,
+    const upsf_subscribe_filter_t* filter,
+    upsf_item_ref_cb_t item_ref_cb)
+{
+    /* sanity check */
+    if (!item_ref_cb) {
+        return -1;
+    }
+
+    /* upsf address */
+    std::stringstream upsfaddr;
+    upsfaddr << upsf_host << ":" << upsf_port;
+
+    /* subscriber for all item types unless filtered */
+    upsf::UpsfSubscriber subscriber(/*watch=*/true);
+    std::vector<wt474_upsf_service::v1::ItemType> all_itemtypes(subscriber.itemtypes);
+    upsf_set_subscribe_filter(subscriber, filter, all_itemtypes);
+
+    /* UpsfClient instance */
+    upsf::UpsfClient client(
+        grpc::CreateChannel(
+            upsfaddr.str(),
+            grpc::InsecureChannelCredentials()));
+
+    wt474_upsf_service::v1::ReadReq req;
+    subscriber.get_request(req);
+
+    /* serve subscriber, does not return unless an error occurs */
+    do {
+        grpc::ClientContext context;
+        if (client.ReadV1(req, context,
+                [item_ref_cb, userdata](const std::shared_ptr<const wt474_messages::v1::Item>& item) {
+                    /* reference owned by libupsf, callback may acquire it */
+                    upsf_item_ref_t* ref = new upsf_item_ref_s(item);
+                    (*item_ref_cb)(ref, userdata);
+                    upsf_item_ref_release(ref);
+                    return true;
+                })
+            == false) {
+            return -1;
+        }
+    } while (subscriber.get_watch());
+
+    return 0;
+}
+
+/******************************************************************
+ * Variable length items
+ ******************************************************************/
+
+/**
+ * read item by name and map it into arena, arena is left unchanged on failure
+ */
+template <typename M, typename V>
+static V* upsf_var_get(upsf_arena_t* arena, const char* name)
+{
+    /* sanity check */
+    if (!arena || !name) {
+        return nullptr;
+    }
+
+    /* get UpsfSlot instance */
+    pthread_t tid = pthread_self();
+    std::shared_lock rlock(upsf_slots_mutex);
+    if (upsf_slots.find(tid) == upsf_slots.end()) {
+        return nullptr;
+    }
+    UpsfSlot* slot = upsf_slots[tid].get();
+    std::unique_lock slock(slot->upsf_slot_mutex);
+
+    M reply;
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " request=" << name << std::endl;
+
+    /* call upsf client instance */
+    if (!slot->client->ReadV1(std::string(name), reply)) {
+        return nullptr;
+    }
+
+    /* empty name: not found */
+    if (reply.name().empty()) {
+        return nullptr;
+    }
+
+    /* map cpp-object to arena */
+    size_t used = arena->used;
+    V* elem = upsf::UpsfArenaMapping::alloc<V>(*arena, 1);
+    if (!elem || !upsf::UpsfArenaMapping::map(reply, *elem, *arena)) {
+        LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " arena exhausted, size=" << arena->size << std::endl;
+        arena->used = used;
+        return nullptr;
+    }
+
+    return elem;
+}
+
+/**
+ * read all items of a type and map them into arena, arena is left unchanged on failure
+ */
+template <typename M, typename V>
+static int upsf_var_list(upsf_arena_t* arena, V** elems)
+{
+    /* sanity check */
+    if (!arena || !elems) {
+        return -1;
+    }
+
+    /* get UpsfSlot instance */
+    pthread_t tid = pthread_self();
+    std::shared_lock rlock(upsf_slots_mutex);
+    if (upsf_slots.find(tid) == upsf_slots.end()) {
+        return -1;
+    }
+    UpsfSlot* slot = upsf_slots[tid].get();
+    std::unique_lock slock(slot->upsf_slot_mutex);
+
+    std::vector<M> items;
+
+    /* call upsf client instance */
+    if (!slot->client->ReadV1(items)) {
+        return -1;
+    }
+
+    /* map cpp-objects to arena */
+    size_t used = arena->used;
+    V* v = upsf::UpsfArenaMapping::alloc<V>(*arena, items.size());
+    bool mapped = (v != nullptr) || items.empty();
+    for (size_t i = 0; mapped && (i < items.size()); i++) {
+        mapped = upsf::UpsfArenaMapping::map(items[i], v[i], *arena);
+    }
+    if (!mapped) {
+        LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " arena exhausted, size=" << arena->size << std::endl;
+        arena->used = used;
+        return -1;
+    }
+    *elems = v;
+
+    return items.size();
+}
+
+upsf_var_service_gateway_t* upsf_var_get_service_gateway(upsf_arena_t* arena, const char* name)
+{
+    return upsf_var_get<wt474_messages::v1::ServiceGateway, upsf_var_service_gateway_t>(arena, name);
+}
+
+int upsf_var_list_service_gateways(upsf_arena_t* arena, upsf_var_service_gateway_t** elems)
+{
+    return upsf_var_list<wt474_messages::v1::ServiceGateway, upsf_var_service_gateway_t>(arena, elems);
+}
+
+upsf_var_service_gateway_user_plane_t* upsf_var_get_service_gateway_user_plane(upsf_arena_t* arena, const char* name)
+{
+    return upsf_var_get<wt474_messages::v1::ServiceGatewayUserPlane, upsf_var_service_gateway_user_plane_t>(arena, name);
+}
+
+int upsf_var_list_service_gateway_user_planes(upsf_arena_t* arena, upsf_var_service_gateway_user_plane_t** elems)
+{
+    return upsf_var_list<wt474_messages::v1::ServiceGatewayUserPlane, upsf_var_service_gateway_user_plane_t>(arena, elems);
+}
+
+upsf_var_traffic_steering_function_t* upsf_var_get_traffic_steering_function(upsf_arena_t* arena, const char* name)
+{
+    return upsf_var_get<wt474_messages::v1::TrafficSteeringFunction, upsf_var_traffic_steering_function_t>(arena, name);
+}
+
+int upsf_var_list_traffic_steering_functions(upsf_arena_t* arena, upsf_var_traffic_steering_function_t** elems)
+{
+    return upsf_var_list<wt474_messages::v1::TrafficSteeringFunction, upsf_var_traffic_steering_function_t>(arena, elems);
+}
+
+upsf_var_network_connection_t* upsf_var_get_network_connection(upsf_arena_t* arena, const char* name)
+{
+    return upsf_var_get<wt474_messages::v1::NetworkConnection, upsf_var_network_connection_t>(arena, name);
+}
+
+int upsf_var_list_network_connections(upsf_arena_t* arena, upsf_var_network_connection_t** elems)
+{
+    return upsf_var_list<wt474_messages::v1::NetworkConnection, upsf_var_network_connection_t>(arena, elems);
+}
+
+upsf_var_shard_t* upsf_var_get_shard(upsf_arena_t* arena, const char* name)
+{
+    return upsf_var_get<wt474_messages::v1::Shard, upsf_var_shard_t>(arena, name);
+}
+
+int upsf_var_list_shards(upsf_arena_t* arena, upsf_var_shard_t** elems)
+{
+    return upsf_var_list<wt474_messages::v1::Shard, upsf_var_shard_t>(arena, elems);
+}
+
+upsf_var_session_context_t* upsf_var_get_session_context(upsf_arena_t* arena, const char* name)
+{
+    return upsf_var_get<wt474_messages::v1::SessionContext, upsf_var_session_context_t>(arena, name);
+}
+
+int upsf_var_list_session_contexts(upsf_arena_t* arena, upsf_var_session_context_t** elems)
+{
+    return upsf_var_list<wt474_messages::v1::SessionContext, upsf_var_session_context_t>(arena, elems);
+}
+
+/******************************************************************
+ * List cursors
+ ******************************************************************/
+
+/**
+ * cursor over a single ReadV1 stream, owns the stream and the item
+ * instance reused for reading
+ */
+struct upsf_list_cursor_s {
+    upsf_list_cursor_s(
+        wt474_upsf_service::v1::ItemType itemtype,
+        std::unique_ptr<upsf::UpsfReader> reader)
+        : itemtype(itemtype)
+        , reader(std::move(reader)) {};
+
+    // item type listed
+    wt474_upsf_service::v1::ItemType itemtype;
+    // stream reader
+    std::unique_ptr<upsf::UpsfReader> reader;
+    // item read last
+    wt474_messages::v1::Item item;
+};
+
+/**
+ * open a list stream for item type M
+ */
+template <typename M>
+static upsf_list_cursor_t* upsf_list_begin()
+{
+    /* get UpsfSlot instance */
+    pthread_t tid = pthread_self();
+    std::shared_lock rlock(upsf_slots_mutex);
+    if (upsf_slots.find(tid) == upsf_slots.end()) {
+        return nullptr;
+    }
+    UpsfSlot* slot = upsf_slots[tid].get();
+    std::unique_lock slock(slot->upsf_slot_mutex);
+
+    wt474_upsf_service::v1::ReadReq req;
+    req.add_itemtype(upsf::message_item_type<M>());
+    req.set_watch(false);
+
+    /* stream uses its own grpc stub, slot is not locked while reading */
+    return new upsf_list_cursor_s(upsf::message_item_type<M>(), slot->client->NewReader(req));
+}
+
+/**
+ * map up to n_elems items of type M from the stream into elems
+ */
+template <typename M, typename C>
+static int upsf_list_next(upsf_list_cursor_t* cursor, C* elems, size_t n_elems)
+{
+    /* sanity check */
+    if (!cursor || !elems || cursor->itemtype != upsf::message_item_type<M>()) {
+        return -1;
+    }
+
+    size_t i = 0;
+    while (i < n_elems) {
+        if (!cursor->reader->Read(cursor->item)) {
+            /* end of stream, an error is reported once no items are left */
+            if (!cursor->reader->Finish() && (i == 0)) {
+                return -1;
+            }
+            break;
+        }
+        const M* m = upsf::item_message<M>(cursor->item);
+        if (!m) {
+            continue;
+        }
+
+        /* map cpp-object to c-struct */
+        upsf::UpsfMapping::map(*m, elems[i]);
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " reply[" << i << "]=" << m->name() << std::endl;
+        i++;
+    }
+
+    return i;
+}
+
+/**
+ * close a list stream, cancels it if not read until its end; the cursor
+ * is released even if closed by the end function of another item type
+ */
+template <typename M>
+static int upsf_list_end(upsf_list_cursor_t* cursor)
+{
+    /* sanity check */
+    if (!cursor) {
+        return -1;
+    }
+
+    bool result = cursor->reader->Finish();
+    bool matches = (cursor->itemtype == upsf::message_item_type<M>());
+    delete cursor;
+
+    return (result && matches) ? 0 : -1;
+}
+
+upsf_list_cursor_t* upsf_list_service_gateways_begin(void)
+{
+    return upsf_list_begin<wt474_messages::v1::ServiceGateway>();
+}
+
+int upsf_list_service_gateways_next(upsf_list_cursor_t* cursor, upsf_service_gateway_t* elems, size_t n_elems)
+{
+    return upsf_list_next<wt474_messages::v1::ServiceGateway, upsf_service_gateway_t>(cursor, elems, n_elems);
+}
+
+int upsf_list_service_gateways_end(upsf_list_cursor_t* cursor)
+{
+    return upsf_list_end<wt474_messages::v1::ServiceGateway>(cursor);
+}
+
+upsf_list_cursor_t* upsf_list_service_gateway_user_planes_begin(void)
+{
+    return upsf_list_begin<wt474_messages::v1::ServiceGatewayUserPlane>();
+}
+
+int upsf_list_service_gateway_user_planes_next(upsf_list_cursor_t* cursor, upsf_service_gateway_user_plane_t* elems, size_t n_elems)
+{
+    return upsf_list_next<wt474_messages::v1::ServiceGatewayUserPlane, upsf_service_gateway_user_plane_t>(cursor, elems, n_elems);
+}
+
+int upsf_list_service_gateway_user_planes_end(upsf_list_cursor_t* cursor)
+{
+    return upsf_list_end<wt474_messages::v1::ServiceGatewayUserPlane>(cursor);
+}
+
+upsf_list_cursor_t* upsf_list_traffic_steering_functions_begin(void)
+{
+    return upsf_list_begin<wt474_messages::v1::TrafficSteeringFunction>();
+}
+
+int upsf_list_traffic_steering_functions_next(upsf_list_cursor_t* cursor, upsf_traffic_steering_function_t* elems, size_t n_elems)
+{
+    return upsf_list_next<wt474_messages::v1::TrafficSteeringFunction, upsf_traffic_steering_function_t>(cursor, elems, n_elems);
+}
+
+int upsf_list_traffic_steering_functions_end(upsf_list_cursor_t* cursor)
+{
+    return upsf_list_end<wt474_messages::v1::TrafficSteeringFunction>(cursor);
+}
+
+upsf_list_cursor_t* upsf_list_network_connections_begin(void)
+{
+    return upsf_list_begin<wt474_messages::v1::NetworkConnection>();
+}
+
+int upsf_list_network_connections_next(upsf_list_cursor_t* cursor, upsf_network_connection_t* elems, size_t n_elems)
+{
+    return upsf_list_next<wt474_messages::v1::NetworkConnection, upsf_network_connection_t>(cursor, elems, n_elems);
+}
+
+int upsf_list_network_connections_end(upsf_list_cursor_t* cursor)
+{
+    return upsf_list_end<wt474_messages::v1::NetworkConnection>(cursor);
+}
+
+upsf_list_cursor_t* upsf_list_shards_begin(void)
+{
+    return upsf_list_begin<wt474_messages::v1::Shard>();
+}
+
+int upsf_list_shards_next(upsf_list_cursor_t* cursor, upsf_shard_t* elems, size_t n_elems)
+{
+    return upsf_list_next<wt474_messages::v1::Shard, upsf_shard_t>(cursor, elems, n_elems);
+}
+
+int upsf_list_shards_end(upsf_list_cursor_t* cursor)
+{
+    return upsf_list_end<wt474_messages::v1::Shard>(cursor);
+}
+
+upsf_list_cursor_t* upsf_list_session_contexts_begin(void)
+{
+    return upsf_list_begin<wt474_messages::v1::SessionContext>();
+}
+
+int upsf_list_session_contexts_next(upsf_list_cursor_t* cursor, upsf_session_context_t* elems, size_t n_elems)
+{
+    return upsf_list_next<wt474_messages::v1::SessionContext, upsf_session_context_t>(cursor, elems, n_elems);
+}
+
+int upsf_list_session_contexts_end(upsf_list_cursor_t* cursor)
+{
+    return upsf_list_end<wt474_messages::v1::SessionContext>(cursor);
+}
+
+/******************************************************************
+ * Count, Exists
+ ******************************************************************/
+
+/**
+ * build ReadReq for items of type M from filter, an optional name
+ * replaces the filter's names
+ */
+template <typename M>
+static void upsf_query_request(
+    wt474_upsf_service::v1::ReadReq& req,
+    const char* name,
+    const upsf_subscribe_filter_t* filter)
+{
+    upsf::UpsfSubscriber subscriber(/*watch=*/false);
+    std::vector<wt474_upsf_service::v1::ItemType> itemtypes{ upsf::message_item_type<M>() };
+    upsf_set_subscribe_filter(subscriber, filter, itemtypes);
+
+    /* item type is implied by the caller, no states match all states */
+    subscriber.itemtypes = itemtypes;
+    if (!filter || filter->derived_states_size == 0) {
+        subscriber.derivedstates.clear();
+    }
+    if (name) {
+        subscriber.names.assign(1, std::string(name));
+    }
+
+    subscriber.get_request(req);
+}
+
+/**
+ * count items of type M matching filter
+ */
+template <typename M>
+static int upsf_count(const upsf_subscribe_filter_t* filter)
+{
+    wt474_upsf_service::v1::ReadReq req;
+    upsf_query_request<M>(req, nullptr, filter);
+
+    /* answered by the shared memory replica if attached, unless filtering by parent */
+    std::shared_ptr<upsf::UpsfShmCache> shm = std::atomic_load(&upsf_shm_cache);
+    size_t count = 0;
+    if (shm && shm->view().count(req, count)) {
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " shm count=" << count << std::endl;
+        return count;
+    }
+
+    /* get UpsfSlot instance */
+    pthread_t tid = pthread_self();
+    std::shared_lock rlock(upsf_slots_mutex);
+    if (upsf_slots.find(tid) == upsf_slots.end()) {
+        return -1;
+    }
+    UpsfSlot* slot = upsf_slots[tid].get();
+    std::unique_lock slock(slot->upsf_slot_mutex);
+
+    /* call upsf client instance */
+    if (!slot->client->Count(req, count)) {
+        return -1;
+    }
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " count=" << count << std::endl;
+
+    return count;
+}
+
+/**
+ * check for an item of type M matching name and filter
+ */
+template <typename M>
+static int upsf_exists(const char* name, const upsf_subscribe_filter_t* filter)
+{
+    wt474_upsf_service::v1::ReadReq req;
+    upsf_query_request<M>(req, name, filter);
+
+    /* answered by the shared memory replica if attached, unless filtering by parent */
+    std::shared_ptr<upsf::UpsfShmCache> shm = std::atomic_load(&upsf_shm_cache);
+    bool exists = false;
+    if (shm && shm->view().exists(req, exists)) {
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " shm exists=" << exists << std::endl;
+        return exists ? 1 : 0;
+    }
+
+    /* get UpsfSlot instance */
+    pthread_t tid = pthread_self();
+    std::shared_lock rlock(upsf_slots_mutex);
+    if (upsf_slots.find(tid) == upsf_slots.end()) {
+        return -1;
+    }
+    UpsfSlot* slot = upsf_slots[tid].get();
+    std::unique_lock slock(slot->upsf_slot_mutex);
+
+    /* call upsf client instance */
+    if (!slot->client->Exists(req, exists)) {
+        return -1;
+    }
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " exists=" << exists << std::endl;
+
+    return exists ? 1 : 0;
+}
+
+int upsf_count_service_gateways(const upsf_subscribe_filter_t* filter)
+{
+    return upsf_count<wt474_messages::v1::ServiceGateway>(filter);
+}
+
+int upsf_exists_service_gateway(const char* name, const upsf_subscribe_filter_t* filter)
+{
+    return upsf_exists<wt474_messages::v1::ServiceGateway>(name, filter);
+}
+
+int upsf_count_service_gateway_user_planes(const upsf_subscribe_filter_t* filter)
+{
+    return upsf_count<wt474_messages::v1::ServiceGatewayUserPlane>(filter);
+}
+
+int upsf_exists_service_gateway_user_plane(const char* name, const upsf_subscribe_filter_t* filter)
+{
+    return upsf_exists<wt474_messages::v1::ServiceGatewayUserPlane>(name, filter);
+}
+
+int upsf_count_traffic_steering_functions(const upsf_subscribe_filter_t* filter)
+{
+    return upsf_count<wt474_messages::v1::TrafficSteeringFunction>(filter);
+}
+
+int upsf_exists_traffic_steering_function(const char* name, const upsf_subscribe_filter_t* filter)
+{
+    return upsf_exists<wt474_messages::v1::TrafficSteeringFunction>(name, filter);
+}
+
+int upsf_count_network_connections(const upsf_subscribe_filter_t* filter)
+{
+    return upsf_count<wt474_messages::v1::NetworkConnection>(filter);
+}
+
+int upsf_exists_network_connection(const char* name, const upsf_subscribe_filter_t* filter)
+{
+    return upsf_exists<wt474_messages::v1::NetworkConnection>(name, filter);
+}
+
+int upsf_count_shards(const upsf_subscribe_filter_t* filter)
+{
+    return upsf_count<wt474_messages::v1::Shard>(filter);
+}
+
+int upsf_exists_shard(const char* name, const upsf_subscribe_filter_t* filter)
+{
+    return upsf_exists<wt474_messages::v1::Shard>(name, filter);
+}
+
+int upsf_count_session_contexts(const upsf_subscribe_filter_t* filter)
+{
+    return upsf_count<wt474_messages::v1::SessionContext>(filter);
+}
+
+int upsf_exists_session_context(const char* name, const upsf_subscribe_filter_t* filter)
+{
+    return upsf_exists<wt474_messages::v1::SessionContext>(name, filter);
+}
+
+/******************************************************************
+ * Parallel lists
+ ******************************************************************/
+
+/**
+ * UpsfListMapper maps list items in chunks on a pool of worker threads
+ * while the caller's thread keeps receiving from the stream. Every chunk
+ * covers a distinct index range of the output array, so workers never
+ * share an output element.
+ */
+template <typename M, typename C>
+class UpsfListMapper final {
+public:
+    UpsfListMapper(
+        C* elems,
+        size_t n_elems,
+        size_t n_workers)
+        : elems(elems)
+        , n_elems(n_elems)
+        , n_workers(n_workers)
+        , stopped(false)
+    {
+        for (size_t i = 0; i < n_workers; i++) {
+            workers.emplace_back(&UpsfListMapper::work, this);
+        }
+    };
+
+    ~UpsfListMapper()
+    {
+        stop();
+    };
+
+public:
+    /**
+     * queue chunk of items starting at output index base, blocks while the queue is full
+     */
+    void enqueue(
+        size_t base,
+        std::vector<wt474_messages::v1::Item>&& chunk)
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        queue_space.wait(lock, [this] { return queue.size() < UPSF_LIST_QUEUE_DEPTH * n_workers; });
+        queue.emplace_back(base, std::move(chunk));
+        queue_ready.notify_one();
+    };
+
+    /**
+     * wait for all queued chunks being mapped and join workers
+     */
+    void stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stopped = true;
+            queue_ready.notify_all();
+        }
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    };
+
+private:
+    /**
+     * worker: map chunks until stopped and queue is drained
+     */
+    void work()
+    {
+        while (true) {
+            std::pair<size_t, std::vector<wt474_messages::v1::Item>> chunk;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_ready.wait(lock, [this] { return stopped || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                chunk = std::move(queue.front());
+                queue.pop_front();
+                queue_space.notify_one();
+            }
+
+            /* map cpp-objects to c-structs, reader queues items of type M only */
+            size_t index = chunk.first;
+            for (const auto& item : chunk.second) {
+                if (index >= n_elems) {
+                    break;
+                }
+                upsf::UpsfMapping::map(*upsf::item_message<M>(item), elems[index++]);
+            }
+        }
+    };
+
+private:
+    // output array
+    C* elems;
+    // output array capacity
+    size_t n_elems;
+    // number of workers
+    size_t n_workers;
+    // worker threads
+    std::vector<std::thread> workers;
+    // chunks queued for mapping
+    std::deque<std::pair<size_t, std::vector<wt474_messages::v1::Item>>> queue;
+    // queue mutex
+    std::mutex queue_mutex;
+    // queue not empty or stopped
+    std::condition_variable queue_ready;
+    // queue not full
+    std::condition_variable queue_space;
+    // no more chunks
+    bool stopped;
+};
+
+/**
+ * list items of type M, mapping overlaps receiving and runs on n_workers threads
+ */
+template <typename M, typename C>
+static int upsf_list_parallel(C* elems, size_t n_elems, size_t n_workers)
+{
+    /* target buffer */
+    if (!elems) {
+        return -1;
+    }
+
+    /* get UpsfSlot instance */
+    pthread_t tid = pthread_self();
+    std::shared_lock rlock(upsf_slots_mutex);
+    if (upsf_slots.find(tid) == upsf_slots.end()) {
+        return -1;
+    }
+    UpsfSlot* slot = upsf_slots[tid].get();
+    std::unique_lock slock(slot->upsf_slot_mutex);
+
+    if (n_workers == 0) {
+        n_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    wt474_upsf_service::v1::ReadReq req;
+    req.add_itemtype(upsf::message_item_type<M>());
+    req.set_watch(false);
+
+    std::unique_ptr<upsf::UpsfReader> reader = slot->client->NewReader(req);
+    UpsfListMapper<M, C> mapper(elems, n_elems, n_workers);
+
+    /* receive items, hand over full chunks to workers, count items beyond capacity only */
+    size_t count = 0;
+    std::vector<wt474_messages::v1::Item> chunk;
+    chunk.reserve(UPSF_LIST_CHUNK_SIZE);
+    wt474_messages::v1::Item item;
+    while (reader->Read(item)) {
+        if (!upsf::item_message<M>(item)) {
+            continue;
+        }
+        if (count++ >= n_elems) {
+            continue;
+        }
+        chunk.emplace_back();
+        chunk.back().Swap(&item);
+        if (chunk.size() == UPSF_LIST_CHUNK_SIZE) {
+            mapper.enqueue(count - chunk.size(), std::move(chunk));
+            chunk = std::vector<wt474_messages::v1::Item>();
+            chunk.reserve(UPSF_LIST_CHUNK_SIZE);
+        }
+    }
+    if (!chunk.empty()) {
+        mapper.enqueue(std::min(count, n_elems) - chunk.size(), std::move(chunk));
+    }
+    mapper.stop();
+
+    if (!reader->Finish()) {
+        return -1;
+    }
+
+    /* clear remaining buffer */
+    if (count < n_elems) {
+        memset(&elems[count], 0, sizeof(C) * (n_elems - count));
+    }
+    VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " count=" << count << " workers=" << n_workers << std::endl;
+
+    return count;
+}
+
+int upsf_list_service_gateways_parallel(upsf_service_gateway_t* elems, size_t n_elems, size_t n_workers)
+{
+    return upsf_list_parallel<wt474_messages::v1::ServiceGateway, upsf_service_gateway_t>(elems, n_elems, n_workers);
+}
+
+int upsf_list_service_gateway_user_planes_parallel(upsf_service_gateway_user_plane_t* elems, size_t n_elems, size_t n_workers)
+{
+    return upsf_list_parallel<wt474_messages::v1::ServiceGatewayUserPlane, upsf_service_gateway_user_plane_t>(elems, n_elems, n_workers);
+}
+
+int upsf_list_traffic_steering_functions_parallel(upsf_traffic_steering_function_t* elems, size_t n_elems, size_t n_workers)
+{
+    return upsf_list_parallel<wt474_messages::v1::TrafficSteeringFunction, upsf_traffic_steering_function_t>(elems, n_elems, n_workers);
+}
+
+int upsf_list_network_connections_parallel(upsf_network_connection_t* elems, size_t n_elems, size_t n_workers)
+{
+    return upsf_list_parallel<wt474_messages::v1::NetworkConnection, upsf_network_connection_t>(elems, n_elems, n_workers);
+}
+
+int upsf_list_shards_parallel(upsf_shard_t* elems, size_t n_elems, size_t n_workers)
+{
+    return upsf_list_parallel<wt474_messages::v1::Shard, upsf_shard_t>(elems, n_elems, n_workers);
+}
+
+int upsf_list_session_contexts_parallel(upsf_session_context_t* elems, size_t n_elems, size_t n_workers)
+{
+    return upsf_list_parallel<wt474_messages::v1::SessionContext, upsf_session_context_t>(elems, n_elems, n_workers);
+}
@@ -0,0 +1,1255 @@
+/* upsf_cache.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_CACHE_HPP
+#define UPSF_CACHE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "upsf.hpp"
+#include "upsf_intern.hpp"
+#include "upsf_item.hpp"
+
+namespace upsf {
+
+/**
+ * UpsfEpoch implements epoch based reclamation for objects read without
+ * locks. Readers pin the current epoch while accessing shared objects, a
+ * writer retires unpublished objects with the epoch of their removal and
+ * frees them once no reader pinned at or before that epoch remains. All
+ * caches share a single epoch domain with one reader slot per thread,
+ * acquired on a thread's first read. Slots are allocated in blocks added
+ * on demand, so the number of reading threads is not limited.
+ */
+class UpsfEpoch {
+
+public:
+    // reader slots allocated at once
+    static constexpr size_t slots_per_block = 64;
+
+    /**
+   * pin current epoch for the calling thread, pins nest
+   */
+    static void pin()
+    {
+        Reader& reader = get_reader();
+        if (reader.depth++ == 0) {
+            reader.slot->epoch.store(domain().epoch.load());
+        }
+    };
+
+    /**
+   * release pinned epoch of the calling thread
+   */
+    static void unpin()
+    {
+        Reader& reader = get_reader();
+        if (--reader.depth == 0) {
+            reader.slot->epoch.store(0);
+        }
+    };
+
+    /**
+   * advance epoch, returns the epoch objects unpublished before are retired with
+   */
+    static uint64_t advance()
+    {
+        return domain().epoch.fetch_add(1);
+    };
+
+    /**
+   * check whether objects retired with epoch may be freed
+   */
+    static bool quiescent(
+        uint64_t epoch)
+    {
+        for (Block* block = domain().blocks.load(); block; block = block->next) {
+            for (auto& slot : block->slots) {
+                uint64_t pinned = slot.epoch.load();
+                if (pinned != 0 && pinned <= epoch) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+private:
+    struct alignas(64) Slot {
+        // pinned epoch, 0: not reading
+        std::atomic<uint64_t> epoch { 0 };
+        // slot owned by a thread
+        std::atomic<bool> used { false };
+    };
+
+    struct Block {
+        // reader slots
+        std::array<Slot, slots_per_block> slots;
+        // next block, immutable once published
+        Block* next = nullptr;
+    };
+
+    struct Domain {
+        Domain()
+            : blocks(new Block())
+        {
+        };
+
+        // global epoch, starts at 1 as 0 denotes an idle slot
+        std::atomic<uint64_t> epoch { 1 };
+        // list of reader slot blocks, blocks are never freed as threads
+        // still running at exit release their slots after static destruction
+        std::atomic<Block*> blocks;
+    };
+
+    struct Reader {
+        Reader()
+            : slot(nullptr)
+            , depth(0)
+        {
+            /* claim a free slot, add a block if none is left */
+            Block* head = domain().blocks.load();
+            while (!(slot = claim(head))) {
+                Block* block = new Block();
+                block->slots[0].used.store(true);
+                block->next = head;
+                if (domain().blocks.compare_exchange_strong(head, block)) {
+                    slot = &block->slots[0];
+                    break;
+                }
+                /* another thread added a block, head was reloaded */
+                delete block;
+            }
+        };
+
+        ~Reader()
+        {
+            slot->epoch.store(0);
+            slot->used.store(false);
+        };
+
+        static Slot* claim(
+            Block* head)
+        {
+            for (Block* block = head; block; block = block->next) {
+                for (auto& it : block->slots) {
+                    bool used = false;
+                    if (it.used.compare_exchange_strong(used, true)) {
+                        return &it;
+                    }
+                }
+            }
+            return nullptr;
+        };
+
+        // claimed slot
+        Slot* slot;
+        // pin nesting depth
+        unsigned depth;
+    };
+
+    static Domain& domain()
+    {
+        static Domain domain;
+        return domain;
+    };
+
+    static Reader& get_reader()
+    {
+        static thread_local Reader reader;
+        return reader;
+    };
+};
+
+/**
+ * UpsfCache is a local replica of UPSF items with snapshot isolated reads.
+ *
+ * Items are stored as shared immutable instances in a persistent hash trie
+ * per item type. A writer applies changes by copying the path to the
+ * changed entry only and publishes the new version atomically, readers
+ * never take a lock and see a consistent state of all items for the
+ * lifetime of a View. Unpublished versions are freed by epoch based
+ * reclamation once no View refers to them any longer.
+ *
+ * Entries do not copy item names. The name an item refers to (session
+ * context: shard, shard: user plane, user plane: service gateway) is kept
+ * as id of the global UpsfInterner, so references are compared by id and
+ * resolved by id without hashing the name again.
+ *
+ * As an UpsfSubscriber the cache is fed by UpsfClient::ReadV1() or an
+ * UpsfSubscriptionHub, items in derived state deleted are removed. Writers
+ * are serialized by a mutex not used by readers.
+ */
+class UpsfCache : public UpsfSubscriber {
+
+public:
+    typedef std::shared_ptr<const wt474_messages::v1::Item> ItemPtr;
+
+    // number of item types
+    static constexpr size_t num_itemtypes = 6;
+
+private:
+    /**
+   * trie node: branch with bitmap indexed children or leaf with entries
+   * of identical hash
+   */
+    struct Node;
+    typedef std::shared_ptr<const Node> NodePtr;
+
+    struct Entry {
+        // item, also holding the name
+        ItemPtr item;
+        // interned name of the item referred to
+        UpsfInterner::id_t ref;
+        // interned set of service groups
+        UpsfSetInterner::id_t groups;
+    };
+
+    struct Node {
+        // leaf: full hash of all entries
+        size_t hash = 0;
+        // branch: occupied child indices
+        uint32_t bitmap = 0;
+        // branch: children in index order
+        std::vector<NodePtr> children;
+        // leaf: entries
+        std::vector<Entry> entries;
+
+        bool is_leaf() const
+        {
+            return bitmap == 0;
+        };
+    };
+
+    // bits of hash consumed per trie level
+    static constexpr unsigned bits = 5;
+
+    /**
+   * published version of all items
+   */
+    struct Snapshot {
+        std::array<NodePtr, num_itemtypes> roots;
+        std::array<size_t, num_itemtypes> sizes {};
+        uint64_t revision = 0;
+        // number of changes per item type, never reset
+        std::array<uint64_t, num_itemtypes> revisions {};
+        // latest metadata.last_updated of all items applied
+        google::protobuf::Timestamp last_updated;
+    };
+
+public:
+    /**
+   * View provides lock-free reads of a consistent version of the cache,
+   * pointers returned remain valid while the view exists, a view must be
+   * destroyed by the thread that created it
+   */
+    class View {
+
+    public:
+        View(
+            const UpsfCache& cache)
+        {
+            UpsfEpoch::pin();
+            snapshot = cache.snapshot.load();
+        };
+
+        ~View()
+        {
+            UpsfEpoch::unpin();
+        };
+
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+
+    public:
+        /**
+       * find item by type and name, nullptr if not cached
+       */
+        const wt474_messages::v1::Item* find(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name) const
+        {
+            const ItemPtr* item = lookup(itemtype, name);
+            return item ? item->get() : nullptr;
+        };
+
+        /**
+       * get shared item instance by type and name, empty if not cached
+       */
+        ItemPtr get(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name) const
+        {
+            const ItemPtr* item = lookup(itemtype, name);
+            return item ? *item : ItemPtr();
+        };
+
+        /**
+       * find item by type and interned name, nullptr if not cached
+       */
+        const wt474_messages::v1::Item* find(
+            wt474_upsf_service::v1::ItemType itemtype,
+            UpsfInterner::id_t name) const
+        {
+            const Entry* entry = lookup(itemtype, name);
+            return entry ? entry->item.get() : nullptr;
+        };
+
+        /**
+       * interned name of the item referred to by an item, UpsfInterner::empty
+       * if none, UpsfInterner::invalid if not cached or not interned as the
+       * interner ran out of ids
+       */
+        UpsfInterner::id_t ref(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name) const
+        {
+            const Entry* entry = lookup(itemtype, std::hash<std::string>()(name), name);
+            return entry ? entry->ref : UpsfInterner::invalid;
+        };
+
+        /**
+       * interned service groups of an item in ascending order, required ones
+       * of a session context, supported ones of a user plane, nullptr if not
+       * cached, e.g. for checking support by std::includes() on ids, a last
+       * UpsfInterner::invalid stands for groups the interner had no id for,
+       * the set is shared by all items with the same service groups
+       */
+        const std::vector<UpsfInterner::id_t>* service_groups(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name) const
+        {
+            static const std::vector<UpsfInterner::id_t> uninterned { UpsfInterner::invalid };
+            const Entry* entry = lookup(itemtype, std::hash<std::string>()(name), name);
+            if (!entry) {
+                return nullptr;
+            }
+            return (entry->groups == UpsfInterner::invalid) ? &uninterned : &UpsfSetInterner::global().set(entry->groups);
+        };
+
+        /**
+       * number of cached items of a type
+       */
+        size_t size(
+            wt474_upsf_service::v1::ItemType itemtype) const
+        {
+            size_t index = itemtype;
+            return (index < num_itemtypes) ? snapshot->sizes[index] : 0;
+        };
+
+        /**
+       * number of changes applied to the cache
+       */
+        uint64_t revision() const
+        {
+            return snapshot->revision;
+        };
+
+        /**
+       * number of changes applied to items of a type
+       */
+        uint64_t revision(
+            wt474_upsf_service::v1::ItemType itemtype) const
+        {
+            size_t index = itemtype;
+            return (index < num_itemtypes) ? snapshot->revisions[index] : 0;
+        };
+
+        /**
+       * latest metadata.last_updated of all items applied to the cache
+       */
+        const google::protobuf::Timestamp& last_updated() const
+        {
+            return snapshot->last_updated;
+        };
+
+        /**
+       * visit all cached items of a type in unspecified order until fn returns false
+       */
+        void for_each(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::function<bool(const ItemPtr&)>& fn) const
+        {
+            size_t index = itemtype;
+            if (index < num_itemtypes && snapshot->roots[index]) {
+                visit(*snapshot->roots[index], fn);
+            }
+        };
+
+        /**
+       * count cached items matching req as UpsfClient::Count() does, false
+       * if req filters by parent, such requests cannot be answered locally
+       */
+        bool count(
+            const wt474_upsf_service::v1::ReadReq& req,
+            size_t& count) const
+        {
+            count = 0;
+            /* without name and state filters the sizes tell */
+            if (req.parent_size() == 0 && req.name_size() == 0 && req.itemstate_size() == 0) {
+                for (size_t index = 0; index < num_itemtypes; index++) {
+                    if (req.itemtype_size() == 0 || std::find(req.itemtype().begin(), req.itemtype().end(), int(index)) != req.itemtype().end()) {
+                        count += snapshot->sizes[index];
+                    }
+                }
+                return true;
+            }
+            return scan(req,
+                [&count](const wt474_messages::v1::Item&) {
+                    count++;
+                    return true;
+                });
+        };
+
+        /**
+       * check for a cached item matching req as UpsfClient::Exists() does,
+       * false if req filters by parent
+       */
+        bool exists(
+            const wt474_upsf_service::v1::ReadReq& req,
+            bool& exists) const
+        {
+            exists = false;
+            return scan(req,
+                [&exists](const wt474_messages::v1::Item&) {
+                    exists = true;
+                    return false;
+                });
+        };
+
+    private:
+        /**
+       * visit items matching req until fn returns false, names are looked
+       * up directly instead of visiting all items of a type
+       */
+        bool scan(
+            const wt474_upsf_service::v1::ReadReq& req,
+            const std::function<bool(const wt474_messages::v1::Item&)>& fn) const
+        {
+            if (req.parent_size() > 0) {
+                return false;
+            }
+            for (size_t index = 0; index < num_itemtypes; index++) {
+                wt474_upsf_service::v1::ItemType itemtype = wt474_upsf_service::v1::ItemType(index);
+                if (req.itemtype_size() > 0 && std::find(req.itemtype().begin(), req.itemtype().end(), itemtype) == req.itemtype().end()) {
+                    continue;
+                }
+                if (req.name_size() > 0) {
+                    for (const auto& name : req.name()) {
+                        const ItemPtr* item = lookup(itemtype, name.value());
+                        if (item && has_state(req, **item) && !fn(**item)) {
+                            return true;
+                        }
+                    }
+                    continue;
+                }
+                bool more = true;
+                for_each(itemtype,
+                    [&req, &fn, &more](const ItemPtr& item) {
+                        more = !has_state(req, *item) || fn(*item);
+                        return more;
+                    });
+                if (!more) {
+                    return true;
+                }
+            }
+            return true;
+        };
+
+        static bool has_state(
+            const wt474_upsf_service::v1::ReadReq& req,
+            const wt474_messages::v1::Item& item)
+        {
+            return req.itemstate_size() == 0 || std::find(req.itemstate().begin(), req.itemstate().end(), item_metadata(item).derived_state()) != req.itemstate().end();
+        };
+
+        const ItemPtr* lookup(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name) const
+        {
+            const Entry* entry = lookup(itemtype, std::hash<std::string>()(name), name);
+            return entry ? &entry->item : nullptr;
+        };
+
+        const Entry* lookup(
+            wt474_upsf_service::v1::ItemType itemtype,
+            UpsfInterner::id_t name) const
+        {
+            const UpsfInterner& interner = UpsfInterner::global();
+            if (name == UpsfInterner::invalid || name >= interner.size()) {
+                return nullptr;
+            }
+            return lookup(itemtype, interner.hash(name), interner.str(name));
+        };
+
+        const Entry* lookup(
+            wt474_upsf_service::v1::ItemType itemtype,
+            size_t hash,
+            const std::string& name) const
+        {
+            return UpsfCache::lookup(*snapshot, itemtype, hash, name);
+        };
+
+        static bool visit(
+            const Node& node,
+            const std::function<bool(const ItemPtr&)>& fn)
+        {
+            for (const auto& entry : node.entries) {
+                if (!fn(entry.item)) {
+                    return false;
+                }
+            }
+            for (const auto& child : node.children) {
+                if (!visit(*child, fn)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+    private:
+        const Snapshot* snapshot;
+    };
+
+public:
+    /**
+   * constructor, subscribes to all item types in all derived states
+   * including deleted ones for tracking removals
+   */
+    UpsfCache()
+        : UpsfSubscriber(/*watch=*/true)
+        , snapshot(new Snapshot())
+    {
+        derivedstates.emplace(derivedstates.end(), wt474_messages::v1::DerivedState::deleting);
+        derivedstates.emplace(derivedstates.end(), wt474_messages::v1::DerivedState::deleted);
+    };
+
+    /**
+   * destructor, no View may exist on the cache anymore
+   */
+    virtual ~UpsfCache()
+    {
+        delete snapshot.load();
+        for (auto& it : retired) {
+            delete it.second;
+        }
+    };
+
+    UpsfCache(const UpsfCache&) = delete;
+    UpsfCache& operator=(const UpsfCache&) = delete;
+
+public:
+    /**
+   * get consistent read-only view
+   */
+    View view() const
+    {
+        return View(*this);
+    };
+
+    /**
+   * get shared item instance by type and name, empty if not cached
+   */
+    ItemPtr get(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name) const
+    {
+        return View(*this).get(itemtype, name);
+    };
+
+    /**
+   * number of cached items of a type
+   */
+    size_t size(
+        wt474_upsf_service::v1::ItemType itemtype) const
+    {
+        return View(*this).size(itemtype);
+    };
+
+    /**
+   * name of the item referred to by an item, empty if none
+   */
+    static const std::string& ref_of(
+        const wt474_messages::v1::Item& item)
+    {
+        static const std::string none;
+
+        switch (item.sssitem_case()) {
+        case wt474_messages::v1::Item::kServiceGatewayUserPlane:
+            return item.service_gateway_user_plane().service_gateway_name();
+        case wt474_messages::v1::Item::kShard:
+            return item.shard().spec().desired_state().service_gateway_user_plane();
+        case wt474_messages::v1::Item::kSessionContext:
+            return item.session_context().spec().desired_state().shard();
+        default:
+            return none;
+        }
+    };
+
+    /**
+   * add or replace an item, an item in derived state deleted is removed
+   */
+    void put(
+        const ItemPtr& item)
+    {
+        apply(std::vector<ItemPtr>(1, item));
+    };
+
+    /**
+   * apply a batch of items, readers see either none or all of them
+   */
+    void apply(
+        const std::vector<ItemPtr>& items)
+    {
+        std::scoped_lock lock(writer_mutex);
+        Snapshot* next = new Snapshot(*snapshot.load());
+
+        for (const auto& item : items) {
+            apply_item(*next, item);
+        }
+        publish(next);
+    };
+
+    /**
+   * add or replace an item unless the cached copy carries the same or a
+   * newer metadata.last_updated, e.g. for the response of a write racing
+   * with the watch stream, returns false if the cached copy was kept
+   */
+    bool put_if_newer(
+        const ItemPtr& item)
+    {
+        wt474_upsf_service::v1::ItemType itemtype;
+        if (!item || !item_type(*item, itemtype)) {
+            return false;
+        }
+
+        std::scoped_lock lock(writer_mutex);
+        const Snapshot* current = snapshot.load();
+        const std::string& name = item_name(*item);
+        const Entry* cached = lookup(*current, itemtype, std::hash<std::string>()(name), name);
+        bool comparable = false;
+        if (cached && !newer(*item, *cached->item, comparable) && comparable) {
+            return false;
+        }
+
+        Snapshot* next = new Snapshot(*current);
+        apply_item(*next, item);
+        publish(next);
+
+        return true;
+    };
+
+    /**
+   * remove an item, returns false if it was not cached
+   */
+    bool erase(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name)
+    {
+        std::scoped_lock lock(writer_mutex);
+        Snapshot* next = new Snapshot(*snapshot.load());
+
+        if (reconciling) {
+            track(std::string(1, char(itemtype)) + name, /*deleted=*/true);
+        }
+        if (!remove(*next, itemtype, name)) {
+            delete next;
+            return false;
+        }
+        publish(next);
+
+        return true;
+    };
+
+    /**
+   * remove all items
+   */
+    void clear()
+    {
+        std::scoped_lock lock(writer_mutex);
+        Snapshot* next = new Snapshot();
+        next->revision = snapshot.load()->revision + 1;
+        bump_revisions(*next);
+        publish(next);
+    };
+
+    /**
+   * replace all items, e.g. by the content of a persisted snapshot,
+   * revision and last_updated are restored as given
+   */
+    void restore(
+        const std::vector<ItemPtr>& items,
+        uint64_t revision,
+        const google::protobuf::Timestamp& last_updated)
+    {
+        std::scoped_lock lock(writer_mutex);
+        Snapshot* next = new Snapshot();
+
+        for (const auto& item : items) {
+            wt474_upsf_service::v1::ItemType itemtype;
+            if (!item || !item_type(*item, itemtype)) {
+                continue;
+            }
+            insert(*next, itemtype, item_name(*item), item);
+        }
+        next->revision = revision;
+        bump_revisions(*next);
+        next->last_updated = last_updated;
+        publish(next);
+    };
+
+    /**
+   * reconcile cached items with a full read from the UPSF while reads
+   * continue to be served from the cache and other writers, e.g. a watch
+   * stream started before reconciling, keep applying changes: items read
+   * are applied in batches unless the cache holds a copy with a newer
+   * metadata.last_updated or the item was deleted by another writer
+   * meanwhile, cached items not present upstream are removed afterwards
+   * unless changed by another writer, returns false on error
+   */
+    bool reconcile(
+        UpsfClient& client)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        {
+            std::scoped_lock lock(writer_mutex);
+            reconciling = true;
+            touched.clear();
+            tombstones.clear();
+        }
+
+        wt474_upsf_service::v1::ReadReq req;
+        for (auto it : itemtypes) {
+            req.add_itemtype(it);
+        }
+        req.set_watch(false);
+
+        std::unordered_set<std::string> seen;
+        std::vector<ItemPtr> batch;
+        grpc::ClientContext context;
+        bool result = client.ReadV1(req, context,
+            [this, &seen, &batch](const ItemPtr& item) {
+                seen.insert(key_of(*item));
+                batch.push_back(item);
+                if (batch.size() == reconcile_batch_size) {
+                    apply_read(batch);
+                    batch.clear();
+                }
+                return true;
+            });
+        apply_read(batch);
+
+        std::scoped_lock lock(writer_mutex);
+        reconciling = false;
+        if (!result) {
+            touched.clear();
+            tombstones.clear();
+            return false;
+        }
+
+        /* remove stale items */
+        Snapshot* next = new Snapshot(*snapshot.load());
+        size_t removed = 0;
+        {
+            View view(*this);
+            for (size_t index = 0; index < num_itemtypes; index++) {
+                view.for_each(wt474_upsf_service::v1::ItemType(index),
+                    [&](const ItemPtr& item) {
+                        std::string key = key_of(*item);
+                        if (!seen.count(key) && !touched.count(key)) {
+                            removed += remove(*next, wt474_upsf_service::v1::ItemType(index), item_name(*item)) ? 1 : 0;
+                        }
+                        return true;
+                    });
+            }
+        }
+        touched.clear();
+        tombstones.clear();
+        publish(next);
+
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " read=" << seen.size() << " removed=" << removed << std::endl;
+
+        return true;
+    };
+
+public:
+    /**
+   * UpsfSubscriber: retain shared item instance
+   */
+    void notify(
+        const ItemPtr& item) override
+    {
+        put(item);
+    };
+
+    void notify(
+        const wt474_messages::v1::Shard& shard) override
+    {
+        std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+        *item->mutable_shard() = shard;
+        put(item);
+    };
+
+    void notify(
+        const wt474_messages::v1::SessionContext& session_context) override
+    {
+        std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+        *item->mutable_session_context() = session_context;
+        put(item);
+    };
+
+    void notify(
+        const wt474_messages::v1::NetworkConnection& network_connection) override
+    {
+        std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+        *item->mutable_network_connection() = network_connection;
+        put(item);
+    };
+
+    void notify(
+        const wt474_messages::v1::ServiceGatewayUserPlane& service_gateway_user_plane) override
+    {
+        std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+        *item->mutable_service_gateway_user_plane() = service_gateway_user_plane;
+        put(item);
+    };
+
+    void notify(
+        const wt474_messages::v1::TrafficSteeringFunction& traffic_steering_function) override
+    {
+        std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+        *item->mutable_traffic_steering_function() = traffic_steering_function;
+        put(item);
+    };
+
+    void notify(
+        const wt474_messages::v1::ServiceGateway& service_gateway) override
+    {
+        std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+        *item->mutable_service_gateway() = service_gateway;
+        put(item);
+    };
+
+private:
+    /**
+   * interned set of the service groups of an item, a service group not
+   * interned as the interner ran out of ids is kept as invalid
+   */
+    static UpsfSetInterner::id_t groups_of(
+        const wt474_messages::v1::Item& item)
+    {
+        UpsfSetInterner::Set groups;
+        const google::protobuf::RepeatedPtrField<std::string>* names = nullptr;
+        if (item.has_session_context()) {
+            names = &item.session_context().spec().required_service_group();
+        } else if (item.has_service_gateway_user_plane()) {
+            names = &item.service_gateway_user_plane().spec().supported_service_group();
+        } else {
+            return UpsfInterner::empty;
+        }
+        groups.reserve(names->size());
+        for (const auto& name : *names) {
+            groups.push_back(UpsfInterner::global().intern(name));
+        }
+        std::sort(groups.begin(), groups.end());
+        groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+        return UpsfSetInterner::global().intern(groups);
+    };
+
+    /**
+   * insert entry into a snapshot
+   */
+    static void insert(
+        Snapshot& s,
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name,
+        const ItemPtr& item)
+    {
+        size_t index = itemtype;
+        bool added = false;
+        Entry entry { item, UpsfInterner::global().intern(ref_of(*item)), groups_of(*item) };
+        s.roots[index] = insert(s.roots[index], std::hash<std::string>()(name), 0, name, entry, added);
+        s.sizes[index] += added ? 1 : 0;
+        s.revision++;
+        s.revisions[index]++;
+
+        /* track latest change seen */
+        const google::protobuf::Timestamp& last_updated = item_metadata(*item).last_updated();
+        if (std::make_pair(last_updated.seconds(), last_updated.nanos()) > std::make_pair(s.last_updated.seconds(), s.last_updated.nanos())) {
+            s.last_updated = last_updated;
+        }
+    };
+
+    /**
+   * find entry in a snapshot, nullptr if not found
+   */
+    static const Entry* lookup(
+        const Snapshot& s,
+        wt474_upsf_service::v1::ItemType itemtype,
+        size_t hash,
+        const std::string& name)
+    {
+        size_t index = itemtype;
+        if (index >= num_itemtypes) {
+            return nullptr;
+        }
+        const Node* node = s.roots[index].get();
+        for (unsigned shift = 0; node && !node->is_leaf(); shift += bits) {
+            uint32_t bit = bit_of(hash, shift);
+            if (!(node->bitmap & bit)) {
+                return nullptr;
+            }
+            node = node->children[__builtin_popcount(node->bitmap & (bit - 1))].get();
+        }
+        if (!node || node->hash != hash) {
+            return nullptr;
+        }
+        for (const auto& entry : node->entries) {
+            if (item_name(*entry.item) == name) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    };
+
+    /**
+   * key of an item unique across item types
+   */
+    static std::string key_of(
+        const wt474_messages::v1::Item& item)
+    {
+        wt474_upsf_service::v1::ItemType itemtype = wt474_upsf_service::v1::ItemType::service_gateway;
+        item_type(item, itemtype);
+        return std::string(1, char(itemtype)) + item_name(item);
+    };
+
+    /**
+   * remove entry from a snapshot, returns false if not found
+   */
+    static bool remove(
+        Snapshot& s,
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name)
+    {
+        size_t index = itemtype;
+        if (index >= num_itemtypes || !s.roots[index]) {
+            return false;
+        }
+        bool removed = false;
+        s.roots[index] = remove(s.roots[index], std::hash<std::string>()(name), 0, name, removed);
+        if (!removed) {
+            return false;
+        }
+        s.sizes[index]--;
+        s.revision++;
+        s.revisions[index]++;
+        return true;
+    };
+
+    static uint32_t bit_of(
+        size_t hash,
+        unsigned shift)
+    {
+        return 1u << ((hash >> shift) & ((1u << bits) - 1));
+    };
+
+    /**
+   * copy path to the entry, share all other nodes
+   */
+    static NodePtr insert(
+        const NodePtr& node,
+        size_t hash,
+        unsigned shift,
+        const std::string& name,
+        const Entry& item,
+        bool& added)
+    {
+        /* empty slot: new leaf */
+        if (!node) {
+            std::shared_ptr<Node> leaf = std::make_shared<Node>();
+            leaf->hash = hash;
+            leaf->entries.push_back(item);
+            added = true;
+            return leaf;
+        }
+
+        if (node->is_leaf()) {
+            /* same hash: replace or append entry */
+            if (node->hash == hash) {
+                std::shared_ptr<Node> leaf = std::make_shared<Node>(*node);
+                for (auto& entry : leaf->entries) {
+                    if (item_name(*entry.item) == name) {
+                        entry = item;
+                        return leaf;
+                    }
+                }
+                leaf->entries.push_back(item);
+                added = true;
+                return leaf;
+            }
+
+            /* different hash: push existing leaf one level down */
+            std::shared_ptr<Node> branch = std::make_shared<Node>();
+            branch->bitmap = bit_of(node->hash, shift);
+            branch->children.push_back(node);
+            return insert(branch, hash, shift, name, item, added);
+        }
+
+        /* branch: copy node, descend into child */
+        std::shared_ptr<Node> branch = std::make_shared<Node>(*node);
+        uint32_t bit = bit_of(hash, shift);
+        size_t pos = __builtin_popcount(branch->bitmap & (bit - 1));
+        if (branch->bitmap & bit) {
+            branch->children[pos] = insert(branch->children[pos], hash, shift + bits, name, item, added);
+        } else {
+            branch->bitmap |= bit;
+            branch->children.insert(branch->children.begin() + pos, insert(nullptr, hash, shift + bits, name, item, added));
+        }
+        return branch;
+    };
+
+    /**
+   * copy path to the entry without it, collapse branches left with a single leaf
+   */
+    static NodePtr remove(
+        const NodePtr& node,
+        size_t hash,
+        unsigned shift,
+        const std::string& name,
+        bool& removed)
+    {
+        if (node->is_leaf()) {
+            if (node->hash != hash) {
+                return node;
+            }
+            for (size_t i = 0; i < node->entries.size(); i++) {
+                if (item_name(*node->entries[i].item) != name) {
+                    continue;
+                }
+                removed = true;
+                if (node->entries.size() == 1) {
+                    return nullptr;
+                }
+                std::shared_ptr<Node> leaf = std::make_shared<Node>(*node);
+                leaf->entries.erase(leaf->entries.begin() + i);
+                return leaf;
+            }
+            return node;
+        }
+
+        uint32_t bit = bit_of(hash, shift);
+        if (!(node->bitmap & bit)) {
+            return node;
+        }
+        size_t pos = __builtin_popcount(node->bitmap & (bit - 1));
+        NodePtr child = remove(node->children[pos], hash, shift + bits, name, removed);
+        if (!removed) {
+            return node;
+        }
+
+        std::shared_ptr<Node> branch = std::make_shared<Node>(*node);
+        if (child) {
+            branch->children[pos] = child;
+        } else {
+            branch->bitmap &= ~bit;
+            branch->children.erase(branch->children.begin() + pos);
+        }
+
+        /* leaves carry their full hash and may move up */
+        if (branch->children.empty()) {
+            return nullptr;
+        }
+        if (branch->children.size() == 1 && branch->children[0]->is_leaf()) {
+            return branch->children[0];
+        }
+        return branch;
+    };
+
+    /**
+   * record a change by a writer other than reconcile(), a deletion leaves
+   * a tombstone until the item is recreated
+   */
+    void track(
+        const std::string& key,
+        bool deleted)
+    {
+        touched.insert(key);
+        if (deleted) {
+            tombstones.insert(key);
+        } else {
+            tombstones.erase(key);
+        }
+    };
+
+    /**
+   * apply a batch of items read by reconcile(): items deleted meanwhile
+   * are not inserted again, a cached copy is replaced by an item with a
+   * newer metadata.last_updated only or, if either lacks last_updated,
+   * when no other writer changed it while reconciling
+   */
+    void apply_read(
+        const std::vector<ItemPtr>& items)
+    {
+        std::scoped_lock lock(writer_mutex);
+        Snapshot* next = new Snapshot(*snapshot.load());
+
+        for (const auto& item : items) {
+            wt474_upsf_service::v1::ItemType itemtype;
+            if (!item || !item_type(*item, itemtype)) {
+                continue;
+            }
+            std::string key = key_of(*item);
+            if (tombstones.count(key)) {
+                continue;
+            }
+            const std::string& name = item_name(*item);
+            const Entry* cached = lookup(*next, itemtype, std::hash<std::string>()(name), name);
+            if (cached) {
+                bool comparable = false;
+                bool replace = newer(*item, *cached->item, comparable);
+                if (comparable ? !replace : touched.count(key) > 0) {
+                    continue;
+                }
+            }
+            if (item_metadata(*item).derived_state() == wt474_messages::v1::DerivedState::deleted) {
+                remove(*next, itemtype, name);
+            } else {
+                insert(*next, itemtype, name, item);
+            }
+        }
+        publish(next);
+    };
+
+    /**
+   * add, replace or remove a single item in a snapshot under construction
+   */
+    void apply_item(
+        Snapshot& next,
+        const ItemPtr& item)
+    {
+        wt474_upsf_service::v1::ItemType itemtype;
+        if (!item || !item_type(*item, itemtype)) {
+            return;
+        }
+        const std::string& name = item_name(*item);
+        bool deleted = (item_metadata(*item).derived_state() == wt474_messages::v1::DerivedState::deleted);
+        if (reconciling) {
+            track(key_of(*item), deleted);
+        }
+        if (deleted) {
+            remove(next, itemtype, name);
+        } else {
+            insert(next, itemtype, name, item);
+        }
+    };
+
+    /**
+   * check whether an item carries a newer metadata.last_updated than
+   * another copy, comparable is false if either lacks last_updated
+   */
+    static bool newer(
+        const wt474_messages::v1::Item& item,
+        const wt474_messages::v1::Item& than,
+        bool& comparable)
+    {
+        const google::protobuf::Timestamp& mine = item_metadata(item).last_updated();
+        const google::protobuf::Timestamp& other = item_metadata(than).last_updated();
+        comparable = (mine.seconds() || mine.nanos()) && (other.seconds() || other.nanos());
+        return comparable && std::make_pair(mine.seconds(), mine.nanos()) > std::make_pair(other.seconds(), other.nanos());
+    };
+
+    /**
+   * advance all per type revisions of a replaced snapshot from the
+   * published one, so a type's revision never repeats
+   */
+    void bump_revisions(
+        Snapshot& next) const
+    {
+        const Snapshot* prev = snapshot.load();
+        for (size_t index = 0; index < num_itemtypes; index++) {
+            next.revisions[index] = prev->revisions[index] + 1;
+        }
+    };
+
+    /**
+   * publish next snapshot, retire the previous one
+   */
+    void publish(
+        Snapshot* next)
+    {
+        Snapshot* prev = snapshot.exchange(next);
+        retired.emplace_back(UpsfEpoch::advance(), prev);
+
+        /* free retired snapshots no reader can refer to anymore */
+        auto it = retired.begin();
+        while (it != retired.end() && UpsfEpoch::quiescent(it->first)) {
+            delete it->second;
+            it++;
+        }
+        retired.erase(retired.begin(), it);
+    };
+
+private:
+    // published snapshot
+    std::atomic<Snapshot*> snapshot;
+    // unpublished snapshots with their retire epoch, ascending
+    std::vector<std::pair<uint64_t, Snapshot*>> retired;
+    // serializes writers
+    std::mutex writer_mutex;
+    // reconcile in progress
+    bool reconciling = false;
+    // keys changed by writers other than reconcile() while reconciling
+    std::unordered_set<std::string> touched;
+    // keys deleted by writers other than reconcile() while reconciling
+    std::unordered_set<std::string> tombstones;
+    // items applied at once while reconciling
+    static constexpr size_t reconcile_batch_size = 1024;
+};
+
+}; // end namespace upsf
+
+#endif
@@ -0,0 +1,290 @@
+/* upsf_cas.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_CAS_HPP
+#define UPSF_CAS_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "upsf.hpp"
+#include "upsf_cache.hpp"
+#include "upsf_hash.hpp"
+#include "upsf_item.hpp"
+
+namespace upsf {
+
+/**
+ * UpsfCompareAndSet updates an item only if it has not been changed since
+ * the caller has read it, i.e. if the metadata.last_updated of the update
+ * equals the one of the current copy.
+ *
+ * The current copy is always read from UPSF right before the update, a
+ * cached copy may lag behind and would let a lost update through when it
+ * still matches a stale expectation. An UpsfCache, if given, is updated
+ * with the reply of each successful update.
+ *
+ * A conflict fails with status ABORTED and returns the current copy in
+ * reply, callers may rebase their change on it and retry right away.
+ * UpdateV1 on the wire is unconditional, so the check is exact only among
+ * writers sharing the same Stripes, which serialize updates of an item.
+ */
+class UpsfCompareAndSet {
+
+public:
+    /**
+   * mutexes serializing updates by item name, may be shared by instances
+   * with their own client
+   */
+    struct Stripes {
+        static constexpr size_t size = 64;
+        std::mutex mutex[size];
+
+        std::mutex& get(
+            const std::string& name)
+        {
+            return mutex[std::hash<std::string>()(name) % size];
+        };
+    };
+
+    /**
+   * constructor, replies of successful updates are put into cache if not null
+   */
+    UpsfCompareAndSet(
+        UpsfClient& client,
+        UpsfCache* cache = nullptr,
+        std::shared_ptr<Stripes> stripes = std::make_shared<Stripes>())
+        : client(client)
+        , cache(cache)
+        , stripes(stripes)
+        , conflicts(0) {};
+
+    /**
+   * conflict status?
+   */
+    static bool is_conflict(
+        const grpc::Status& status)
+    {
+        return status.error_code() == grpc::StatusCode::ABORTED;
+    };
+
+    /**
+   * update item if unchanged, reply contains the updated item on success
+   * and the current copy on conflict
+   */
+    bool UpdateV1(
+        const wt474_messages::v1::Item& item,
+        wt474_messages::v1::Item& reply,
+        grpc::Status& status,
+        const wt474_upsf_service::v1::UpdateReq::UpdateOptions& options = wt474_upsf_service::v1::UpdateReq::UpdateOptions())
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        wt474_upsf_service::v1::ItemType itemtype;
+        if (!item_type(item, itemtype)) {
+            status = grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "empty item");
+            return false;
+        }
+        const std::string& name = item_name(item);
+        const google::protobuf::Timestamp& expected = item_metadata(item).last_updated();
+
+        /* serialize updates of the same item */
+        std::scoped_lock lock(stripes->get(name));
+
+        /* current copy from UPSF, never from the cache */
+        UpsfCache::ItemPtr current;
+        if (!read(itemtype, name, current, status)) {
+            return false;
+        }
+        if (!UpsfHashing::equal(item_metadata(*current).last_updated(), expected)) {
+            conflicts++;
+            reply = *current;
+            status = grpc::Status(grpc::StatusCode::ABORTED, "item " + name + " has been changed");
+            VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " conflict on " << name << std::endl;
+            return false;
+        }
+
+        wt474_upsf_service::v1::UpdateReq req;
+        *req.mutable_item() = item;
+        *req.mutable_update_options() = options;
+        if (!client.UpdateV1(req, reply, status)) {
+            return false;
+        }
+        if (cache) {
+            cache->put_if_newer(std::make_shared<const wt474_messages::v1::Item>(reply));
+        }
+        return true;
+    };
+
+    /**
+   * update shard if unchanged
+   */
+    bool UpdateV1(
+        const wt474_messages::v1::Shard& shard,
+        wt474_messages::v1::Shard& reply,
+        grpc::Status& status,
+        const wt474_upsf_service::v1::UpdateReq::UpdateOptions& options = wt474_upsf_service::v1::UpdateReq::UpdateOptions())
+    {
+        wt474_messages::v1::Item item;
+        wt474_messages::v1::Item result;
+        *item.mutable_shard() = shard;
+        bool success = UpdateV1(item, result, status, options);
+        if (result.has_shard()) {
+            reply = result.shard();
+        }
+        return success;
+    };
+
+    /**
+   * update service gateway user plane if unchanged
+   */
+    bool UpdateV1(
+        const wt474_messages::v1::ServiceGatewayUserPlane& service_gateway_user_plane,
+        wt474_messages::v1::ServiceGatewayUserPlane& reply,
+        grpc::Status& status,
+        const wt474_upsf_service::v1::UpdateReq::UpdateOptions& options = wt474_upsf_service::v1::UpdateReq::UpdateOptions())
+    {
+        wt474_messages::v1::Item item;
+        wt474_messages::v1::Item result;
+        *item.mutable_service_gateway_user_plane() = service_gateway_user_plane;
+        bool success = UpdateV1(item, result, status, options);
+        if (result.has_service_gateway_user_plane()) {
+            reply = result.service_gateway_user_plane();
+        }
+        return success;
+    };
+
+    /**
+   * update session context if unchanged
+   */
+    bool UpdateV1(
+        const wt474_messages::v1::SessionContext& session_context,
+        wt474_messages::v1::SessionContext& reply,
+        grpc::Status& status,
+        const wt474_upsf_service::v1::UpdateReq::UpdateOptions& options = wt474_upsf_service::v1::UpdateReq::UpdateOptions())
+    {
+        wt474_messages::v1::Item item;
+        wt474_messages::v1::Item result;
+        *item.mutable_session_context() = session_context;
+        bool success = UpdateV1(item, result, status, options);
+        if (result.has_session_context()) {
+            reply = result.session_context();
+        }
+        return success;
+    };
+
+    /**
+   * update network connection if unchanged
+   */
+    bool UpdateV1(
+        const wt474_messages::v1::NetworkConnection& network_connection,
+        wt474_messages::v1::NetworkConnection& reply,
+        grpc::Status& status,
+        const wt474_upsf_service::v1::UpdateReq::UpdateOptions& options = wt474_upsf_service::v1::UpdateReq::UpdateOptions())
+    {
+        wt474_messages::v1::Item item;
+        wt474_messages::v1::Item result;
+        *item.mutable_network_connection() = network_connection;
+        bool success = UpdateV1(item, result, status, options);
+        if (result.has_network_connection()) {
+            reply = result.network_connection();
+        }
+        return success;
+    };
+
+    /**
+   * get number of conflicts
+   */
+    uint64_t get_conflicts() const
+    {
+        return conflicts;
+    };
+
+private:
+    /**
+   * read current copy from UPSF, bypassing coalesced reads
+   */
+    bool read(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name,
+        UpsfCache::ItemPtr& current,
+        grpc::Status& status)
+    {
+        wt474_upsf_service::v1::ReadReq req;
+        req.add_itemtype(itemtype);
+        req.add_name()->set_value(name);
+        req.set_watch(false);
+
+        current.reset();
+        grpc::ClientContext context;
+        if (!client.ReadV1(req, context,
+                [&current, &name](const UpsfCache::ItemPtr& item) {
+                    if (item_name(*item) != name) {
+                        return true;
+                    }
+                    current = item;
+                    return false;
+                })
+            && !current) {
+            status = grpc::Status(grpc::StatusCode::UNAVAILABLE, "reading item " + name + " failed");
+            return false;
+        }
+        if (!current) {
+            status = grpc::Status(grpc::StatusCode::NOT_FOUND, "item " + name + " not found");
+            return false;
+        }
+        if (cache) {
+            cache->put_if_newer(current);
+        }
+        return true;
+    };
+
+    // client for reads and updates
+    UpsfClient& client;
+    // cache of current copies, may be null
+    UpsfCache* cache;
+    // mutexes serializing updates by item name
+    std::shared_ptr<Stripes> stripes;
+    // number of conflicts
+    std::atomic<uint64_t> conflicts;
+};
+
+}; // end namespace upsf
+
+#endif
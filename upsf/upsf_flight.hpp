@@ -0,0 +1,178 @@
+/* upsf_flight.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_FLIGHT_HPP
+#define UPSF_FLIGHT_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <grpcpp/support/status.h>
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+namespace upsf {
+
+/**
+ * UpsfSingleFlight coalesces concurrent identical calls: the first caller
+ * for a key performs the call, all callers arriving with the same key
+ * while it is in flight wait for and share its status and result. Results
+ * are not retained once the call has completed. If the call throws, the
+ * waiters get status INTERNAL and the exception propagates to the caller
+ * performing the call.
+ */
+template <typename R>
+class UpsfSingleFlight {
+
+private:
+    struct Flight {
+        // call completed
+        bool done = false;
+        // status of the call
+        grpc::Status status;
+        // result of the call
+        R result;
+    };
+
+public:
+    /**
+   * run fn once for all concurrent callers with an identical key
+   */
+    grpc::Status run(
+        const std::string& key,
+        R& result,
+        const std::function<grpc::Status(R&)>& fn)
+    {
+        std::shared_ptr<Flight> flight;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto it = flights.find(key);
+            if (it != flights.end()) {
+                /* join the call in flight */
+                flight = it->second;
+                coalesced++;
+                cond.wait(lock, [&flight]() { return flight->done; });
+                result = flight->result;
+                return flight->status;
+            }
+            flight = std::make_shared<Flight>();
+            flights.emplace(key, flight);
+        }
+
+        grpc::Status status;
+        try {
+            status = fn(result);
+        } catch (...) {
+            /* waiters must not block on a call that never completes */
+            complete(key, flight, result, grpc::Status(grpc::StatusCode::INTERNAL, "coalesced call failed"));
+            throw;
+        }
+        complete(key, flight, result, status);
+
+        return status;
+    };
+
+    /**
+   * number of calls served by another caller's call
+   */
+    uint64_t get_coalesced() const
+    {
+        return coalesced;
+    };
+
+private:
+    /**
+   * hand status and result to the waiters and retire the flight
+   */
+    void complete(
+        const std::string& key,
+        const std::shared_ptr<Flight>& flight,
+        const R& result,
+        const grpc::Status& status)
+    {
+        std::scoped_lock lock(mutex);
+        flight->result = result;
+        flight->status = status;
+        flight->done = true;
+        flights.erase(key);
+        cond.notify_all();
+    };
+
+private:
+    // calls in flight by key
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights;
+    // mutex and condition for flights
+    std::mutex mutex;
+    std::condition_variable cond;
+    // statistics
+    std::atomic<uint64_t> coalesced { 0 };
+};
+
+/**
+ * UpsfFlights holds the coalesced calls of one or more UpsfClient instances
+ * connected to the same UPSF, e.g. one client per worker thread. Calls are
+ * keyed by the number of writes completed when they were issued, so a call
+ * never joins one started before a preceding write of its caller returned.
+ */
+struct UpsfFlights {
+    // ReadV1 by item type and name
+    UpsfSingleFlight<wt474_messages::v1::Item> reads;
+    // LookupV1 by session context spec
+    UpsfSingleFlight<wt474_messages::v1::SessionContext> lookups;
+    // CreateV1, UpdateV1 and DeleteV1 calls completed
+    std::atomic<uint64_t> writes { 0 };
+
+    /**
+   * key of a call issued now
+   */
+    std::string key_of(
+        const std::string& call) const
+    {
+        std::string key = std::to_string(writes.load());
+        key.push_back(':');
+        key.append(call);
+        return key;
+    };
+};
+
+}; // end namespace upsf
+
+#endif
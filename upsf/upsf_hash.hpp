@@ -0,0 +1,630 @@
+/* upsf_hash.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_HASH_HPP
+#define UPSF_HASH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+namespace upsf {
+
+/**
+ * UpsfHashing provides content hashes and equality of UPSF messages by
+ * direct field access, without serialization or reflection.
+ *
+ * Repeated fields with set semantics are compared and hashed regardless
+ * of their element order: service groups, network connection names,
+ * prefixes and endpoint lists. Map fields are unordered by definition.
+ * Unset sub-messages equal default instances.
+ */
+class UpsfHashing {
+
+public:
+    /****************************************
+   * primitives
+   ****************************************/
+
+    static size_t mix(
+        uint64_t h)
+    {
+        /* splitmix64 finalizer */
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    };
+
+    static void combine(
+        size_t& seed,
+        size_t h)
+    {
+        seed = mix(seed + 0x9e3779b97f4a7c15ULL + h);
+    };
+
+    static size_t hash(
+        const std::string& s)
+    {
+        return std::hash<std::string>()(s);
+    };
+
+    static size_t hash(
+        int64_t v)
+    {
+        return mix(uint64_t(v));
+    };
+
+    /**
+   * order independent hash of a repeated field
+   */
+    template <typename C>
+    static size_t hash_unordered(
+        const C& c)
+    {
+        size_t sum = 0;
+        for (const auto& elem : c) {
+            sum += mix(hash(elem));
+        }
+        return mix(sum + c.size());
+    };
+
+    /**
+   * order independent hash of a map field
+   */
+    template <typename K, typename V>
+    static size_t hash_map(
+        const google::protobuf::Map<K, V>& m)
+    {
+        size_t sum = 0;
+        for (const auto& elem : m) {
+            size_t h = hash(elem.first);
+            combine(h, hash(int64_t(elem.second)));
+            sum += h;
+        }
+        return mix(sum + m.size());
+    };
+
+    static size_t hash_map(
+        const google::protobuf::Map<std::string, std::string>& m)
+    {
+        size_t sum = 0;
+        for (const auto& elem : m) {
+            size_t h = hash(elem.first);
+            combine(h, hash(elem.second));
+            sum += h;
+        }
+        return mix(sum + m.size());
+    };
+
+    /**
+   * order independent equality of repeated fields: same order is checked
+   * first, element-wise matching is used otherwise
+   */
+    template <typename C>
+    static bool equal_unordered(
+        const C& a,
+        const C& b)
+    {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        int n = a.size();
+        int i = 0;
+        while (i < n && equal(a[i], b[i])) {
+            i++;
+        }
+        if (i == n) {
+            return true;
+        }
+        std::vector<bool> used(n, false);
+        for (int k = i; k < n; k++) {
+            int j = i;
+            while (j < n && (used[j] || !equal(a[k], b[j]))) {
+                j++;
+            }
+            if (j == n) {
+                return false;
+            }
+            used[j] = true;
+        }
+        return true;
+    };
+
+    template <typename K, typename V>
+    static bool equal_map(
+        const google::protobuf::Map<K, V>& a,
+        const google::protobuf::Map<K, V>& b)
+    {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (const auto& elem : a) {
+            auto it = b.find(elem.first);
+            if (it == b.end() || !(it->second == elem.second)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    static bool equal(
+        const std::string& a,
+        const std::string& b)
+    {
+        return a == b;
+    };
+
+    /****************************************
+   * common messages
+   ****************************************/
+
+    static size_t hash(
+        const google::protobuf::Timestamp& m)
+    {
+        size_t h = hash(m.seconds());
+        combine(h, hash(int64_t(m.nanos())));
+        return h;
+    };
+
+    static bool equal(
+        const google::protobuf::Timestamp& a,
+        const google::protobuf::Timestamp& b)
+    {
+        return a.seconds() == b.seconds() && a.nanos() == b.nanos();
+    };
+
+    static size_t hash(
+        const wt474_messages::v1::MetaData& m)
+    {
+        size_t h = hash(m.description());
+        combine(h, hash(m.created()));
+        combine(h, hash(m.last_updated()));
+        combine(h, hash(int64_t(m.derived_state())));
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::MetaData& a,
+        const wt474_messages::v1::MetaData& b)
+    {
+        return a.derived_state() == b.derived_state()
+            && equal(a.last_updated(), b.last_updated())
+            && equal(a.created(), b.created())
+            && a.description() == b.description();
+    };
+
+    static size_t hash(
+        const wt474_messages::v1::Maintenance& m)
+    {
+        return hash(int64_t(m.maintenance_req()));
+    };
+
+    static bool equal(
+        const wt474_messages::v1::Maintenance& a,
+        const wt474_messages::v1::Maintenance& b)
+    {
+        return a.maintenance_req() == b.maintenance_req();
+    };
+
+    static size_t hash(
+        const wt474_messages::v1::NetworkConnection::Spec::Endpoint& m)
+    {
+        size_t h = hash(m.endpoint_name());
+        combine(h, hash(int64_t(m.transport_endpoint_case())));
+        switch (m.transport_endpoint_case()) {
+        case wt474_messages::v1::NetworkConnection::Spec::Endpoint::kVtep:
+            combine(h, hash(m.vtep().ip_address()));
+            combine(h, hash(int64_t(m.vtep().udp_port())));
+            combine(h, hash(int64_t(m.vtep().vni())));
+            break;
+        case wt474_messages::v1::NetworkConnection::Spec::Endpoint::kL2Vpn:
+            combine(h, hash(int64_t(m.l2vpn().vpn_id())));
+            break;
+        case wt474_messages::v1::NetworkConnection::Spec::Endpoint::kPortVlan:
+            combine(h, hash(m.port_vlan().logical_port()));
+            combine(h, hash(int64_t(m.port_vlan().svlan())));
+            combine(h, hash(int64_t(m.port_vlan().cvlan())));
+            break;
+        default:
+            break;
+        }
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::NetworkConnection::Spec::Endpoint& a,
+        const wt474_messages::v1::NetworkConnection::Spec::Endpoint& b)
+    {
+        if (a.transport_endpoint_case() != b.transport_endpoint_case() || a.endpoint_name() != b.endpoint_name()) {
+            return false;
+        }
+        switch (a.transport_endpoint_case()) {
+        case wt474_messages::v1::NetworkConnection::Spec::Endpoint::kVtep:
+            return a.vtep().udp_port() == b.vtep().udp_port()
+                && a.vtep().vni() == b.vtep().vni()
+                && a.vtep().ip_address() == b.vtep().ip_address();
+        case wt474_messages::v1::NetworkConnection::Spec::Endpoint::kL2Vpn:
+            return a.l2vpn().vpn_id() == b.l2vpn().vpn_id();
+        case wt474_messages::v1::NetworkConnection::Spec::Endpoint::kPortVlan:
+            return a.port_vlan().svlan() == b.port_vlan().svlan()
+                && a.port_vlan().cvlan() == b.port_vlan().cvlan()
+                && a.port_vlan().logical_port() == b.port_vlan().logical_port();
+        default:
+            return true;
+        }
+    };
+
+    /****************************************
+   * ServiceGateway
+   ****************************************/
+
+    static size_t hash(
+        const wt474_messages::v1::ServiceGateway& m)
+    {
+        size_t h = hash(m.name());
+        combine(h, hash(m.metadata()));
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::ServiceGateway& a,
+        const wt474_messages::v1::ServiceGateway& b)
+    {
+        return a.name() == b.name()
+            && equal(a.metadata(), b.metadata());
+    };
+
+    /****************************************
+   * ServiceGatewayUserPlane
+   ****************************************/
+
+    static size_t hash(
+        const wt474_messages::v1::ServiceGatewayUserPlane& m)
+    {
+        size_t h = hash(m.name());
+        combine(h, hash(m.service_gateway_name()));
+        combine(h, hash(m.metadata()));
+        combine(h, hash(m.maintenance()));
+        combine(h, hash(int64_t(m.spec().max_session_count())));
+        combine(h, hash(int64_t(m.spec().max_shards())));
+        combine(h, hash_unordered(m.spec().supported_service_group()));
+        combine(h, hash(m.spec().default_endpoint()));
+        combine(h, hash(int64_t(m.status().allocated_session_count())));
+        combine(h, hash(int64_t(m.status().allocated_shards())));
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::ServiceGatewayUserPlane& a,
+        const wt474_messages::v1::ServiceGatewayUserPlane& b)
+    {
+        return a.status().allocated_session_count() == b.status().allocated_session_count()
+            && a.status().allocated_shards() == b.status().allocated_shards()
+            && a.spec().max_session_count() == b.spec().max_session_count()
+            && a.spec().max_shards() == b.spec().max_shards()
+            && a.maintenance().maintenance_req() == b.maintenance().maintenance_req()
+            && a.name() == b.name()
+            && a.service_gateway_name() == b.service_gateway_name()
+            && equal(a.metadata(), b.metadata())
+            && equal(a.spec().default_endpoint(), b.spec().default_endpoint())
+            && equal_unordered(a.spec().supported_service_group(), b.spec().supported_service_group());
+    };
+
+    /****************************************
+   * TrafficSteeringFunction
+   ****************************************/
+
+    static size_t hash(
+        const wt474_messages::v1::TrafficSteeringFunction& m)
+    {
+        size_t h = hash(m.name());
+        combine(h, hash(m.metadata()));
+        combine(h, hash(m.spec().default_endpoint()));
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::TrafficSteeringFunction& a,
+        const wt474_messages::v1::TrafficSteeringFunction& b)
+    {
+        return a.name() == b.name()
+            && equal(a.metadata(), b.metadata())
+            && equal(a.spec().default_endpoint(), b.spec().default_endpoint());
+    };
+
+    /****************************************
+   * NetworkConnection
+   ****************************************/
+
+    static size_t hash(
+        const wt474_messages::v1::NetworkConnection& m)
+    {
+        size_t h = hash(m.name());
+        combine(h, hash(m.metadata()));
+        combine(h, hash(m.maintenance()));
+        combine(h, hash(int64_t(m.spec().maximum_supported_quality())));
+        combine(h, hash(int64_t(m.spec().nc_spec_case())));
+        switch (m.spec().nc_spec_case()) {
+        case wt474_messages::v1::NetworkConnection::Spec::kSsPtp:
+            combine(h, hash_unordered(m.spec().ss_ptp().sgup_endpoint()));
+            combine(h, hash(m.spec().ss_ptp().tsf_endpoint()));
+            break;
+        case wt474_messages::v1::NetworkConnection::Spec::kSsMptpc:
+            combine(h, hash_unordered(m.spec().ss_mptpc().sgup_endpoint()));
+            combine(h, hash_unordered(m.spec().ss_mptpc().tsf_endpoint()));
+            break;
+        case wt474_messages::v1::NetworkConnection::Spec::kMsPtp:
+            combine(h, hash(m.spec().ms_ptp().sgup_endpoint()));
+            combine(h, hash(m.spec().ms_ptp().tsf_endpoint()));
+            break;
+        case wt474_messages::v1::NetworkConnection::Spec::kMsMptp:
+            combine(h, hash(m.spec().ms_mptp().sgup_endpoint()));
+            combine(h, hash_unordered(m.spec().ms_mptp().tsf_endpoint()));
+            break;
+        default:
+            break;
+        }
+        combine(h, hash_map(m.status().nc_active()));
+        combine(h, hash(int64_t(m.status().allocated_shards())));
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::NetworkConnection& a,
+        const wt474_messages::v1::NetworkConnection& b)
+    {
+        if (a.spec().nc_spec_case() != b.spec().nc_spec_case()
+            || a.spec().maximum_supported_quality() != b.spec().maximum_supported_quality()
+            || a.status().allocated_shards() != b.status().allocated_shards()
+            || a.maintenance().maintenance_req() != b.maintenance().maintenance_req()
+            || a.name() != b.name()
+            || !equal(a.metadata(), b.metadata())
+            || !equal_map(a.status().nc_active(), b.status().nc_active())) {
+            return false;
+        }
+        switch (a.spec().nc_spec_case()) {
+        case wt474_messages::v1::NetworkConnection::Spec::kSsPtp:
+            return equal(a.spec().ss_ptp().tsf_endpoint(), b.spec().ss_ptp().tsf_endpoint())
+                && equal_unordered(a.spec().ss_ptp().sgup_endpoint(), b.spec().ss_ptp().sgup_endpoint());
+        case wt474_messages::v1::NetworkConnection::Spec::kSsMptpc:
+            return equal_unordered(a.spec().ss_mptpc().sgup_endpoint(), b.spec().ss_mptpc().sgup_endpoint())
+                && equal_unordered(a.spec().ss_mptpc().tsf_endpoint(), b.spec().ss_mptpc().tsf_endpoint());
+        case wt474_messages::v1::NetworkConnection::Spec::kMsPtp:
+            return equal(a.spec().ms_ptp().sgup_endpoint(), b.spec().ms_ptp().sgup_endpoint())
+                && equal(a.spec().ms_ptp().tsf_endpoint(), b.spec().ms_ptp().tsf_endpoint());
+        case wt474_messages::v1::NetworkConnection::Spec::kMsMptp:
+            return equal(a.spec().ms_mptp().sgup_endpoint(), b.spec().ms_mptp().sgup_endpoint())
+                && equal_unordered(a.spec().ms_mptp().tsf_endpoint(), b.spec().ms_mptp().tsf_endpoint());
+        default:
+            return true;
+        }
+    };
+
+    /****************************************
+   * Shard
+   ****************************************/
+
+    static size_t hash(
+        const wt474_messages::v1::Shard& m)
+    {
+        size_t h = hash(m.name());
+        combine(h, hash(m.metadata()));
+        combine(h, hash(int64_t(m.spec().max_session_count())));
+        combine(h, hash(m.spec().virtual_mac()));
+        combine(h, hash(m.spec().desired_state().service_gateway_user_plane()));
+        combine(h, hash_unordered(m.spec().desired_state().network_connection()));
+        combine(h, hash_unordered(m.spec().prefix()));
+        combine(h, hash(int64_t(m.status().allocated_session_count())));
+        combine(h, hash(int64_t(m.status().maximum_allocated_quality())));
+        combine(h, hash_unordered(m.status().service_groups_supported()));
+        combine(h, hash(m.status().current_state().service_gateway_user_plane()));
+        combine(h, hash_map(m.status().current_state().tsf_network_connection()));
+        combine(h, hash(int64_t(m.mbb().mbb_state())));
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::Shard& a,
+        const wt474_messages::v1::Shard& b)
+    {
+        return a.status().allocated_session_count() == b.status().allocated_session_count()
+            && a.status().maximum_allocated_quality() == b.status().maximum_allocated_quality()
+            && a.spec().max_session_count() == b.spec().max_session_count()
+            && a.mbb().mbb_state() == b.mbb().mbb_state()
+            && a.name() == b.name()
+            && equal(a.metadata(), b.metadata())
+            && a.spec().virtual_mac() == b.spec().virtual_mac()
+            && a.spec().desired_state().service_gateway_user_plane() == b.spec().desired_state().service_gateway_user_plane()
+            && a.status().current_state().service_gateway_user_plane() == b.status().current_state().service_gateway_user_plane()
+            && equal_unordered(a.spec().desired_state().network_connection(), b.spec().desired_state().network_connection())
+            && equal_unordered(a.spec().prefix(), b.spec().prefix())
+            && equal_unordered(a.status().service_groups_supported(), b.status().service_groups_supported())
+            && equal_map(a.status().current_state().tsf_network_connection(), b.status().current_state().tsf_network_connection());
+    };
+
+    /****************************************
+   * SessionContext
+   ****************************************/
+
+    static size_t hash(
+        const wt474_messages::v1::SessionContext::Spec& m)
+    {
+        size_t h = hash(m.traffic_steering_function());
+        combine(h, hash_unordered(m.required_service_group()));
+        combine(h, hash(int64_t(m.required_quality())));
+        combine(h, hash(m.circuit_id()));
+        combine(h, hash(m.remote_id()));
+        combine(h, hash(m.session_filter().source_mac_address()));
+        combine(h, hash(int64_t(m.session_filter().svlan())));
+        combine(h, hash(int64_t(m.session_filter().cvlan())));
+        combine(h, hash(m.desired_state().shard()));
+        combine(h, hash(m.network_connection()));
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::SessionContext::Spec& a,
+        const wt474_messages::v1::SessionContext::Spec& b)
+    {
+        return a.required_quality() == b.required_quality()
+            && a.session_filter().svlan() == b.session_filter().svlan()
+            && a.session_filter().cvlan() == b.session_filter().cvlan()
+            && a.circuit_id() == b.circuit_id()
+            && a.remote_id() == b.remote_id()
+            && a.session_filter().source_mac_address() == b.session_filter().source_mac_address()
+            && a.traffic_steering_function() == b.traffic_steering_function()
+            && a.desired_state().shard() == b.desired_state().shard()
+            && a.network_connection() == b.network_connection()
+            && equal_unordered(a.required_service_group(), b.required_service_group());
+    };
+
+    static size_t hash(
+        const wt474_messages::v1::SessionContext& m)
+    {
+        size_t h = hash(m.name());
+        combine(h, hash(m.metadata()));
+        combine(h, hash(m.spec()));
+        combine(h, hash(m.status().current_state().user_plane_shard()));
+        combine(h, hash(m.status().current_state().tsf_shard()));
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::SessionContext& a,
+        const wt474_messages::v1::SessionContext& b)
+    {
+        return a.name() == b.name()
+            && equal(a.spec(), b.spec())
+            && a.status().current_state().user_plane_shard() == b.status().current_state().user_plane_shard()
+            && a.status().current_state().tsf_shard() == b.status().current_state().tsf_shard()
+            && equal(a.metadata(), b.metadata());
+    };
+
+    /****************************************
+   * Item
+   ****************************************/
+
+    static size_t hash(
+        const wt474_messages::v1::Item& m)
+    {
+        size_t h = hash(int64_t(m.sssitem_case()));
+        switch (m.sssitem_case()) {
+        case wt474_messages::v1::Item::kServiceGateway:
+            combine(h, hash(m.service_gateway()));
+            break;
+        case wt474_messages::v1::Item::kServiceGatewayUserPlane:
+            combine(h, hash(m.service_gateway_user_plane()));
+            break;
+        case wt474_messages::v1::Item::kTrafficSteeringFunction:
+            combine(h, hash(m.traffic_steering_function()));
+            break;
+        case wt474_messages::v1::Item::kNetworkConnection:
+            combine(h, hash(m.network_connection()));
+            break;
+        case wt474_messages::v1::Item::kShard:
+            combine(h, hash(m.shard()));
+            break;
+        case wt474_messages::v1::Item::kSessionContext:
+            combine(h, hash(m.session_context()));
+            break;
+        default:
+            break;
+        }
+        return h;
+    };
+
+    static bool equal(
+        const wt474_messages::v1::Item& a,
+        const wt474_messages::v1::Item& b)
+    {
+        if (a.sssitem_case() != b.sssitem_case()) {
+            return false;
+        }
+        switch (a.sssitem_case()) {
+        case wt474_messages::v1::Item::kServiceGateway:
+            return equal(a.service_gateway(), b.service_gateway());
+        case wt474_messages::v1::Item::kServiceGatewayUserPlane:
+            return equal(a.service_gateway_user_plane(), b.service_gateway_user_plane());
+        case wt474_messages::v1::Item::kTrafficSteeringFunction:
+            return equal(a.traffic_steering_function(), b.traffic_steering_function());
+        case wt474_messages::v1::Item::kNetworkConnection:
+            return equal(a.network_connection(), b.network_connection());
+        case wt474_messages::v1::Item::kShard:
+            return equal(a.shard(), b.shard());
+        case wt474_messages::v1::Item::kSessionContext:
+            return equal(a.session_context(), b.session_context());
+        default:
+            return true;
+        }
+    };
+};
+
+/**
+ * hash functor for UPSF messages, e.g.
+ * std::unordered_map<wt474_messages::v1::Shard, T, UpsfHash, UpsfEqual>
+ */
+struct UpsfHash {
+    template <typename M>
+    size_t operator()(
+        const M& m) const
+    {
+        return UpsfHashing::hash(m);
+    };
+};
+
+/**
+ * equality functor for UPSF messages
+ */
+struct UpsfEqual {
+    template <typename M>
+    bool operator()(
+        const M& a,
+        const M& b) const
+    {
+        return UpsfHashing::equal(a, b);
+    };
+};
+
+}; // end namespace upsf
+
+#endif
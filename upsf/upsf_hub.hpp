@@ -0,0 +1,351 @@
+/* upsf_hub.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_HUB_HPP
+#define UPSF_HUB_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "upsf.hpp"
+#include "upsf_item.hpp"
+
+namespace upsf {
+
+/**
+ * UpsfSubscriptionHub serves a single upstream watch stream and fans out
+ * each received item to any number of attached local subscribers. Items
+ * are shared as immutable instances, so the upstream bandwidth and the
+ * number of decoded messages do not grow with the number of subscribers.
+ *
+ * Local subscribers are filtered by their itemtypes, derivedstates and
+ * names, an empty vector matches all. Parent filters are evaluated by the
+ * server only and are not supported for attached subscribers. Subscribers
+ * attached to a running hub receive subsequent items only.
+ */
+class UpsfSubscriptionHub {
+
+public:
+    /**
+   * constructor
+   */
+    UpsfSubscriptionHub(
+        std::shared_ptr<grpc::Channel> channel)
+        : client(channel)
+        , stopped(false)
+        , items_received(0)
+        , items_delivered(0)
+    {
+        /* all item types from the UpsfSubscriber defaults */
+        UpsfSubscriber defaults;
+        itemtypes = defaults.itemtypes;
+        /* in all states including deleting and deleted, so attached caches
+         * and topologies see deletions */
+        derivedstates = {
+            wt474_messages::v1::DerivedState::unknown,
+            wt474_messages::v1::DerivedState::inactive,
+            wt474_messages::v1::DerivedState::active,
+            wt474_messages::v1::DerivedState::updating,
+            wt474_messages::v1::DerivedState::deleting,
+            wt474_messages::v1::DerivedState::deleted
+        };
+    };
+
+    /**
+   * constructor
+   */
+    UpsfSubscriptionHub(
+        std::shared_ptr<grpc::Channel> channel,
+        const std::vector<wt474_upsf_service::v1::ItemType>& itemtypes,
+        const std::vector<wt474_messages::v1::DerivedState>& derivedstates)
+        : client(channel)
+        , itemtypes(itemtypes)
+        , derivedstates(derivedstates)
+        , stopped(false)
+        , items_received(0)
+        , items_delivered(0) {};
+
+    /**
+   * destructor
+   */
+    virtual ~UpsfSubscriptionHub()
+    {
+        stop();
+    };
+
+public:
+    /**
+   * attach a local subscriber, returns false if the subscriber
+   * is already attached or defines a parent filter
+   */
+    bool attach(
+        UpsfSubscriber& subscriber)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        if (!subscriber.parents.empty()) {
+            LOG(WARNING) << "libupsf: " << __FUNCTION__ << " parent filters not supported for local subscribers" << std::endl;
+            return false;
+        }
+
+        std::unique_lock<std::shared_mutex> wlock(subscribers_mutex);
+        if (std::find(subscribers.begin(), subscribers.end(), &subscriber) != subscribers.end()) {
+            return false;
+        }
+        subscribers.push_back(&subscriber);
+
+        return true;
+    };
+
+    /**
+   * detach a local subscriber, returns false if the subscriber was not attached,
+   * no notification is delivered to the subscriber after detach() returns,
+   * may be called from a subscriber's notify()
+   */
+    bool detach(
+        UpsfSubscriber& subscriber)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        {
+            std::unique_lock<std::shared_mutex> wlock(subscribers_mutex);
+            auto it = std::find(subscribers.begin(), subscribers.end(), &subscriber);
+            if (it == subscribers.end()) {
+                return false;
+            }
+            subscribers.erase(it);
+        }
+
+        /* wait for a notification in progress, unless called from it */
+        if (dispatch_thread.load() != std::this_thread::get_id()) {
+            std::scoped_lock<std::mutex> dlock(dispatch_mutex);
+        }
+
+        return true;
+    };
+
+    /**
+   * set callbacks invoked by run(): connected_cb once the upstream watch
+   * stream delivered its first item, i.e. the stream is established and
+   * no change is missed from then on, disconnected_cb when a connected
+   * stream terminates, set before calling run()
+   */
+    void set_callbacks(
+        std::function<void()> connected_cb,
+        std::function<void()> disconnected_cb)
+    {
+        this->connected_cb = connected_cb;
+        this->disconnected_cb = disconnected_cb;
+    };
+
+    /**
+   * serve the upstream watch stream, blocks until stop() is called
+   * or the stream terminates, returns false on error
+   */
+    bool run()
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        wt474_upsf_service::v1::ReadReq req;
+        for (auto it : itemtypes) {
+            req.add_itemtype(it);
+        }
+        for (auto it : derivedstates) {
+            req.add_itemstate(it);
+        }
+        req.set_watch(true);
+
+        {
+            std::scoped_lock lock(context_mutex);
+            if (stopped) {
+                return true;
+            }
+            context = std::make_unique<grpc::ClientContext>();
+        }
+
+        bool connected = false;
+        bool result = client.ReadV1(req, *context,
+            [this, &connected](const std::shared_ptr<const wt474_messages::v1::Item>& item) {
+                if (!connected) {
+                    connected = true;
+                    if (connected_cb) {
+                        connected_cb();
+                    }
+                }
+                dispatch(item);
+                return true;
+            });
+
+        if (connected && disconnected_cb) {
+            disconnected_cb();
+        }
+
+        {
+            std::scoped_lock lock(context_mutex);
+            context.reset();
+        }
+
+        return result;
+    };
+
+    /**
+   * stop serving the upstream watch stream
+   */
+    void stop()
+    {
+        std::scoped_lock lock(context_mutex);
+        stopped = true;
+        if (context) {
+            context->TryCancel();
+        }
+    };
+
+    /**
+   * number of items received from upstream
+   */
+    uint64_t get_items_received() const
+    {
+        return items_received;
+    };
+
+    /**
+   * number of notifications delivered to local subscribers
+   */
+    uint64_t get_items_delivered() const
+    {
+        return items_delivered;
+    };
+
+private:
+    /**
+   * check whether an item passes a local subscriber's filters
+   */
+    static bool matches(
+        const UpsfSubscriber& subscriber,
+        const wt474_messages::v1::Item& item,
+        wt474_upsf_service::v1::ItemType itemtype)
+    {
+        if (!subscriber.itemtypes.empty() && std::find(subscriber.itemtypes.begin(), subscriber.itemtypes.end(), itemtype) == subscriber.itemtypes.end()) {
+            return false;
+        }
+        if (!subscriber.derivedstates.empty() && std::find(subscriber.derivedstates.begin(), subscriber.derivedstates.end(), item_metadata(item).derived_state()) == subscriber.derivedstates.end()) {
+            return false;
+        }
+        if (!subscriber.names.empty() && std::find(subscriber.names.begin(), subscriber.names.end(), item_name(item)) == subscriber.names.end()) {
+            return false;
+        }
+        return true;
+    };
+
+    /**
+   * hand out a shared item to all matching local subscribers
+   */
+    void dispatch(
+        const std::shared_ptr<const wt474_messages::v1::Item>& item)
+    {
+        items_received++;
+
+        wt474_upsf_service::v1::ItemType itemtype;
+        if (!item_type(*item, itemtype)) {
+            return;
+        }
+
+        /* notify outside of subscribers_mutex, so that subscribers may
+         * attach or detach from within notify() */
+        std::scoped_lock<std::mutex> dlock(dispatch_mutex);
+        dispatch_thread.store(std::this_thread::get_id());
+
+        std::vector<UpsfSubscriber*> current;
+        {
+            std::shared_lock<std::shared_mutex> rlock(subscribers_mutex);
+            current = subscribers;
+        }
+        for (auto subscriber : current) {
+            if (!matches(*subscriber, *item, itemtype)) {
+                continue;
+            }
+            /* skip subscribers detached by a previous notify() */
+            {
+                std::shared_lock<std::shared_mutex> rlock(subscribers_mutex);
+                if (std::find(subscribers.begin(), subscribers.end(), subscriber) == subscribers.end()) {
+                    continue;
+                }
+            }
+            items_delivered++;
+            subscriber->notify(item);
+        }
+
+        dispatch_thread.store(std::thread::id());
+    };
+
+private:
+    // upstream client
+    UpsfClient client;
+    // upstream item types
+    std::vector<wt474_upsf_service::v1::ItemType> itemtypes;
+    // upstream derived states
+    std::vector<wt474_messages::v1::DerivedState> derivedstates;
+    // stream established and terminated callbacks
+    std::function<void()> connected_cb;
+    std::function<void()> disconnected_cb;
+    // local subscribers
+    std::vector<UpsfSubscriber*> subscribers;
+    // rwlock for subscribers
+    std::shared_mutex subscribers_mutex;
+    // held while notifying subscribers
+    std::mutex dispatch_mutex;
+    // thread notifying subscribers
+    std::atomic<std::thread::id> dispatch_thread;
+    // context of active upstream stream
+    std::unique_ptr<grpc::ClientContext> context;
+    // mutex for context and stopped
+    std::mutex context_mutex;
+    // stop requested
+    bool stopped;
+    // statistics
+    std::atomic<uint64_t> items_received;
+    std::atomic<uint64_t> items_delivered;
+};
+
+}; // end namespace upsf
+
+#endif
@@ -0,0 +1,351 @@
+/* upsf_intern.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_INTERN_HPP
+#define UPSF_INTERN_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace upsf {
+
+/**
+ * UpsfInterner maps strings to compact 32 bit ids, equal strings get equal
+ * ids, so comparing ids replaces comparing strings. Id 0 is the empty
+ * string.
+ *
+ * Interned strings are never released and keep a fixed address, str() and
+ * hash() are lock-free. Once all ids are used, intern() returns invalid for
+ * new strings and callers fall back to the strings themselves. The interner
+ * is meant for names with a bounded set of values repeated across many
+ * items, like shard, user plane and network connection names referred to by
+ * other items and service groups, not for names of short-lived items like
+ * session contexts.
+ */
+class UpsfInterner {
+
+public:
+    typedef uint32_t id_t;
+
+    // id of the empty string
+    static constexpr id_t empty = 0;
+
+    // id returned by find() for strings not interned
+    static constexpr id_t invalid = std::numeric_limits<id_t>::max();
+
+    /**
+   * process wide instance
+   */
+    static UpsfInterner& global()
+    {
+        static UpsfInterner interner;
+        return interner;
+    };
+
+    /**
+   * constructor, capacity limits the number of strings including the
+   * empty one
+   */
+    UpsfInterner(
+        size_t capacity = max_chunks * chunk_size)
+        : chunks(new std::atomic<Chunk*>[max_chunks])
+        , capacity(std::min(std::max(capacity, size_t(1)), max_chunks * chunk_size))
+        , count(0)
+    {
+        for (size_t i = 0; i < max_chunks; i++) {
+            chunks[i] = nullptr;
+        }
+        intern(std::string_view());
+    };
+
+    /**
+   * destructor
+   */
+    virtual ~UpsfInterner()
+    {
+        for (size_t i = 0; i < max_chunks; i++) {
+            delete chunks[i].load();
+        }
+    };
+
+    UpsfInterner(const UpsfInterner&) = delete;
+    UpsfInterner& operator=(const UpsfInterner&) = delete;
+
+public:
+    /**
+   * get id of a string, interning it if necessary, invalid if the interner
+   * ran out of ids
+   */
+    id_t intern(
+        std::string_view s)
+    {
+        {
+            std::shared_lock rlock(mutex);
+            auto it = ids.find(s);
+            if (it != ids.end()) {
+                return it->second;
+            }
+        }
+
+        std::unique_lock wlock(mutex);
+        auto it = ids.find(s);
+        if (it != ids.end()) {
+            return it->second;
+        }
+
+        id_t id = count.load(std::memory_order_relaxed);
+        if (size_t(id) >= capacity) {
+            return invalid;
+        }
+        Chunk* chunk = chunks[id >> chunk_bits].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new Chunk();
+            chunks[id >> chunk_bits].store(chunk, std::memory_order_release);
+        }
+        size_t pos = id & (chunk_size - 1);
+        chunk->names[pos].assign(s.data(), s.size());
+        chunk->hashes[pos] = std::hash<std::string_view>()(s);
+        ids.emplace(std::string_view(chunk->names[pos]), id);
+        count.store(id + 1, std::memory_order_release);
+        return id;
+    };
+
+    /**
+   * get id of a string without interning it, invalid if not interned
+   */
+    id_t find(
+        std::string_view s) const
+    {
+        std::shared_lock rlock(mutex);
+        auto it = ids.find(s);
+        return it == ids.end() ? invalid : it->second;
+    };
+
+    /**
+   * get string of an id returned by intern() or find()
+   */
+    const std::string& str(
+        id_t id) const
+    {
+        return chunks[id >> chunk_bits].load(std::memory_order_acquire)->names[id & (chunk_size - 1)];
+    };
+
+    /**
+   * get std::hash<std::string> of the string of an id returned by intern()
+   * or find()
+   */
+    size_t hash(
+        id_t id) const
+    {
+        return chunks[id >> chunk_bits].load(std::memory_order_acquire)->hashes[id & (chunk_size - 1)];
+    };
+
+    /**
+   * number of interned strings
+   */
+    size_t size() const
+    {
+        return count.load(std::memory_order_acquire);
+    };
+
+private:
+    // strings per chunk
+    static constexpr unsigned chunk_bits = 12;
+    static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+    // maximum number of chunks
+    static constexpr size_t max_chunks = size_t(1) << 16;
+
+    struct Chunk {
+        std::string names[chunk_size];
+        size_t hashes[chunk_size];
+    };
+
+    // chunks of interned strings, allocated on demand
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks;
+    // maximum number of strings
+    size_t capacity;
+    // number of interned strings
+    std::atomic<id_t> count;
+    // ids by string
+    std::unordered_map<std::string_view, id_t> ids;
+    // rwlock for ids and chunk allocation
+    mutable std::shared_mutex mutex;
+};
+
+/**
+ * UpsfSetInterner maps sorted sets of interned ids to a single id of the
+ * same width, equal sets get equal ids, so an item refers to its set by one
+ * id instead of holding its own copy. Id 0 is the empty set.
+ *
+ * Interned sets are never released and keep a fixed address, set() is
+ * lock-free. Once all ids are used, intern() returns UpsfInterner::invalid
+ * for new sets. Meant for sets with few distinct values repeated across
+ * many items, like the service groups of session contexts and user planes.
+ */
+class UpsfSetInterner {
+
+public:
+    typedef UpsfInterner::id_t id_t;
+    typedef std::vector<id_t> Set;
+
+    /**
+   * process wide instance
+   */
+    static UpsfSetInterner& global()
+    {
+        static UpsfSetInterner interner;
+        return interner;
+    };
+
+    /**
+   * constructor, capacity limits the number of sets including the empty one
+   */
+    UpsfSetInterner(
+        size_t capacity = max_chunks * chunk_size)
+        : chunks(new std::atomic<Chunk*>[max_chunks])
+        , capacity(std::min(std::max(capacity, size_t(1)), max_chunks * chunk_size))
+        , count(0)
+    {
+        for (size_t i = 0; i < max_chunks; i++) {
+            chunks[i] = nullptr;
+        }
+        intern(Set());
+    };
+
+    /**
+   * destructor
+   */
+    virtual ~UpsfSetInterner()
+    {
+        for (size_t i = 0; i < max_chunks; i++) {
+            delete chunks[i].load();
+        }
+    };
+
+    UpsfSetInterner(const UpsfSetInterner&) = delete;
+    UpsfSetInterner& operator=(const UpsfSetInterner&) = delete;
+
+public:
+    /**
+   * get id of a set in ascending order without duplicates, interning it if
+   * necessary, UpsfInterner::invalid if the interner ran out of ids
+   */
+    id_t intern(
+        const Set& set)
+    {
+        std::string key(reinterpret_cast<const char*>(set.data()), set.size() * sizeof(id_t));
+        {
+            std::shared_lock rlock(mutex);
+            auto it = ids.find(key);
+            if (it != ids.end()) {
+                return it->second;
+            }
+        }
+
+        std::unique_lock wlock(mutex);
+        auto it = ids.find(key);
+        if (it != ids.end()) {
+            return it->second;
+        }
+
+        id_t id = count.load(std::memory_order_relaxed);
+        if (size_t(id) >= capacity) {
+            return UpsfInterner::invalid;
+        }
+        Chunk* chunk = chunks[id >> chunk_bits].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new Chunk();
+            chunks[id >> chunk_bits].store(chunk, std::memory_order_release);
+        }
+        chunk->sets[id & (chunk_size - 1)] = set;
+        ids.emplace(std::move(key), id);
+        count.store(id + 1, std::memory_order_release);
+        return id;
+    };
+
+    /**
+   * get set of an id returned by intern()
+   */
+    const Set& set(
+        id_t id) const
+    {
+        return chunks[id >> chunk_bits].load(std::memory_order_acquire)->sets[id & (chunk_size - 1)];
+    };
+
+    /**
+   * number of interned sets
+   */
+    size_t size() const
+    {
+        return count.load(std::memory_order_acquire);
+    };
+
+private:
+    // sets per chunk
+    static constexpr unsigned chunk_bits = 10;
+    static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+    // maximum number of chunks
+    static constexpr size_t max_chunks = size_t(1) << 16;
+
+    struct Chunk {
+        Set sets[chunk_size];
+    };
+
+    // chunks of interned sets, allocated on demand
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks;
+    // maximum number of sets
+    size_t capacity;
+    // number of interned sets
+    std::atomic<id_t> count;
+    // ids by set, keyed by the bytes of its ids
+    std::unordered_map<std::string, id_t> ids;
+    // rwlock for ids and chunk allocation
+    mutable std::shared_mutex mutex;
+};
+
+}; // end namespace upsf
+
+#endif
@@ -0,0 +1,219 @@
+/* upsf_item.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef UPSF_ITEM_HPP
+#define UPSF_ITEM_HPP
+
+#include <string>
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+#include "wt474_upsf_service/v1/service_v1.pb.h"
+
+namespace upsf {
+
+/**
+ * get item type of an item, returns false for an empty item
+ */
+inline bool item_type(
+    const wt474_messages::v1::Item& item,
+    wt474_upsf_service::v1::ItemType& itemtype)
+{
+    switch (item.sssitem_case()) {
+    case wt474_messages::v1::Item::kServiceGateway:
+        itemtype = wt474_upsf_service::v1::ItemType::service_gateway;
+        return true;
+    case wt474_messages::v1::Item::kServiceGatewayUserPlane:
+        itemtype = wt474_upsf_service::v1::ItemType::service_gateway_user_plane;
+        return true;
+    case wt474_messages::v1::Item::kTrafficSteeringFunction:
+        itemtype = wt474_upsf_service::v1::ItemType::traffic_steering_function;
+        return true;
+    case wt474_messages::v1::Item::kNetworkConnection:
+        itemtype = wt474_upsf_service::v1::ItemType::network_connection;
+        return true;
+    case wt474_messages::v1::Item::kShard:
+        itemtype = wt474_upsf_service::v1::ItemType::shard;
+        return true;
+    case wt474_messages::v1::Item::kSessionContext:
+        itemtype = wt474_upsf_service::v1::ItemType::session_context;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * get name of an item, empty string for an empty item
+ */
+inline const std::string& item_name(
+    const wt474_messages::v1::Item& item)
+{
+    static const std::string empty;
+
+    switch (item.sssitem_case()) {
+    case wt474_messages::v1::Item::kServiceGateway:
+        return item.service_gateway().name();
+    case wt474_messages::v1::Item::kServiceGatewayUserPlane:
+        return item.service_gateway_user_plane().name();
+    case wt474_messages::v1::Item::kTrafficSteeringFunction:
+        return item.traffic_steering_function().name();
+    case wt474_messages::v1::Item::kNetworkConnection:
+        return item.network_connection().name();
+    case wt474_messages::v1::Item::kShard:
+        return item.shard().name();
+    case wt474_messages::v1::Item::kSessionContext:
+        return item.session_context().name();
+    default:
+        return empty;
+    }
+}
+
+/**
+ * get metadata of an item, default instance for an empty item
+ */
+inline const wt474_messages::v1::MetaData& item_metadata(
+    const wt474_messages::v1::Item& item)
+{
+    switch (item.sssitem_case()) {
+    case wt474_messages::v1::Item::kServiceGateway:
+        return item.service_gateway().metadata();
+    case wt474_messages::v1::Item::kServiceGatewayUserPlane:
+        return item.service_gateway_user_plane().metadata();
+    case wt474_messages::v1::Item::kTrafficSteeringFunction:
+        return item.traffic_steering_function().metadata();
+    case wt474_messages::v1::Item::kNetworkConnection:
+        return item.network_connection().metadata();
+    case wt474_messages::v1::Item::kShard:
+        return item.shard().metadata();
+    case wt474_messages::v1::Item::kSessionContext:
+        return item.session_context().metadata();
+    default:
+        return wt474_messages::v1::MetaData::default_instance();
+    }
+}
+/**
+ * get item type carried by message type M
+ */
+template <typename M>
+wt474_upsf_service::v1::ItemType message_item_type();
+
+/**
+ * get message of type M from an item, nullptr if the item carries another type
+ */
+template <typename M>
+const M* item_message(
+    const wt474_messages::v1::Item& item);
+
+template <>
+inline wt474_upsf_service::v1::ItemType message_item_type<wt474_messages::v1::ServiceGateway>()
+{
+    return wt474_upsf_service::v1::ItemType::service_gateway;
+}
+
+template <>
+inline const wt474_messages::v1::ServiceGateway* item_message<wt474_messages::v1::ServiceGateway>(
+    const wt474_messages::v1::Item& item)
+{
+    return item.has_service_gateway() ? &item.service_gateway() : nullptr;
+}
+
+template <>
+inline wt474_upsf_service::v1::ItemType message_item_type<wt474_messages::v1::ServiceGatewayUserPlane>()
+{
+    return wt474_upsf_service::v1::ItemType::service_gateway_user_plane;
+}
+
+template <>
+inline const wt474_messages::v1::ServiceGatewayUserPlane* item_message<wt474_messages::v1::ServiceGatewayUserPlane>(
+    const wt474_messages::v1::Item& item)
+{
+    return item.has_service_gateway_user_plane() ? &item.service_gateway_user_plane() : nullptr;
+}
+
+template <>
+inline wt474_upsf_service::v1::ItemType message_item_type<wt474_messages::v1::TrafficSteeringFunction>()
+{
+    return wt474_upsf_service::v1::ItemType::traffic_steering_function;
+}
+
+template <>
+inline const wt474_messages::v1::TrafficSteeringFunction* item_message<wt474_messages::v1::TrafficSteeringFunction>(
+    const wt474_messages::v1::Item& item)
+{
+    return item.has_traffic_steering_function() ? &item.traffic_steering_function() : nullptr;
+}
+
+template <>
+inline wt474_upsf_service::v1::ItemType message_item_type<wt474_messages::v1::NetworkConnection>()
+{
+    return wt474_upsf_service::v1::ItemType::network_connection;
+}
+
+template <>
+inline const wt474_messages::v1::NetworkConnection* item_message<wt474_messages::v1::NetworkConnection>(
+    const wt474_messages::v1::Item& item)
+{
+    return item.has_network_connection() ? &item.network_connection() : nullptr;
+}
+
+template <>
+inline wt474_upsf_service::v1::ItemType message_item_type<wt474_messages::v1::Shard>()
+{
+    return wt474_upsf_service::v1::ItemType::shard;
+}
+
+template <>
+inline const wt474_messages::v1::Shard* item_message<wt474_messages::v1::Shard>(
+    const wt474_messages::v1::Item& item)
+{
+    return item.has_shard() ? &item.shard() : nullptr;
+}
+
+template <>
+inline wt474_upsf_service::v1::ItemType message_item_type<wt474_messages::v1::SessionContext>()
+{
+    return wt474_upsf_service::v1::ItemType::session_context;
+}
+
+template <>
+inline const wt474_messages::v1::SessionContext* item_message<wt474_messages::v1::SessionContext>(
+    const wt474_messages::v1::Item& item)
+{
+    return item.has_session_context() ? &item.session_context() : nullptr;
+}
+
+}; // end namespace upsf
+
+#endif
@@ -0,0 +1,465 @@
+/* upsf_loader.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_LOADER_HPP
+#define UPSF_LOADER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "upsf.hpp"
+#include "upsf_cache.hpp"
+#include "upsf_item.hpp"
+
+namespace upsf {
+
+/**
+ * UpsfLoader fills an UpsfCache at cold start by reading every item type
+ * on its own stream in parallel. Items are applied to the cache in batches
+ * as they arrive and handed to attached subscribers, which are notified
+ * concurrently from the loader threads.
+ *
+ * References between items are resolved as soon as both ends have been
+ * loaded, regardless of arrival order:
+ *  - service gateway user plane -> service gateway
+ *  - shard -> service gateway user plane, network connections
+ *  - session context -> shard, traffic steering function
+ * References to items not loaded at all are reported by unresolved().
+ *
+ * Item types form phases in dependency order: a phase is ready once its own
+ * stream has completed and all phases it refers to are ready. A ready
+ * callback is invoked from the loader threads as soon as a phase is ready,
+ * e.g. for steering on shards while session contexts are still streaming.
+ *
+ * Example:
+ *   upsf::UpsfLoader loader(channel, cache);
+ *   loader.set_callbacks([](const upsf::UpsfLoader::Phase& phase) { ... });
+ *   if (loader.load()) {
+ *       for (auto& phase : loader.phases()) { ... phase.ready ... }
+ *   }
+ */
+class UpsfLoader {
+
+public:
+    typedef std::chrono::steady_clock clock;
+
+    struct Phase {
+        // item type loaded in this phase
+        wt474_upsf_service::v1::ItemType itemtype;
+        // number of items loaded
+        size_t items = 0;
+        // time from start until the stream has completed
+        std::chrono::milliseconds streamed = std::chrono::milliseconds(0);
+        // time from start until this and all phases it refers to have completed
+        std::chrono::milliseconds ready = std::chrono::milliseconds(0);
+        // stream completed successfully
+        bool success = false;
+    };
+
+    struct Ref {
+        // referring item
+        wt474_upsf_service::v1::ItemType from_type;
+        std::string from_name;
+        // referred item
+        wt474_upsf_service::v1::ItemType to_type;
+        std::string to_name;
+    };
+
+    /**
+   * constructor
+   */
+    UpsfLoader(
+        std::shared_ptr<grpc::Channel> channel,
+        UpsfCache& cache,
+        size_t batch_size = 256)
+        : client(channel)
+        , cache(cache)
+        , batch_size(std::max(batch_size, size_t(1))) {};
+
+    /**
+   * attach subscriber to be notified of all loaded items
+   */
+    void attach(
+        UpsfSubscriber& subscriber)
+    {
+        subscribers.push_back(&subscriber);
+    };
+
+    /**
+   * set callback invoked once per phase as soon as it is ready, in
+   * dependency order and never concurrently, while load() is running
+   */
+    void set_callbacks(
+        std::function<void(const Phase&)> ready_cb)
+    {
+        this->ready_cb = ready_cb;
+    };
+
+    /**
+   * load all item types selected by the cache's itemtypes and
+   * derivedstates, returns false if any stream has failed
+   */
+    bool load()
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        clock::time_point start = clock::now();
+
+        loaded.clear();
+        pending.clear();
+        resolved.clear();
+
+        result.clear();
+        streamed.clear();
+        ready.clear();
+        for (auto itemtype : cache.itemtypes) {
+            Phase phase;
+            phase.itemtype = itemtype;
+            result.push_back(phase);
+        }
+
+        std::vector<std::thread> threads;
+        for (auto& phase : result) {
+            threads.emplace_back([this, &phase, start]() {
+                stream(phase);
+                std::scoped_lock lock(phases_mutex);
+                phase.streamed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start);
+                streamed.insert(phase.itemtype);
+                complete();
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        bool success = true;
+        for (const auto& phase : result) {
+            success = success && phase.success;
+        }
+        std::sort(result.begin(), result.end(),
+            [this](const Phase& a, const Phase& b) {
+                return rank(a.itemtype) < rank(b.itemtype);
+            });
+
+        return success;
+    };
+
+    /**
+   * phases of the last load() in dependency order
+   */
+    const std::vector<Phase>& phases() const
+    {
+        return result;
+    };
+
+    /**
+   * names of items of type from_type referring to item name of type to_type
+   */
+    std::vector<std::string> referrers(
+        wt474_upsf_service::v1::ItemType to_type,
+        const std::string& name,
+        wt474_upsf_service::v1::ItemType from_type) const
+    {
+        std::scoped_lock lock(refs_mutex);
+        std::vector<std::string> names;
+        auto it = resolved.find(key_of(to_type, name));
+        if (it == resolved.end()) {
+            return names;
+        }
+        for (const auto& ref : it->second) {
+            if (ref.from_type == from_type) {
+                names.push_back(ref.from_name);
+            }
+        }
+        return names;
+    };
+
+    /**
+   * references to items not loaded
+   */
+    std::vector<Ref> unresolved() const
+    {
+        std::scoped_lock lock(refs_mutex);
+        std::vector<Ref> refs;
+        for (const auto& it : pending) {
+            refs.insert(refs.end(), it.second.begin(), it.second.end());
+        }
+        return refs;
+    };
+
+private:
+    /**
+   * mark phases ready whose stream and dependencies have completed, in
+   * dependency order, called with phases_mutex held
+   */
+    void complete()
+    {
+        for (auto itemtype : order) {
+            for (auto& phase : result) {
+                if (phase.itemtype != itemtype || ready.count(itemtype) || !streamed.count(itemtype)) {
+                    continue;
+                }
+                /* dependencies not loaded at all do not hold a phase back */
+                bool waiting = false;
+                phase.ready = phase.streamed;
+                for (auto dependency : dependencies(itemtype)) {
+                    for (auto& other : result) {
+                        if (other.itemtype != dependency) {
+                            continue;
+                        }
+                        waiting = waiting || !ready.count(dependency);
+                        phase.ready = std::max(phase.ready, other.ready);
+                    }
+                }
+                if (waiting) {
+                    continue;
+                }
+                ready.insert(itemtype);
+                VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " itemtype=" << wt474_upsf_service::v1::ItemType_Name(itemtype)
+                        << " items=" << phase.items << " streamed=" << phase.streamed.count() << "ms ready=" << phase.ready.count() << "ms" << std::endl;
+                if (ready_cb) {
+                    ready_cb(phase);
+                }
+            }
+        }
+    };
+
+    /**
+   * read all items of a phase
+   */
+    void stream(
+        Phase& phase)
+    {
+        wt474_upsf_service::v1::ReadReq req;
+        req.add_itemtype(phase.itemtype);
+        for (auto it : cache.derivedstates) {
+            req.add_itemstate(it);
+        }
+        req.set_watch(false);
+
+        std::vector<UpsfCache::ItemPtr> batch;
+        grpc::ClientContext context;
+        phase.success = client.ReadV1(req, context,
+            [this, &phase, &batch](const UpsfCache::ItemPtr& item) {
+                wt474_upsf_service::v1::ItemType itemtype;
+                if (!item_type(*item, itemtype) || itemtype != phase.itemtype) {
+                    return true;
+                }
+                phase.items++;
+                batch.push_back(item);
+                if (batch.size() == batch_size) {
+                    apply(itemtype, batch);
+                    batch.clear();
+                }
+                return true;
+            });
+        apply(phase.itemtype, batch);
+    };
+
+    /**
+   * apply a batch to cache, references and subscribers
+   */
+    void apply(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::vector<UpsfCache::ItemPtr>& batch)
+    {
+        if (batch.empty()) {
+            return;
+        }
+        cache.apply(batch);
+
+        {
+            std::scoped_lock lock(refs_mutex);
+            for (const auto& item : batch) {
+                link(itemtype, *item);
+            }
+        }
+
+        for (auto subscriber : subscribers) {
+            for (const auto& item : batch) {
+                subscriber->notify(item);
+            }
+        }
+    };
+
+    /**
+   * register an item and its references, resolve references waiting for it
+   */
+    void link(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const wt474_messages::v1::Item& item)
+    {
+        const std::string& name = item_name(item);
+        std::string key = key_of(itemtype, name);
+        loaded.insert(key);
+
+        auto it = pending.find(key);
+        if (it != pending.end()) {
+            auto& refs = resolved[key];
+            refs.insert(refs.end(), it->second.begin(), it->second.end());
+            pending.erase(it);
+        }
+
+        switch (itemtype) {
+        case wt474_upsf_service::v1::ItemType::service_gateway_user_plane:
+            refer(itemtype, name, wt474_upsf_service::v1::ItemType::service_gateway,
+                item.service_gateway_user_plane().service_gateway_name());
+            break;
+        case wt474_upsf_service::v1::ItemType::shard:
+            refer(itemtype, name, wt474_upsf_service::v1::ItemType::service_gateway_user_plane,
+                item.shard().spec().desired_state().service_gateway_user_plane());
+            for (const auto& nc : item.shard().spec().desired_state().network_connection()) {
+                refer(itemtype, name, wt474_upsf_service::v1::ItemType::network_connection, nc);
+            }
+            break;
+        case wt474_upsf_service::v1::ItemType::session_context:
+            refer(itemtype, name, wt474_upsf_service::v1::ItemType::shard,
+                item.session_context().spec().desired_state().shard());
+            refer(itemtype, name, wt474_upsf_service::v1::ItemType::traffic_steering_function,
+                item.session_context().spec().traffic_steering_function());
+            break;
+        default:
+            break;
+        }
+    };
+
+    /**
+   * add reference, resolved if the referred item has been loaded
+   */
+    void refer(
+        wt474_upsf_service::v1::ItemType from_type,
+        const std::string& from_name,
+        wt474_upsf_service::v1::ItemType to_type,
+        const std::string& to_name)
+    {
+        if (to_name.empty()) {
+            return;
+        }
+        std::string key = key_of(to_type, to_name);
+        Ref ref { from_type, from_name, to_type, to_name };
+        if (loaded.count(key)) {
+            resolved[key].push_back(std::move(ref));
+        } else {
+            pending[key].push_back(std::move(ref));
+        }
+    };
+
+    /**
+   * item types referred to by items of itemtype
+   */
+    static std::vector<wt474_upsf_service::v1::ItemType> dependencies(
+        wt474_upsf_service::v1::ItemType itemtype)
+    {
+        switch (itemtype) {
+        case wt474_upsf_service::v1::ItemType::service_gateway_user_plane:
+            return { wt474_upsf_service::v1::ItemType::service_gateway };
+        case wt474_upsf_service::v1::ItemType::shard:
+            return { wt474_upsf_service::v1::ItemType::service_gateway_user_plane,
+                wt474_upsf_service::v1::ItemType::network_connection };
+        case wt474_upsf_service::v1::ItemType::session_context:
+            return { wt474_upsf_service::v1::ItemType::shard,
+                wt474_upsf_service::v1::ItemType::traffic_steering_function };
+        default:
+            return {};
+        }
+    };
+
+    /**
+   * position of itemtype in dependency order
+   */
+    size_t rank(
+        wt474_upsf_service::v1::ItemType itemtype) const
+    {
+        return std::find(order.begin(), order.end(), itemtype) - order.begin();
+    };
+
+    static std::string key_of(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name)
+    {
+        std::string key(1, char(itemtype));
+        key.append(name);
+        return key;
+    };
+
+    // item types in dependency order
+    const std::vector<wt474_upsf_service::v1::ItemType> order = {
+        wt474_upsf_service::v1::ItemType::service_gateway,
+        wt474_upsf_service::v1::ItemType::service_gateway_user_plane,
+        wt474_upsf_service::v1::ItemType::traffic_steering_function,
+        wt474_upsf_service::v1::ItemType::network_connection,
+        wt474_upsf_service::v1::ItemType::shard,
+        wt474_upsf_service::v1::ItemType::session_context,
+    };
+
+    // client for parallel streams
+    UpsfClient client;
+    // cache to be filled
+    UpsfCache& cache;
+    // items per cache update
+    size_t batch_size;
+    // attached subscribers
+    std::vector<UpsfSubscriber*> subscribers;
+    // phases of last load
+    std::vector<Phase> result;
+    // item types of phases streamed and ready
+    std::unordered_set<int> streamed;
+    std::unordered_set<int> ready;
+    // mutex for streamed, ready and the times of all phases
+    std::mutex phases_mutex;
+    // phase ready callback
+    std::function<void(const Phase&)> ready_cb;
+    // keys of loaded items
+    std::unordered_set<std::string> loaded;
+    // references by key of the referred item, waiting for it
+    std::unordered_map<std::string, std::vector<Ref>> pending;
+    // references by key of the referred item, resolved
+    std::unordered_map<std::string, std::vector<Ref>> resolved;
+    // mutex for loaded, pending and resolved
+    mutable std::mutex refs_mutex;
+};
+
+}; // end namespace upsf
+
+#endif
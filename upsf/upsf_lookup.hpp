@@ -0,0 +1,566 @@
+/* upsf_lookup.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_LOOKUP_HPP
+#define UPSF_LOOKUP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include "upsf.hpp"
+#include "upsf_intern.hpp"
+#include "upsf_item.hpp"
+
+namespace upsf {
+
+/**
+ * UpsfLookupCache memoizes LookupV1 results keyed by the canonical encoding
+ * of the SessionContext::Spec, found results for ttl and not found results
+ * for negative_ttl.
+ *
+ * As an UpsfSubscriber fed by a watch stream on shards, service gateway
+ * user planes, network connections and session contexts it invalidates:
+ *  - results referring to a changed session context or shard,
+ *  - results referring to a shard of a changed user plane or network connection,
+ *  - all not found results on any such change.
+ * Changes of status counters like allocated_session_count do not invalidate
+ * anything. Dependencies are tracked by the ids of shard, user plane and
+ * network connection names in the global UpsfInterner and by the hash of
+ * session context names, a hash collision merely invalidates a result
+ * early. The cache relies on an uninterrupted watch stream, the owner
+ * of the stream disables it while the stream is down.
+ */
+class UpsfLookupCache : public UpsfSubscriber {
+
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /**
+   * constructor
+   */
+    UpsfLookupCache(
+        std::chrono::milliseconds ttl,
+        std::chrono::milliseconds negative_ttl,
+        size_t max_entries = 65536)
+        : UpsfSubscriber(
+            { wt474_upsf_service::v1::ItemType::service_gateway_user_plane,
+                wt474_upsf_service::v1::ItemType::network_connection,
+                wt474_upsf_service::v1::ItemType::shard,
+                wt474_upsf_service::v1::ItemType::session_context },
+            { wt474_messages::v1::DerivedState::unknown,
+                wt474_messages::v1::DerivedState::inactive,
+                wt474_messages::v1::DerivedState::active,
+                wt474_messages::v1::DerivedState::updating,
+                wt474_messages::v1::DerivedState::deleting,
+                wt474_messages::v1::DerivedState::deleted },
+            {}, {}, /*watch=*/true)
+        , ttl(ttl)
+        , negative_ttl(negative_ttl)
+        , max_entries(max_entries)
+        , enabled(false)
+        , epoch(0)
+        , negative_epoch(0)
+        , inflight(0)
+        , hits(0)
+        , misses(0)
+        , invalidations(0) {};
+
+    virtual ~UpsfLookupCache() {};
+
+public:
+    /**
+   * canonical key of a spec: serialized with required service groups in
+   * sorted order, as their order does not matter for a lookup
+   */
+    static std::string key_of(
+        const wt474_messages::v1::SessionContext::Spec& spec)
+    {
+        std::string key;
+        if (std::is_sorted(spec.required_service_group().begin(), spec.required_service_group().end())) {
+            spec.SerializeToString(&key);
+            return key;
+        }
+        wt474_messages::v1::SessionContext::Spec canonical(spec);
+        std::sort(canonical.mutable_required_service_group()->begin(), canonical.mutable_required_service_group()->end());
+        canonical.SerializeToString(&key);
+        return key;
+    };
+
+    /**
+   * LookupV1 served from the cache if possible, results of client.LookupV1()
+   * are cached unless invalidated while the call was in flight, returns
+   * false on error or for a cached NOT_FOUND status
+   */
+    bool LookupV1(
+        UpsfClient& client,
+        const wt474_messages::v1::SessionContext::Spec& spec,
+        wt474_messages::v1::SessionContext& resp)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        grpc::Status status = LookupV1(spec, resp,
+            [&client, &spec](wt474_messages::v1::SessionContext& result) {
+                grpc::Status status;
+                client.LookupV1(spec, result, status);
+                return status;
+            });
+
+        return status.ok();
+    };
+
+    /**
+   * LookupV1 served from the cache if possible, otherwise by lookup, e.g.
+   * a call relayed by a proxy, its OK and NOT_FOUND results are cached
+   * unless invalidated while the call was in flight
+   */
+    grpc::Status LookupV1(
+        const wt474_messages::v1::SessionContext::Spec& spec,
+        wt474_messages::v1::SessionContext& resp,
+        const std::function<grpc::Status(wt474_messages::v1::SessionContext&)>& lookup)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        std::string key = key_of(spec);
+        uint64_t start = 0;
+        {
+            std::scoped_lock lock(mutex);
+            grpc::StatusCode code;
+            if (find(key, resp, code)) {
+                hits++;
+                if (code != grpc::StatusCode::OK) {
+                    return grpc::Status(code, "cached lookup result");
+                }
+                return grpc::Status::OK;
+            }
+            misses++;
+            start = epoch;
+            inflight++;
+        }
+
+        grpc::Status status = lookup(resp);
+
+        std::scoped_lock lock(mutex);
+        if (status.ok() || status.error_code() == grpc::StatusCode::NOT_FOUND) {
+            insert(key, resp, status.error_code(), start);
+        }
+        if (--inflight == 0) {
+            changed.clear();
+        }
+
+        return status;
+    };
+
+    /**
+   * enable or disable the cache, disabling drops all entries, e.g. while
+   * the watch stream feeding the cache is down
+   */
+    void set_enabled(
+        bool enabled)
+    {
+        std::scoped_lock lock(mutex);
+        this->enabled = enabled;
+        entries.clear();
+        dependents.clear();
+        negatives.clear();
+        epoch++;
+        negative_epoch = epoch;
+        if (!enabled) {
+            shards.clear();
+            fingerprints.clear();
+        }
+    };
+
+    /**
+   * number of cached results
+   */
+    size_t size() const
+    {
+        std::scoped_lock lock(mutex);
+        return entries.size();
+    };
+
+    /**
+   * statistics
+   */
+    uint64_t get_hits() const
+    {
+        return hits;
+    };
+
+    uint64_t get_misses() const
+    {
+        return misses;
+    };
+
+    uint64_t get_invalidations() const
+    {
+        return invalidations;
+    };
+
+public:
+    /**
+   * UpsfSubscriber: invalidate results depending on a changed item
+   */
+    void notify(
+        const std::shared_ptr<const wt474_messages::v1::Item>& item) override
+    {
+        std::scoped_lock lock(mutex);
+
+        bool deleted = (item_metadata(*item).derived_state() == wt474_messages::v1::DerivedState::deleted);
+        const std::string& name = item_name(*item);
+
+        if (item->has_session_context()) {
+            changed_item(dep_of('C', name));
+            return;
+        }
+
+        if (item->has_shard()) {
+            dep_t dep = dep_of('S', name);
+            auto it = shards.find(dep);
+            size_t fingerprint = fingerprint_of(*item);
+            if (it != shards.end() && it->second.fingerprint == fingerprint) {
+                return;
+            }
+            if (deleted) {
+                if (it != shards.end()) {
+                    shards.erase(it);
+                }
+            } else {
+                ShardRefs& refs = shards[dep];
+                refs.fingerprint = fingerprint;
+                refs.refs.clear();
+                const wt474_messages::v1::Shard& shard = item->shard();
+                refs.refs.push_back(dep_of('U', shard.spec().desired_state().service_gateway_user_plane()));
+                refs.refs.push_back(dep_of('U', shard.status().current_state().service_gateway_user_plane()));
+                for (const auto& nc : shard.spec().desired_state().network_connection()) {
+                    refs.refs.push_back(dep_of('N', nc));
+                }
+                for (const auto& nc : shard.status().current_state().tsf_network_connection()) {
+                    refs.refs.push_back(dep_of('N', nc.second));
+                }
+            }
+            changed_item(dep);
+            return;
+        }
+
+        /* user plane or network connection: all shards referring to it */
+        dep_t ref = dep_of(item->has_service_gateway_user_plane() ? 'U' : 'N', name);
+        size_t fingerprint = fingerprint_of(*item);
+        auto it = fingerprints.find(ref);
+        if (it != fingerprints.end() && it->second == fingerprint) {
+            return;
+        }
+        if (deleted) {
+            if (it != fingerprints.end()) {
+                fingerprints.erase(it);
+            }
+        } else {
+            fingerprints[ref] = fingerprint;
+        }
+        for (const auto& shard : shards) {
+            if (std::find(shard.second.refs.begin(), shard.second.refs.end(), ref) != shard.second.refs.end()) {
+                changed_item(shard.first);
+            }
+        }
+        drop_negatives();
+    };
+
+private:
+    typedef uint64_t dep_t;
+
+    struct Entry {
+        // expiry
+        clock::time_point expires;
+        // status of the lookup, OK or NOT_FOUND
+        grpc::StatusCode code;
+        // result
+        wt474_messages::v1::SessionContext result;
+        // items the result depends on
+        std::vector<dep_t> deps;
+    };
+
+    struct ShardRefs {
+        // fingerprint of lookup relevant fields
+        size_t fingerprint = 0;
+        // user planes and network connections referred to
+        std::vector<dep_t> refs;
+    };
+
+    /**
+   * dependency key of an item, kind 'C', 'S', 'U' or 'N' in the top byte and
+   * the interned name below, session context names and names not interned
+   * are hashed instead
+   */
+    static dep_t dep_of(
+        char kind,
+        const std::string& name)
+    {
+        static constexpr dep_t mask = (dep_t(1) << 56) - 1;
+        if (kind != 'C') {
+            UpsfInterner::id_t id = UpsfInterner::global().intern(name);
+            if (id != UpsfInterner::invalid) {
+                return (dep_t(kind) << 56) | id;
+            }
+        }
+        /* above any id, a collision merely invalidates early */
+        return (dep_t(kind) << 56) | std::max(std::hash<std::string>()(name) & mask, dep_t(UpsfInterner::invalid));
+    };
+
+    /**
+   * hash of an item without status counters and timestamps
+   */
+    static size_t fingerprint_of(
+        const wt474_messages::v1::Item& item)
+    {
+        wt474_messages::v1::Item relevant(item);
+        std::string buf;
+        if (relevant.has_shard()) {
+            relevant.mutable_shard()->mutable_status()->clear_allocated_session_count();
+            relevant.mutable_shard()->mutable_metadata()->clear_last_updated();
+        } else if (relevant.has_service_gateway_user_plane()) {
+            relevant.mutable_service_gateway_user_plane()->clear_status();
+            relevant.mutable_service_gateway_user_plane()->mutable_metadata()->clear_last_updated();
+        } else if (relevant.has_network_connection()) {
+            relevant.mutable_network_connection()->mutable_status()->clear_allocated_shards();
+            relevant.mutable_network_connection()->mutable_metadata()->clear_last_updated();
+        }
+        google::protobuf::io::StringOutputStream output(&buf);
+        google::protobuf::io::CodedOutputStream coded(&output);
+        coded.SetSerializationDeterministic(true);
+        relevant.SerializeToCodedStream(&coded);
+        coded.Trim();
+        return std::hash<std::string>()(buf);
+    };
+
+    /**
+   * find unexpired entry
+   */
+    bool find(
+        const std::string& key,
+        wt474_messages::v1::SessionContext& resp,
+        grpc::StatusCode& code)
+    {
+        if (!enabled) {
+            return false;
+        }
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            return false;
+        }
+        if (it->second.expires <= clock::now()) {
+            erase(it);
+            return false;
+        }
+        resp = it->second.result;
+        code = it->second.code;
+        return true;
+    };
+
+    /**
+   * insert result of a lookup started at epoch start unless invalidated meanwhile
+   */
+    void insert(
+        const std::string& key,
+        const wt474_messages::v1::SessionContext& resp,
+        grpc::StatusCode code,
+        uint64_t start)
+    {
+        if (!enabled) {
+            return;
+        }
+        bool negative = (code != grpc::StatusCode::OK || resp.name().empty());
+
+        Entry entry;
+        entry.code = code;
+        if (negative) {
+            if (negative_epoch > start) {
+                return;
+            }
+            entry.expires = clock::now() + negative_ttl;
+        } else {
+            entry.result = resp;
+            entry.deps.push_back(dep_of('C', resp.name()));
+            for (const auto& shard : { resp.spec().desired_state().shard(), resp.status().current_state().user_plane_shard(), resp.status().current_state().tsf_shard() }) {
+                if (!shard.empty()) {
+                    entry.deps.push_back(dep_of('S', shard));
+                }
+            }
+            for (const auto& dep : entry.deps) {
+                auto it = changed.find(dep);
+                if (it != changed.end() && it->second > start) {
+                    return;
+                }
+            }
+            entry.expires = clock::now() + ttl;
+        }
+
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            erase(it);
+        }
+        if (entries.size() >= max_entries) {
+            expire();
+            if (entries.size() >= max_entries) {
+                return;
+            }
+        }
+        for (const auto& dep : entry.deps) {
+            dependents[dep].insert(key);
+        }
+        if (negative) {
+            negatives.insert(key);
+        }
+        entries.emplace(key, std::move(entry));
+    };
+
+    /**
+   * remove entry and its index references
+   */
+    void erase(
+        std::unordered_map<std::string, Entry>::iterator it)
+    {
+        for (const auto& dep : it->second.deps) {
+            auto jt = dependents.find(dep);
+            if (jt != dependents.end()) {
+                jt->second.erase(it->first);
+                if (jt->second.empty()) {
+                    dependents.erase(jt);
+                }
+            }
+        }
+        negatives.erase(it->first);
+        entries.erase(it);
+    };
+
+    /**
+   * remove all expired entries
+   */
+    void expire()
+    {
+        clock::time_point now = clock::now();
+        for (auto it = entries.begin(); it != entries.end();) {
+            auto next = std::next(it);
+            if (it->second.expires <= now) {
+                erase(it);
+            }
+            it = next;
+        }
+    };
+
+    /**
+   * invalidate results depending on an item, a change may turn any not
+   * found result into a found one
+   */
+    void changed_item(
+        dep_t dep)
+    {
+        epoch++;
+        if (inflight > 0) {
+            changed[dep] = epoch;
+        }
+        auto it = dependents.find(dep);
+        if (it != dependents.end()) {
+            std::vector<std::string> keys(it->second.begin(), it->second.end());
+            for (const auto& key : keys) {
+                auto jt = entries.find(key);
+                if (jt != entries.end()) {
+                    erase(jt);
+                    invalidations++;
+                }
+            }
+        }
+        drop_negatives();
+    };
+
+    void drop_negatives()
+    {
+        negative_epoch = epoch;
+        for (const auto& key : std::vector<std::string>(negatives.begin(), negatives.end())) {
+            auto it = entries.find(key);
+            if (it != entries.end()) {
+                erase(it);
+                invalidations++;
+            }
+        }
+    };
+
+private:
+    // lifetime of found results
+    std::chrono::milliseconds ttl;
+    // lifetime of not found results
+    std::chrono::milliseconds negative_ttl;
+    // max. number of cached results
+    size_t max_entries;
+    // cache in use
+    bool enabled;
+    // cached results by canonical spec
+    std::unordered_map<std::string, Entry> entries;
+    // cached results by item they depend on
+    std::unordered_map<dep_t, std::unordered_set<std::string>> dependents;
+    // cached not found results
+    std::unordered_set<std::string> negatives;
+    // watched shards and their references
+    std::unordered_map<dep_t, ShardRefs> shards;
+    // fingerprints of watched user planes and network connections
+    std::unordered_map<dep_t, size_t> fingerprints;
+    // change counter, epoch of the latest change affecting not found results
+    uint64_t epoch;
+    uint64_t negative_epoch;
+    // lookups in flight and items changed meanwhile
+    size_t inflight;
+    std::unordered_map<dep_t, uint64_t> changed;
+    // mutex for all of the above
+    mutable std::mutex mutex;
+    // statistics
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> invalidations;
+};
+
+}; // end namespace upsf
+
+#endif
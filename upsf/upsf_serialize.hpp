@@ -0,0 +1,364 @@
+/* upsf_serialize.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_SERIALIZE_HPP
+#define UPSF_SERIALIZE_HPP
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/timestamp.pb.h>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "upsf_stream.hpp"
+
+#include "wt474_upsf_messages/v1/messages_v1.pb.h"
+
+namespace upsf {
+
+/****************************************
+ * length-delimited protobuf
+ ****************************************/
+
+/**
+ * write message prefixed by its varint32 encoded size, compatible with
+ * google::protobuf::util::ParseDelimitedFromZeroCopyStream()
+ */
+inline bool write_delimited(
+    const google::protobuf::MessageLite& msg,
+    std::ostream& os)
+{
+    /* serialization buffer reused across calls */
+    static thread_local std::string buf;
+    uint8_t prefix[5]; // max. varint32 size
+
+    if (!msg.SerializeToString(&buf)) {
+        return false;
+    }
+    uint8_t* end = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(buf.size(), prefix);
+    os.write(reinterpret_cast<const char*>(prefix), end - prefix);
+    os.write(buf.data(), buf.size());
+
+    return os.good();
+}
+
+/**
+ * write size prefixed message into buf, returns number of bytes written
+ * or 0 if buf is too small
+ */
+inline size_t write_delimited(
+    const google::protobuf::MessageLite& msg,
+    char* buf,
+    size_t size)
+{
+    size_t msg_size = msg.ByteSizeLong();
+    size_t len = google::protobuf::io::CodedOutputStream::VarintSize32(msg_size) + msg_size;
+    if (!buf || len > size) {
+        return 0;
+    }
+
+    uint8_t* pos = reinterpret_cast<uint8_t*>(buf);
+    pos = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(msg_size, pos);
+    msg.SerializeWithCachedSizesToArray(pos);
+
+    return len;
+}
+
+/**
+ * read size prefixed message from buf, returns number of bytes consumed
+ * or 0 if buf holds no complete message
+ */
+inline size_t read_delimited(
+    const char* buf,
+    size_t size,
+    google::protobuf::MessageLite& msg)
+{
+    google::protobuf::io::CodedInputStream cis(reinterpret_cast<const uint8_t*>(buf), size);
+    uint32_t msg_size;
+    if (!cis.ReadVarint32(&msg_size)) {
+        return 0;
+    }
+    size_t prefix_len = cis.CurrentPosition();
+    if (msg_size > size - prefix_len) {
+        return 0;
+    }
+    if (!msg.ParseFromArray(buf + prefix_len, msg_size)) {
+        return 0;
+    }
+
+    return prefix_len + msg_size;
+}
+
+/****************************************
+ * JSON
+ ****************************************/
+
+/**
+ * JSON text of a message written straight into an ostream, no intermediate
+ * strings are built. Output follows the proto3 JSON mapping with proto field
+ * names: fields holding default values are omitted, enums are written by
+ * name, 64 bit integers as strings and timestamps in RFC 3339 format.
+ */
+class JsonStream {
+    const google::protobuf::Message& msg;
+
+public:
+    JsonStream(
+        const google::protobuf::Message& msg)
+        : msg(msg) {};
+
+    friend std::ostream& operator<<(
+        std::ostream& os, const JsonStream& s)
+    {
+        write_message(os, s.msg);
+        return os;
+    };
+
+private:
+    /**
+     * string with JSON escapes, unescaped runs are written at once
+     */
+    static void write_string(
+        std::ostream& os,
+        const std::string& str)
+    {
+        static const char hex[] = "0123456789abcdef";
+        const char* run = str.data();
+        const char* end = str.data() + str.size();
+
+        os.put('"');
+        for (const char* pos = run; pos < end; pos++) {
+            unsigned char c = *pos;
+            if ((c >= 0x20) && (c != '"') && (c != '\\')) {
+                continue;
+            }
+            os.write(run, pos - run);
+            run = pos + 1;
+            switch (c) {
+            case '"':
+                os.write("\\\"", 2);
+                break;
+            case '\\':
+                os.write("\\\\", 2);
+                break;
+            case '\n':
+                os.write("\\n", 2);
+                break;
+            case '\r':
+                os.write("\\r", 2);
+                break;
+            case '\t':
+                os.write("\\t", 2);
+                break;
+            default:
+                const char esc[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+                os.write(esc, sizeof(esc));
+                break;
+            }
+        }
+        os.write(run, end - run);
+        os.put('"');
+    };
+
+    /**
+     * single value of a field, index < 0 for singular fields
+     */
+    static void write_value(
+        std::ostream& os,
+        const google::protobuf::Message& msg,
+        const google::protobuf::FieldDescriptor* field,
+        int index)
+    {
+        const google::protobuf::Reflection* refl = msg.GetReflection();
+        std::string scratch;
+
+        switch (field->cpp_type()) {
+        case google::protobuf::FieldDescriptor::CPPTYPE_INT32:
+            os << (index < 0 ? refl->GetInt32(msg, field) : refl->GetRepeatedInt32(msg, field, index));
+            break;
+        case google::protobuf::FieldDescriptor::CPPTYPE_UINT32:
+            os << (index < 0 ? refl->GetUInt32(msg, field) : refl->GetRepeatedUInt32(msg, field, index));
+            break;
+        case google::protobuf::FieldDescriptor::CPPTYPE_INT64:
+            os << '"' << (index < 0 ? refl->GetInt64(msg, field) : refl->GetRepeatedInt64(msg, field, index)) << '"';
+            break;
+        case google::protobuf::FieldDescriptor::CPPTYPE_UINT64:
+            os << '"' << (index < 0 ? refl->GetUInt64(msg, field) : refl->GetRepeatedUInt64(msg, field, index)) << '"';
+            break;
+        case google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE:
+            os << (index < 0 ? refl->GetDouble(msg, field) : refl->GetRepeatedDouble(msg, field, index));
+            break;
+        case google::protobuf::FieldDescriptor::CPPTYPE_FLOAT:
+            os << (index < 0 ? refl->GetFloat(msg, field) : refl->GetRepeatedFloat(msg, field, index));
+            break;
+        case google::protobuf::FieldDescriptor::CPPTYPE_BOOL:
+            os << ((index < 0 ? refl->GetBool(msg, field) : refl->GetRepeatedBool(msg, field, index)) ? "true" : "false");
+            break;
+        case google::protobuf::FieldDescriptor::CPPTYPE_ENUM: {
+            int number = (index < 0 ? refl->GetEnumValue(msg, field) : refl->GetRepeatedEnumValue(msg, field, index));
+            const google::protobuf::EnumValueDescriptor* value = field->enum_type()->FindValueByNumber(number);
+            if (value) {
+                write_string(os, value->name());
+            } else {
+                os << number;
+            }
+            break;
+        }
+        case google::protobuf::FieldDescriptor::CPPTYPE_STRING:
+            /* reference avoids a copy unless the string is not stored as such */
+            write_string(os, index < 0 ? refl->GetStringReference(msg, field, &scratch) : refl->GetRepeatedStringReference(msg, field, index, &scratch));
+            break;
+        case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
+            write_message(os, index < 0 ? refl->GetMessage(msg, field) : refl->GetRepeatedMessage(msg, field, index));
+            break;
+        }
+    };
+
+    /**
+     * message as JSON object, well-known types as their JSON representation
+     */
+    static void write_message(
+        std::ostream& os,
+        const google::protobuf::Message& msg)
+    {
+        const google::protobuf::Descriptor* desc = msg.GetDescriptor();
+
+        /* google.protobuf.Timestamp */
+        if (desc == google::protobuf::Timestamp::descriptor()) {
+            const google::protobuf::Reflection* refl = msg.GetReflection();
+            google::protobuf::Timestamp timestamp;
+            timestamp.set_seconds(refl->GetInt64(msg, desc->FindFieldByNumber(1)));
+            timestamp.set_nanos(refl->GetInt32(msg, desc->FindFieldByNumber(2)));
+            os << '"' << TimestampStream(timestamp) << '"';
+            return;
+        }
+
+        /* google.protobuf wrapper types, e.g. StringValue */
+        if (desc->file()->name() == "google/protobuf/wrappers.proto") {
+            write_value(os, msg, desc->FindFieldByNumber(1), -1);
+            return;
+        }
+
+        /* set fields only, i.e. non-default values for proto3 scalars,
+         * one field list per nesting level reused across calls */
+        static thread_local std::deque<std::vector<const google::protobuf::FieldDescriptor*>> field_lists;
+        static thread_local size_t depth = 0;
+        if (field_lists.size() <= depth) {
+            field_lists.emplace_back();
+        }
+        std::vector<const google::protobuf::FieldDescriptor*>& fields = field_lists[depth++];
+        msg.GetReflection()->ListFields(msg, &fields);
+
+        os.put('{');
+        for (size_t i = 0; i < fields.size(); i++) {
+            const google::protobuf::FieldDescriptor* field = fields[i];
+            if (i > 0) {
+                os.put(',');
+            }
+            os.put('"');
+            os << field->name();
+            os.write("\":", 2);
+
+            if (field->is_map()) {
+                /* map entries: key/value messages, keys as strings */
+                const google::protobuf::FieldDescriptor* key = field->message_type()->map_key();
+                const google::protobuf::FieldDescriptor* value = field->message_type()->map_value();
+                os.put('{');
+                for (int j = 0; j < msg.GetReflection()->FieldSize(msg, field); j++) {
+                    const google::protobuf::Message& entry = msg.GetReflection()->GetRepeatedMessage(msg, field, j);
+                    if (j > 0) {
+                        os.put(',');
+                    }
+                    if (key->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_STRING) {
+                        write_value(os, entry, key, -1);
+                    } else {
+                        os.put('"');
+                        write_value(os, entry, key, -1);
+                        os.put('"');
+                    }
+                    os.put(':');
+                    write_value(os, entry, value, -1);
+                }
+                os.put('}');
+            } else if (field->is_repeated()) {
+                os.put('[');
+                for (int j = 0; j < msg.GetReflection()->FieldSize(msg, field); j++) {
+                    if (j > 0) {
+                        os.put(',');
+                    }
+                    write_value(os, msg, field, j);
+                }
+                os.put(']');
+            } else {
+                write_value(os, msg, field, -1);
+            }
+        }
+        os.put('}');
+
+        depth--;
+    };
+};
+
+/**
+ * write message as JSON into buf as snprintf does: returns the length of
+ * the entire JSON text excluding the terminating '\0', a result of size or
+ * more means buf was too small and holds an empty string then instead of
+ * truncated JSON, buf may be nullptr for size 0 for querying the length
+ */
+inline size_t write_json(
+    const google::protobuf::Message& msg,
+    char* buf,
+    size_t size)
+{
+    UpsfCharBuffer sbuf(buf, size);
+    std::ostream os(&sbuf);
+    os << JsonStream(msg);
+    sbuf.terminate();
+
+    size_t length = sbuf.length();
+    if (length >= size && buf && size > 0) {
+        buf[0] = '\0';
+    }
+
+    return length;
+}
+
+}; // end namespace upsf
+
+#endif
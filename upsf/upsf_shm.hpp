@@ -0,0 +1,1221 @@
+/* upsf_shm.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_SHM_HPP
+#define UPSF_SHM_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "upsf_cache.hpp"
+#include "upsf_intern.hpp"
+
+namespace upsf {
+
+/**
+ * Shared memory layout of an UpsfCache replica. All references within a
+ * segment are offsets relative to its start, so processes may map it at
+ * any address.
+ *
+ * A replica named "/name" consists of a control segment "/name" holding
+ * the current generation, one immutable manifest segment "/name.<generation>"
+ * per published version and one immutable item segment
+ * "/name.<itemtype>.<generation>" per item type and version the type was
+ * changed in. The manifest refers to the item segment of each type, so an
+ * item type unchanged since the previous version is not written again. An
+ * item segment starts with a TypeHeader, followed by an Index table sorted
+ * by name, the names, the names referred to and the serialized items.
+ */
+struct UpsfShmLayout {
+    // current layout version
+    static constexpr uint32_t format_version = 2;
+
+    struct Control {
+        // segment magic "UPSFSHMC"
+        char magic[8];
+        // layout version
+        uint32_t version;
+        uint32_t reserved;
+        // generation of the current manifest, 0: none published yet
+        std::atomic<uint64_t> generation;
+    };
+
+    struct Table {
+        // generation of the item segment
+        uint64_t generation;
+        // number of Index entries
+        uint64_t count;
+    };
+
+    struct Index {
+        uint64_t name_offset;
+        uint64_t ref_offset;
+        uint64_t item_offset;
+        uint32_t name_size;
+        uint32_t ref_size;
+        uint32_t item_size;
+        uint32_t reserved;
+    };
+
+    struct Header {
+        // segment magic "UPSFSHMD"
+        char magic[8];
+        // layout version
+        uint32_t version;
+        // size of this header
+        uint32_t header_size;
+        // size of the whole segment
+        uint64_t size;
+        // generation of this manifest
+        uint64_t generation;
+        // cache revision at publish time
+        uint64_t revision;
+        // latest metadata.last_updated seen
+        int64_t last_updated_seconds;
+        int32_t last_updated_nanos;
+        uint32_t reserved;
+        // item segment per item type
+        Table tables[UpsfCache::num_itemtypes];
+    };
+
+    struct TypeHeader {
+        // segment magic "UPSFSHMT"
+        char magic[8];
+        // layout version
+        uint32_t version;
+        // size of this header, the Index table follows
+        uint32_t header_size;
+        // size of the whole segment
+        uint64_t size;
+        // generation of this item segment
+        uint64_t generation;
+        // item type
+        uint32_t itemtype;
+        uint32_t reserved;
+        // number of Index entries
+        uint64_t count;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared generation counter must be lock-free");
+
+    static constexpr char control_magic[8] = { 'U', 'P', 'S', 'F', 'S', 'H', 'M', 'C' };
+    static constexpr char data_magic[8] = { 'U', 'P', 'S', 'F', 'S', 'H', 'M', 'D' };
+    static constexpr char type_magic[8] = { 'U', 'P', 'S', 'F', 'S', 'H', 'M', 'T' };
+
+    /**
+   * name of a manifest segment
+   */
+    static std::string segment_name(
+        const std::string& name,
+        uint64_t generation)
+    {
+        return name + "." + std::to_string(generation);
+    };
+
+    /**
+   * name of an item segment
+   */
+    static std::string segment_name(
+        const std::string& name,
+        size_t itemtype,
+        uint64_t generation)
+    {
+        return name + "." + std::to_string(itemtype) + "." + std::to_string(generation);
+    };
+};
+
+/**
+ * UpsfShmPublisher writes the content of an UpsfCache into shared memory
+ * for UpsfShmCache readers in other processes on the same host. A single
+ * process owns the watch stream feeding the cache and the publisher:
+ *
+ *   upsf::UpsfCache cache;
+ *   upsf::UpsfSubscriptionHub hub(channel, cache.itemtypes, cache.derivedstates);
+ *   hub.attach(cache);
+ *   std::thread h([&]() { hub.run(); });
+ *   upsf::UpsfShmPublisher publisher("/upsf", cache);
+ *   std::thread t([&]() { publisher.run(std::chrono::milliseconds(100)); });
+ *
+ * Each publish() writes a new manifest and an item segment for each item
+ * type changed since the previous publish() only. Within a changed type,
+ * items not replaced since are copied from the previous item segment
+ * instead of being serialized again. Readers are switched over by bumping
+ * the generation in the control segment, replaced segments are unlinked
+ * and freed once all readers have dropped their mapping. Segments are left
+ * in place when the publisher is destroyed, so readers keep serving the
+ * last published state and a restarted publisher continues with the next
+ * generation.
+ */
+class UpsfShmPublisher {
+
+private:
+    /**
+   * item segment written by this instance, kept mapped for copying items
+   * not changed until the type is published again
+   */
+    struct Published {
+        Published() = default;
+        Published(const Published&) = delete;
+        Published& operator=(const Published&) = delete;
+
+        ~Published()
+        {
+            if (data) {
+                munmap(data, size);
+            }
+        };
+
+        // generation of the item segment
+        uint64_t generation = 0;
+        // cache revision of the item type
+        uint64_t revision = 0;
+        // mapped item segment
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        // items written with their index entry, retained so that an
+        // address identifies the version written
+        std::unordered_map<const wt474_messages::v1::Item*, std::pair<UpsfCache::ItemPtr, const UpsfShmLayout::Index*>> items;
+    };
+
+public:
+    /**
+   * constructor, name must start with a slash and contain no other slashes
+   */
+    UpsfShmPublisher(
+        const std::string& name,
+        const UpsfCache& cache)
+        : name(name)
+        , cache(cache)
+        , control(nullptr)
+        , published(false)
+        , revision(0)
+        , stopped(false) {};
+
+    /**
+   * destructor
+   */
+    virtual ~UpsfShmPublisher()
+    {
+        stop();
+        if (control) {
+            munmap(control, sizeof(UpsfShmLayout::Control));
+        }
+    };
+
+    UpsfShmPublisher(const UpsfShmPublisher&) = delete;
+    UpsfShmPublisher& operator=(const UpsfShmPublisher&) = delete;
+
+public:
+    /**
+   * publish a consistent view of the cache unless it has not changed
+   * since the last call, returns false on error
+   */
+    bool publish()
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        std::scoped_lock lock(publish_mutex);
+
+        if (!control && !open_control()) {
+            return false;
+        }
+
+        UpsfCache::View view = cache.view();
+        if (published && view.revision() == revision) {
+            return true;
+        }
+
+        uint64_t prev = control->generation.load();
+        uint64_t generation = prev + 1;
+
+        /* write item segments of changed types */
+        std::array<std::unique_ptr<Published>, UpsfCache::num_itemtypes> written;
+        size_t changed = 0;
+        for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+            wt474_upsf_service::v1::ItemType itemtype = wt474_upsf_service::v1::ItemType(index);
+            if (types[index] && types[index]->revision == view.revision(itemtype)) {
+                continue;
+            }
+            written[index] = write_type(view, index, generation);
+            if (!written[index]) {
+                for (size_t i = 0; i < index; i++) {
+                    if (written[i]) {
+                        shm_unlink(UpsfShmLayout::segment_name(name, i, generation).c_str());
+                    }
+                }
+                return false;
+            }
+            changed++;
+        }
+
+        /* write manifest */
+        UpsfShmLayout::Header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, UpsfShmLayout::data_magic, sizeof(header.magic));
+        header.version = UpsfShmLayout::format_version;
+        header.header_size = sizeof(header);
+        header.size = sizeof(header);
+        header.generation = generation;
+        header.revision = view.revision();
+        header.last_updated_seconds = view.last_updated().seconds();
+        header.last_updated_nanos = view.last_updated().nanos();
+        for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+            const Published& type = written[index] ? *written[index] : *types[index];
+            header.tables[index].generation = type.generation;
+            header.tables[index].count = type.items.size();
+        }
+        std::string manifest = UpsfShmLayout::segment_name(name, generation);
+        if (!write_segment(manifest, &header, sizeof(header))) {
+            for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+                if (written[index]) {
+                    shm_unlink(UpsfShmLayout::segment_name(name, index, generation).c_str());
+                }
+            }
+            return false;
+        }
+
+        /* segments replaced, also those of a previous publisher instance */
+        std::vector<std::string> replaced;
+        if (prev != 0) {
+            replaced.push_back(UpsfShmLayout::segment_name(name, prev));
+            for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+                if (written[index] && types[index]) {
+                    replaced.push_back(UpsfShmLayout::segment_name(name, index, types[index]->generation));
+                }
+            }
+            if (!published) {
+                replaced_by_predecessor(prev, replaced);
+            }
+        }
+
+        /* switch readers over, drop replaced segments */
+        control->generation.store(generation);
+        for (const auto& segment : replaced) {
+            shm_unlink(segment.c_str());
+        }
+        for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+            if (written[index]) {
+                types[index] = std::move(written[index]);
+            }
+        }
+        published = true;
+        revision = view.revision();
+
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " name=" << manifest << " changed=" << changed << " revision=" << revision << std::endl;
+
+        return true;
+    };
+
+    /**
+   * publish changes periodically, blocks until stop() is called
+   */
+    void run(
+        std::chrono::milliseconds interval)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        std::unique_lock<std::mutex> lock(stop_mutex);
+        while (!stopped) {
+            lock.unlock();
+            publish();
+            lock.lock();
+            stop_cond.wait_for(lock, interval, [this]() { return stopped; });
+        }
+    };
+
+    /**
+   * stop publishing changes periodically
+   */
+    void stop()
+    {
+        std::scoped_lock lock(stop_mutex);
+        stopped = true;
+        stop_cond.notify_all();
+    };
+
+    /**
+   * remove all segments of the replica, readers keep their current mapping
+   */
+    void unlink()
+    {
+        std::scoped_lock lock(publish_mutex);
+        if (control && control->generation.load() != 0) {
+            shm_unlink(UpsfShmLayout::segment_name(name, control->generation.load()).c_str());
+        }
+        for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+            if (types[index]) {
+                shm_unlink(UpsfShmLayout::segment_name(name, index, types[index]->generation).c_str());
+            }
+        }
+        shm_unlink(name.c_str());
+    };
+
+private:
+    /**
+   * write the item segment of a type, items unchanged since the type was
+   * written last are copied from the previous segment
+   */
+    std::unique_ptr<Published> write_type(
+        const UpsfCache::View& view,
+        size_t index,
+        uint64_t generation)
+    {
+        wt474_upsf_service::v1::ItemType itemtype = wt474_upsf_service::v1::ItemType(index);
+        const Published* prev = types[index].get();
+
+        /* items sorted by name, serialized unless found in the previous segment */
+        struct Pending {
+            UpsfCache::ItemPtr item;
+            const UpsfShmLayout::Index* copy;
+            std::string serialized;
+        };
+        std::vector<Pending> pending;
+        pending.reserve(view.size(itemtype));
+        bool result = true;
+        view.for_each(itemtype,
+            [&pending, &result, prev](const UpsfCache::ItemPtr& item) {
+                const UpsfShmLayout::Index* copy = nullptr;
+                if (prev) {
+                    auto it = prev->items.find(item.get());
+                    copy = (it != prev->items.end()) ? it->second.second : nullptr;
+                }
+                pending.push_back(Pending { item, copy, std::string() });
+                if (!copy) {
+                    result = item->SerializeToString(&pending.back().serialized);
+                }
+                return result;
+            });
+        if (!result) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " name:" << name << " reason:serialization failed" << std::endl;
+            return nullptr;
+        }
+        std::sort(pending.begin(), pending.end(),
+            [](const Pending& a, const Pending& b) { return item_name(*a.item) < item_name(*b.item); });
+
+        size_t size = sizeof(UpsfShmLayout::TypeHeader) + pending.size() * sizeof(UpsfShmLayout::Index);
+        for (const auto& it : pending) {
+            size += item_name(*it.item).size() + UpsfCache::ref_of(*it.item).size();
+            size += it.copy ? it.copy->item_size : it.serialized.size();
+        }
+
+        std::unique_ptr<Published> type(new Published());
+        std::string segment = UpsfShmLayout::segment_name(name, index, generation);
+        type->data = create_segment(segment, size);
+        if (!type->data) {
+            return nullptr;
+        }
+        type->size = size;
+        type->generation = generation;
+        type->revision = view.revision(itemtype);
+        type->items.reserve(pending.size());
+
+        uint8_t* data = type->data;
+        UpsfShmLayout::TypeHeader* header = reinterpret_cast<UpsfShmLayout::TypeHeader*>(data);
+        memset(header, 0, sizeof(*header));
+        memcpy(header->magic, UpsfShmLayout::type_magic, sizeof(header->magic));
+        header->version = UpsfShmLayout::format_version;
+        header->header_size = sizeof(*header);
+        header->size = size;
+        header->generation = generation;
+        header->itemtype = index;
+        header->count = pending.size();
+
+        UpsfShmLayout::Index* idx = reinterpret_cast<UpsfShmLayout::Index*>(data + sizeof(*header));
+        uint64_t pos = sizeof(*header) + pending.size() * sizeof(UpsfShmLayout::Index);
+        for (const auto& it : pending) {
+            const std::string& entry_name = item_name(*it.item);
+            const std::string& ref = UpsfCache::ref_of(*it.item);
+            idx->reserved = 0;
+            idx->name_offset = pos;
+            idx->name_size = entry_name.size();
+            memcpy(data + pos, entry_name.data(), entry_name.size());
+            pos += entry_name.size();
+            idx->ref_offset = pos;
+            idx->ref_size = ref.size();
+            memcpy(data + pos, ref.data(), ref.size());
+            pos += ref.size();
+            idx->item_offset = pos;
+            if (it.copy) {
+                idx->item_size = it.copy->item_size;
+                memcpy(data + pos, prev->data + it.copy->item_offset, it.copy->item_size);
+            } else {
+                idx->item_size = it.serialized.size();
+                memcpy(data + pos, it.serialized.data(), it.serialized.size());
+            }
+            pos += idx->item_size;
+            type->items.emplace(it.item.get(), std::make_pair(it.item, idx));
+            idx++;
+        }
+
+        return type;
+    };
+
+    /**
+   * create a new segment and map it writable, nullptr on error
+   */
+    uint8_t* create_segment(
+        const std::string& segment,
+        size_t size)
+    {
+        shm_unlink(segment.c_str());
+        int fd = shm_open(segment.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " name:" << segment << " reason:" << strerror(errno) << std::endl;
+            return nullptr;
+        }
+        void* addr = MAP_FAILED;
+        if (ftruncate(fd, size) == 0) {
+            addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (addr == MAP_FAILED) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " name:" << segment << " reason:" << strerror(errno) << std::endl;
+            shm_unlink(segment.c_str());
+            return nullptr;
+        }
+        return static_cast<uint8_t*>(addr);
+    };
+
+    /**
+   * create a segment holding a copy of buf
+   */
+    bool write_segment(
+        const std::string& segment,
+        const void* buf,
+        size_t size)
+    {
+        uint8_t* data = create_segment(segment, size);
+        if (!data) {
+            return false;
+        }
+        memcpy(data, buf, size);
+        munmap(data, size);
+        return true;
+    };
+
+    /**
+   * item segments of the manifest published by a previous instance
+   */
+    void replaced_by_predecessor(
+        uint64_t generation,
+        std::vector<std::string>& replaced)
+    {
+        std::string manifest = UpsfShmLayout::segment_name(name, generation);
+        int fd = shm_open(manifest.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return;
+        }
+        UpsfShmLayout::Header header;
+        ssize_t n = pread(fd, &header, sizeof(header), 0);
+        close(fd);
+        if (n != ssize_t(sizeof(header)) || memcmp(header.magic, UpsfShmLayout::data_magic, sizeof(header.magic)) != 0 || header.version != UpsfShmLayout::format_version) {
+            return;
+        }
+        for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+            if (header.tables[index].generation != 0) {
+                replaced.push_back(UpsfShmLayout::segment_name(name, index, header.tables[index].generation));
+            }
+        }
+    };
+
+    /**
+   * create or attach to the control segment
+   */
+    bool open_control()
+    {
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " name:" << name << " reason:" << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        void* addr = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && (size_t(st.st_size) >= sizeof(UpsfShmLayout::Control) || ftruncate(fd, sizeof(UpsfShmLayout::Control)) == 0)) {
+            addr = mmap(nullptr, sizeof(UpsfShmLayout::Control), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (addr == MAP_FAILED) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " name:" << name << " reason:" << strerror(errno) << std::endl;
+            return false;
+        }
+
+        /* initialize a new or incompatible control segment, continue an existing one */
+        control = static_cast<UpsfShmLayout::Control*>(addr);
+        if (memcmp(control->magic, UpsfShmLayout::control_magic, sizeof(control->magic)) != 0 || control->version != UpsfShmLayout::format_version) {
+            control->generation.store(0);
+            control->version = UpsfShmLayout::format_version;
+            control->reserved = 0;
+            memcpy(control->magic, UpsfShmLayout::control_magic, sizeof(control->magic));
+        }
+
+        return true;
+    };
+
+private:
+    // name of the control segment
+    std::string name;
+    // published cache
+    const UpsfCache& cache;
+    // mapped control segment
+    UpsfShmLayout::Control* control;
+    // serializes publish() calls
+    std::mutex publish_mutex;
+    // a manifest was published by this instance
+    bool published;
+    // cache revision last published
+    uint64_t revision;
+    // item segments last published per type
+    std::array<std::unique_ptr<Published>, UpsfCache::num_itemtypes> types;
+    // mutex and condition for stopped
+    std::mutex stop_mutex;
+    std::condition_variable stop_cond;
+    // stop requested
+    bool stopped;
+};
+
+/**
+ * UpsfShmCache provides read-only access to an UpsfCache replica published
+ * by an UpsfShmPublisher in another process. Views map the current manifest
+ * and its item segments and keep them mapped for their lifetime, so each
+ * view is a consistent version of all items. Item segments unchanged
+ * between versions are mapped once. Items are decoded from the mapping on
+ * access.
+ */
+class UpsfShmCache {
+
+private:
+    /**
+   * mapped segment
+   */
+    struct Segment {
+        Segment(
+            const uint8_t* data,
+            size_t size)
+            : data(data)
+            , size(size) {};
+
+        ~Segment()
+        {
+            munmap(const_cast<uint8_t*>(data), size);
+        };
+
+        const uint8_t* data;
+        size_t size;
+    };
+
+    /**
+   * published version: manifest and item segment per type
+   */
+    struct Version {
+        std::shared_ptr<const Segment> manifest;
+        std::array<std::shared_ptr<const Segment>, UpsfCache::num_itemtypes> types;
+
+        const UpsfShmLayout::Header& header() const
+        {
+            return *reinterpret_cast<const UpsfShmLayout::Header*>(manifest->data);
+        };
+    };
+
+    /**
+   * items decoded by View::find(), shared by copies of a view
+   */
+    struct Decoded {
+        std::mutex mutex;
+        std::unordered_map<const UpsfShmLayout::Index*, std::unique_ptr<wt474_messages::v1::Item>> items;
+    };
+
+public:
+    /**
+   * View provides reads of a consistent version of the replica, it is
+   * empty if nothing was published yet
+   */
+    class View {
+
+    public:
+        View(
+            std::shared_ptr<const Version> version)
+            : version(std::move(version))
+            , decoded(std::make_shared<Decoded>()) {};
+
+    public:
+        /**
+       * find item by type and name, nullptr if not present, the item is
+       * decoded once per view and remains valid while the view exists
+       */
+        const wt474_messages::v1::Item* find(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name) const
+        {
+            return decode(itemtype, lookup(itemtype, name));
+        };
+
+        /**
+       * find item by type and interned name, nullptr if not present
+       */
+        const wt474_messages::v1::Item* find(
+            wt474_upsf_service::v1::ItemType itemtype,
+            UpsfInterner::id_t name) const
+        {
+            const UpsfInterner& interner = UpsfInterner::global();
+            if (name == UpsfInterner::invalid || name >= interner.size()) {
+                return nullptr;
+            }
+            return find(itemtype, interner.str(name));
+        };
+
+        /**
+       * interned name of the item referred to by an item as in
+       * UpsfCache::View::ref(), UpsfInterner::empty if none,
+       * UpsfInterner::invalid if not present
+       */
+        UpsfInterner::id_t ref(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name) const
+        {
+            const UpsfShmLayout::Index* idx = lookup(itemtype, name);
+            if (!idx) {
+                return UpsfInterner::invalid;
+            }
+            const uint8_t* data = version->types[itemtype]->data;
+            return UpsfInterner::global().intern(std::string_view(reinterpret_cast<const char*>(data + idx->ref_offset), idx->ref_size));
+        };
+
+        /**
+       * get item by type and name, empty if not present
+       */
+        UpsfCache::ItemPtr get(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name) const
+        {
+            std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+            if (!get(itemtype, name, *item)) {
+                return UpsfCache::ItemPtr();
+            }
+            return item;
+        };
+
+        /**
+       * decode item by type and name into a caller provided instance,
+       * returns false if not present
+       */
+        bool get(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name,
+            wt474_messages::v1::Item& item) const
+        {
+            const UpsfShmLayout::Index* idx = lookup(itemtype, name);
+            return idx && item.ParseFromArray(version->types[itemtype]->data + idx->item_offset, idx->item_size);
+        };
+
+        /**
+       * number of items of a type
+       */
+        size_t size(
+            wt474_upsf_service::v1::ItemType itemtype) const
+        {
+            size_t index = itemtype;
+            return (version && index < UpsfCache::num_itemtypes) ? version->header().tables[index].count : 0;
+        };
+
+        /**
+       * cache revision of the publisher
+       */
+        uint64_t revision() const
+        {
+            return version ? version->header().revision : 0;
+        };
+
+        /**
+       * generation of the mapped manifest, 0 if nothing was published yet
+       */
+        uint64_t generation() const
+        {
+            return version ? version->header().generation : 0;
+        };
+
+        /**
+       * latest metadata.last_updated of all items applied to the cache
+       */
+        google::protobuf::Timestamp last_updated() const
+        {
+            google::protobuf::Timestamp last_updated;
+            if (version) {
+                last_updated.set_seconds(version->header().last_updated_seconds);
+                last_updated.set_nanos(version->header().last_updated_nanos);
+            }
+            return last_updated;
+        };
+
+        /**
+       * visit all items of a type in name order until fn returns false
+       */
+        void for_each(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::function<bool(const UpsfCache::ItemPtr&)>& fn) const
+        {
+            size_t index = itemtype;
+            if (!version || index >= UpsfCache::num_itemtypes) {
+                return;
+            }
+            const Segment& segment = *version->types[index];
+            const UpsfShmLayout::Index* idx = index_of(segment);
+            for (uint64_t i = 0; i < type_header(segment).count; i++) {
+                std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+                if (!item->ParseFromArray(segment.data + idx[i].item_offset, idx[i].item_size)) {
+                    continue;
+                }
+                if (!fn(item)) {
+                    return;
+                }
+            }
+        };
+
+        /**
+       * count items matching req as UpsfCache::View::count() does, false
+       * if nothing was published yet or req filters by parent
+       */
+        bool count(
+            const wt474_upsf_service::v1::ReadReq& req,
+            size_t& count) const
+        {
+            count = 0;
+            if (generation() == 0) {
+                return false;
+            }
+            /* without name and state filters the sizes tell */
+            if (req.parent_size() == 0 && req.name_size() == 0 && req.itemstate_size() == 0) {
+                for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+                    if (req.itemtype_size() == 0 || std::find(req.itemtype().begin(), req.itemtype().end(), int(index)) != req.itemtype().end()) {
+                        count += size(wt474_upsf_service::v1::ItemType(index));
+                    }
+                }
+                return true;
+            }
+            return scan(req,
+                [&count]() {
+                    count++;
+                    return true;
+                });
+        };
+
+        /**
+       * check for an item matching req as UpsfCache::View::exists() does,
+       * false if nothing was published yet or req filters by parent
+       */
+        bool exists(
+            const wt474_upsf_service::v1::ReadReq& req,
+            bool& exists) const
+        {
+            exists = false;
+            if (generation() == 0) {
+                return false;
+            }
+            return scan(req,
+                [&exists]() {
+                    exists = true;
+                    return false;
+                });
+        };
+
+    private:
+        /**
+       * call fn for each item matching req until it returns false, names
+       * are looked up in the index tables, items are decoded for state
+       * filters only
+       */
+        bool scan(
+            const wt474_upsf_service::v1::ReadReq& req,
+            const std::function<bool()>& fn) const
+        {
+            if (req.parent_size() > 0) {
+                return false;
+            }
+            wt474_messages::v1::Item item;
+            for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+                wt474_upsf_service::v1::ItemType itemtype = wt474_upsf_service::v1::ItemType(index);
+                if (req.itemtype_size() > 0 && std::find(req.itemtype().begin(), req.itemtype().end(), itemtype) == req.itemtype().end()) {
+                    continue;
+                }
+                if (req.name_size() > 0) {
+                    for (const auto& name : req.name()) {
+                        const UpsfShmLayout::Index* idx = lookup(itemtype, name.value());
+                        if (idx && matches(req, itemtype, idx, item) && !fn()) {
+                            return true;
+                        }
+                    }
+                    continue;
+                }
+                const Segment& segment = *version->types[index];
+                const UpsfShmLayout::Index* idx = index_of(segment);
+                for (uint64_t i = 0; i < type_header(segment).count; i++) {
+                    if (matches(req, itemtype, &idx[i], item) && !fn()) {
+                        return true;
+                    }
+                }
+            }
+            return true;
+        };
+
+        /**
+       * check an indexed item against the state filter of req, decoding it
+       * into item if a state filter applies
+       */
+        bool matches(
+            const wt474_upsf_service::v1::ReadReq& req,
+            wt474_upsf_service::v1::ItemType itemtype,
+            const UpsfShmLayout::Index* idx,
+            wt474_messages::v1::Item& item) const
+        {
+            if (req.itemstate_size() == 0) {
+                return true;
+            }
+            if (!item.ParseFromArray(version->types[itemtype]->data + idx->item_offset, idx->item_size)) {
+                return false;
+            }
+            return std::find(req.itemstate().begin(), req.itemstate().end(), item_metadata(item).derived_state()) != req.itemstate().end();
+        };
+
+        /**
+       * binary search by name in the type's index table
+       */
+        const UpsfShmLayout::Index* lookup(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const std::string& name) const
+        {
+            size_t index = itemtype;
+            if (!version || index >= UpsfCache::num_itemtypes) {
+                return nullptr;
+            }
+            const Segment& segment = *version->types[index];
+            const UpsfShmLayout::Index* first = index_of(segment);
+            const UpsfShmLayout::Index* last = first + type_header(segment).count;
+            const uint8_t* data = segment.data;
+            const UpsfShmLayout::Index* idx = std::lower_bound(first, last, name,
+                [data](const UpsfShmLayout::Index& entry, const std::string& name) {
+                    return std::string_view(reinterpret_cast<const char*>(data + entry.name_offset), entry.name_size) < name;
+                });
+            if (idx == last || std::string_view(reinterpret_cast<const char*>(data + idx->name_offset), idx->name_size) != name) {
+                return nullptr;
+            }
+            return idx;
+        };
+
+        /**
+       * decode an item once per view
+       */
+        const wt474_messages::v1::Item* decode(
+            wt474_upsf_service::v1::ItemType itemtype,
+            const UpsfShmLayout::Index* idx) const
+        {
+            if (!idx) {
+                return nullptr;
+            }
+            std::scoped_lock lock(decoded->mutex);
+            auto it = decoded->items.find(idx);
+            if (it != decoded->items.end()) {
+                return it->second.get();
+            }
+            const uint8_t* data = version->types[itemtype]->data;
+            std::unique_ptr<wt474_messages::v1::Item> item(new wt474_messages::v1::Item());
+            if (!item->ParseFromArray(data + idx->item_offset, idx->item_size)) {
+                return nullptr;
+            }
+            return decoded->items.emplace(idx, std::move(item)).first->second.get();
+        };
+
+    private:
+        std::shared_ptr<const Version> version;
+        std::shared_ptr<Decoded> decoded;
+    };
+
+public:
+    /**
+   * constructor, name of the replica's control segment
+   */
+    UpsfShmCache(
+        const std::string& name)
+        : name(name)
+        , control(nullptr) {};
+
+    /**
+   * destructor, views may outlive the cache instance
+   */
+    virtual ~UpsfShmCache()
+    {
+        if (control.load()) {
+            munmap(const_cast<UpsfShmLayout::Control*>(control.load()), sizeof(UpsfShmLayout::Control));
+        }
+    };
+
+    UpsfShmCache(const UpsfShmCache&) = delete;
+    UpsfShmCache& operator=(const UpsfShmCache&) = delete;
+
+public:
+    /**
+   * get view of the latest published version
+   */
+    View view()
+    {
+        std::shared_ptr<const Version> version = std::atomic_load(&current);
+        const UpsfShmLayout::Control* ctrl = control.load();
+        if (ctrl && version && version->header().generation == ctrl->generation.load()) {
+            return View(std::move(version));
+        }
+        return View(remap());
+    };
+
+    /**
+   * get item by type and name from the latest published version, empty if not present
+   */
+    UpsfCache::ItemPtr get(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name)
+    {
+        return view().get(itemtype, name);
+    };
+
+    /**
+   * number of items of a type in the latest published version
+   */
+    size_t size(
+        wt474_upsf_service::v1::ItemType itemtype)
+    {
+        return view().size(itemtype);
+    };
+
+private:
+    static const UpsfShmLayout::TypeHeader& type_header(
+        const Segment& segment)
+    {
+        return *reinterpret_cast<const UpsfShmLayout::TypeHeader*>(segment.data);
+    };
+
+    static const UpsfShmLayout::Index* index_of(
+        const Segment& segment)
+    {
+        return reinterpret_cast<const UpsfShmLayout::Index*>(segment.data + type_header(segment).header_size);
+    };
+
+    /**
+   * map the current version, keeps the previous mapping on failure
+   */
+    std::shared_ptr<const Version> remap()
+    {
+        std::scoped_lock lock(remap_mutex);
+
+        if (!control.load() && !open_control()) {
+            return std::atomic_load(&current);
+        }
+
+        /* the publisher may unlink segments right after switching generations */
+        for (int attempt = 0; attempt < 3; attempt++) {
+            uint64_t generation = control.load()->generation.load();
+            if (generation == 0) {
+                break;
+            }
+            if (current && current->header().generation == generation) {
+                break;
+            }
+            std::shared_ptr<const Version> version = open_version(generation);
+            if (version) {
+                std::atomic_store(&current, version);
+                VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " name=" << name << " generation=" << generation << std::endl;
+                break;
+            }
+        }
+
+        return std::atomic_load(&current);
+    };
+
+    /**
+   * attach to the control segment read-only
+   */
+    bool open_control()
+    {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " name=" << name << " reason=" << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        void* addr = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(UpsfShmLayout::Control)) {
+            addr = mmap(nullptr, sizeof(UpsfShmLayout::Control), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        const UpsfShmLayout::Control* ctrl = static_cast<const UpsfShmLayout::Control*>(addr);
+        if (memcmp(ctrl->magic, UpsfShmLayout::control_magic, sizeof(ctrl->magic)) != 0 || ctrl->version != UpsfShmLayout::format_version) {
+            LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " name=" << name << " reason=incompatible control segment" << std::endl;
+            munmap(addr, sizeof(UpsfShmLayout::Control));
+            return false;
+        }
+        control = ctrl;
+
+        return true;
+    };
+
+    /**
+   * map a manifest and its item segments, reusing item segments of the
+   * current version
+   */
+    std::shared_ptr<const Version> open_version(
+        uint64_t generation)
+    {
+        std::string manifest = UpsfShmLayout::segment_name(name, generation);
+        std::shared_ptr<Version> version = std::make_shared<Version>();
+        version->manifest = open_segment(manifest);
+        if (!version->manifest) {
+            return nullptr;
+        }
+        if (!valid_manifest(*version->manifest, generation)) {
+            LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " name=" << manifest << " reason=incompatible or corrupt segment" << std::endl;
+            return nullptr;
+        }
+
+        for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+            const UpsfShmLayout::Table& table = version->header().tables[index];
+            if (current && type_header(*current->types[index]).generation == table.generation) {
+                version->types[index] = current->types[index];
+                continue;
+            }
+            std::string segment = UpsfShmLayout::segment_name(name, index, table.generation);
+            version->types[index] = open_segment(segment);
+            if (!version->types[index]) {
+                return nullptr;
+            }
+            if (!valid_type(*version->types[index], index, table)) {
+                LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " name=" << segment << " reason=incompatible or corrupt segment" << std::endl;
+                return nullptr;
+            }
+        }
+
+        return version;
+    };
+
+    /**
+   * map a segment read-only
+   */
+    static std::shared_ptr<const Segment> open_segment(
+        const std::string& segment)
+    {
+        int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        void* addr = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(UpsfShmLayout::TypeHeader)) {
+            addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (addr == MAP_FAILED) {
+            return nullptr;
+        }
+        return std::make_shared<Segment>(static_cast<const uint8_t*>(addr), st.st_size);
+    };
+
+    /**
+   * check manifest header
+   */
+    static bool valid_manifest(
+        const Segment& segment,
+        uint64_t generation)
+    {
+        if (segment.size < sizeof(UpsfShmLayout::Header)) {
+            return false;
+        }
+        const UpsfShmLayout::Header& header = *reinterpret_cast<const UpsfShmLayout::Header*>(segment.data);
+        return memcmp(header.magic, UpsfShmLayout::data_magic, sizeof(header.magic)) == 0 && header.version == UpsfShmLayout::format_version && header.header_size == sizeof(header) && header.size == segment.size && header.generation == generation;
+    };
+
+    /**
+   * check item segment header and bounds of all index entries
+   */
+    static bool valid_type(
+        const Segment& segment,
+        size_t itemtype,
+        const UpsfShmLayout::Table& table)
+    {
+        const UpsfShmLayout::TypeHeader& header = type_header(segment);
+        if (memcmp(header.magic, UpsfShmLayout::type_magic, sizeof(header.magic)) != 0 || header.version != UpsfShmLayout::format_version || header.header_size != sizeof(header) || header.size != segment.size || header.generation != table.generation || header.itemtype != itemtype || header.count != table.count) {
+            return false;
+        }
+        if (header.count > (segment.size - header.header_size) / sizeof(UpsfShmLayout::Index)) {
+            return false;
+        }
+        const UpsfShmLayout::Index* idx = index_of(segment);
+        for (uint64_t i = 0; i < header.count; i++) {
+            if (idx[i].name_offset > segment.size || idx[i].name_size > segment.size - idx[i].name_offset || idx[i].ref_offset > segment.size || idx[i].ref_size > segment.size - idx[i].ref_offset || idx[i].item_offset > segment.size || idx[i].item_size > segment.size - idx[i].item_offset) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+private:
+    // name of the replica's control segment
+    std::string name;
+    // mapped control segment
+    std::atomic<const UpsfShmLayout::Control*> control;
+    // current version
+    std::shared_ptr<const Version> current;
+    // serializes remapping
+    std::mutex remap_mutex;
+};
+
+}; // end namespace upsf
+
+#endif
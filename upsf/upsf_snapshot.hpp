@@ -0,0 +1,243 @@
+/* upsf_snapshot.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_SNAPSHOT_HPP
+#define UPSF_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <google/protobuf/io/coded_stream.h>
+
+#include "upsf_cache.hpp"
+
+namespace upsf {
+
+/**
+ * UpsfCacheSnapshot persists the content of an UpsfCache to a file and
+ * restores it by memory mapping the file, so a restarted process serves
+ * reads right away and reconciles with the UPSF in the background:
+ *
+ *   UpsfCacheSnapshot::load(path, cache);
+ *   std::thread t([&]() { cache.reconcile(client); });
+ *
+ * File layout: fixed size header followed by the items, each prefixed by
+ * its varint32 encoded size. Files with a different magic or format
+ * version are rejected.
+ */
+class UpsfCacheSnapshot {
+
+public:
+    // current file format version
+    static constexpr uint32_t format_version = 1;
+
+    struct Header {
+        // file magic "UPSFSNAP"
+        char magic[8];
+        // file format version
+        uint32_t version;
+        // size of this header
+        uint32_t header_size;
+        // cache revision at save time
+        uint64_t revision;
+        // latest metadata.last_updated seen
+        int64_t last_updated_seconds;
+        int32_t last_updated_nanos;
+        uint32_t reserved;
+        // number of items following the header
+        uint64_t num_items;
+    };
+
+    /**
+   * write a consistent view of cache to path, the file is replaced atomically
+   */
+    static bool save(
+        const std::string& path,
+        const UpsfCache& cache)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        std::string tmp_path = path + ".tmp";
+        FILE* fp = fopen(tmp_path.c_str(), "w");
+        if (!fp) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " path:" << tmp_path << " reason:" << strerror(errno) << std::endl;
+            return false;
+        }
+
+        UpsfCache::View view = cache.view();
+
+        Header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = format_version;
+        header.header_size = sizeof(header);
+        header.revision = view.revision();
+        header.last_updated_seconds = view.last_updated().seconds();
+        header.last_updated_nanos = view.last_updated().nanos();
+        for (size_t index = 0; index < UpsfCache::num_itemtypes; index++) {
+            header.num_items += view.size(wt474_upsf_service::v1::ItemType(index));
+        }
+        bool result = (fwrite(&header, sizeof(header), 1, fp) == 1);
+
+        /* items: size prefix and serialized item */
+        std::string buf;
+        for (size_t index = 0; result && index < UpsfCache::num_itemtypes; index++) {
+            view.for_each(wt474_upsf_service::v1::ItemType(index),
+                [fp, &buf, &result](const UpsfCache::ItemPtr& item) {
+                    uint8_t prefix[5]; // max. varint32 size
+                    buf.clear();
+                    result = item->SerializeToString(&buf);
+                    uint8_t* end = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(buf.size(), prefix);
+                    result = result && (fwrite(prefix, end - prefix, 1, fp) == 1);
+                    result = result && (fwrite(buf.data(), buf.size(), 1, fp) == 1);
+                    return result;
+                });
+        }
+
+        result = result && (fflush(fp) == 0) && (fsync(fileno(fp)) == 0);
+        result = (fclose(fp) == 0) && result;
+        if (!result || (rename(tmp_path.c_str(), path.c_str()) != 0)) {
+            LOG(ERROR) << "failure: " << __FUNCTION__ << " path:" << path << " reason:" << strerror(errno) << std::endl;
+            unlink(tmp_path.c_str());
+            return false;
+        }
+
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " path=" << path << " items=" << header.num_items << " revision=" << header.revision << std::endl;
+
+        return true;
+    };
+
+    /**
+   * replace content of cache by the snapshot stored at path, the cache
+   * remains unchanged if the file is missing, truncated or incompatible
+   */
+    static bool load(
+        const std::string& path,
+        UpsfCache& cache)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " path=" << path << " reason=" << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(Header)) {
+            LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " path=" << path << " reason=invalid size" << std::endl;
+            close(fd);
+            return false;
+        }
+        size_t size = st.st_size;
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " path=" << path << " reason=" << strerror(errno) << std::endl;
+            return false;
+        }
+        madvise(addr, size, MADV_SEQUENTIAL);
+
+        bool result = parse(static_cast<const uint8_t*>(addr), size, cache);
+        munmap(addr, size);
+
+        if (!result) {
+            LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " path=" << path << " reason=incompatible or corrupt snapshot" << std::endl;
+        }
+
+        return result;
+    };
+
+private:
+    /**
+   * parse mapped snapshot, items are decoded straight from the mapping
+   */
+    static bool parse(
+        const uint8_t* data,
+        size_t size,
+        UpsfCache& cache)
+    {
+        Header header;
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, magic, sizeof(header.magic)) != 0 || header.version != format_version || header.header_size < sizeof(header) || header.header_size > size) {
+            return false;
+        }
+
+        std::vector<UpsfCache::ItemPtr> items;
+        items.reserve(std::min(header.num_items, uint64_t(size / 2)));
+        size_t pos = header.header_size;
+        for (uint64_t i = 0; i < header.num_items; i++) {
+            google::protobuf::io::CodedInputStream cis(data + pos, std::min(size - pos, size_t(5)));
+            uint32_t item_size;
+            if (!cis.ReadVarint32(&item_size)) {
+                return false;
+            }
+            pos += cis.CurrentPosition();
+            if (item_size > size - pos) {
+                return false;
+            }
+            std::shared_ptr<wt474_messages::v1::Item> item = std::make_shared<wt474_messages::v1::Item>();
+            if (!item->ParseFromArray(data + pos, item_size)) {
+                return false;
+            }
+            pos += item_size;
+            items.push_back(std::move(item));
+        }
+
+        google::protobuf::Timestamp last_updated;
+        last_updated.set_seconds(header.last_updated_seconds);
+        last_updated.set_nanos(header.last_updated_nanos);
+        cache.restore(items, header.revision, last_updated);
+
+        VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " items=" << items.size() << " revision=" << header.revision << std::endl;
+
+        return true;
+    };
+
+private:
+    static constexpr char magic[8] = { 'U', 'P', 'S', 'F', 'S', 'N', 'A', 'P' };
+};
+
+}; // end namespace upsf
+
+#endif
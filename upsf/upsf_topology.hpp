@@ -0,0 +1,524 @@
+/* upsf_topology.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_TOPOLOGY_HPP
+#define UPSF_TOPOLOGY_HPP
+
+#include <cstdint>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "upsf.hpp"
+#include "upsf_intern.hpp"
+
+namespace upsf {
+
+/**
+ * UpsfTopology keeps the graph of references between UPSF items:
+ *  - service gateway user plane -> service gateway
+ *  - shard -> service gateway user plane (desired and current)
+ *  - shard -> network connection (desired and current)
+ *  - session context -> shard (desired and current)
+ *  - session context -> traffic steering function
+ *
+ * Nodes are identified by 32 bit ids, every node holds the lists of nodes
+ * it refers to and of nodes referring to it. Nodes are found by the id of
+ * their name in the global UpsfInterner, except for session contexts whose
+ * short-lived names are not interned. Each edge knows its
+ * position in the reverse list, so edges are added and removed in constant
+ * time and queries run in time proportional to the nodes visited. Nodes
+ * referred to before their item arrives are kept as placeholders, ids of
+ * nodes neither present nor referred to are reused.
+ *
+ * As an UpsfSubscriber the topology is fed by an UpsfSubscriptionHub or an
+ * UpsfLoader, items in derived state deleted are removed.
+ */
+class UpsfTopology : public UpsfSubscriber {
+
+public:
+    typedef uint32_t id_t;
+
+    static constexpr id_t invalid = std::numeric_limits<id_t>::max();
+
+    struct Impact {
+        // shards placed on the user plane
+        std::vector<std::string> shards;
+        // session contexts on these shards
+        std::vector<std::string> session_contexts;
+    };
+
+    /**
+   * constructor
+   */
+    UpsfTopology()
+        : UpsfSubscriber(
+            { wt474_upsf_service::v1::ItemType::service_gateway,
+                wt474_upsf_service::v1::ItemType::service_gateway_user_plane,
+                wt474_upsf_service::v1::ItemType::traffic_steering_function,
+                wt474_upsf_service::v1::ItemType::network_connection,
+                wt474_upsf_service::v1::ItemType::shard,
+                wt474_upsf_service::v1::ItemType::session_context },
+            { wt474_messages::v1::DerivedState::unknown,
+                wt474_messages::v1::DerivedState::inactive,
+                wt474_messages::v1::DerivedState::active,
+                wt474_messages::v1::DerivedState::updating,
+                wt474_messages::v1::DerivedState::deleting,
+                wt474_messages::v1::DerivedState::deleted },
+            {}, {}, /*watch=*/true)
+        , num_edges(0) {};
+
+    /**
+   * destructor
+   */
+    virtual ~UpsfTopology() {};
+
+public:
+    /**
+   * UpsfSubscriber
+   */
+    void notify(
+        const wt474_messages::v1::ServiceGateway& service_gateway) override
+    {
+        std::vector<ref_t> refs;
+        update(wt474_upsf_service::v1::ItemType::service_gateway, service_gateway.name(),
+            service_gateway.metadata(), refs);
+    };
+
+    void notify(
+        const wt474_messages::v1::ServiceGatewayUserPlane& service_gateway_user_plane) override
+    {
+        std::vector<ref_t> refs;
+        refs.emplace_back(wt474_upsf_service::v1::ItemType::service_gateway, &service_gateway_user_plane.service_gateway_name());
+        update(wt474_upsf_service::v1::ItemType::service_gateway_user_plane, service_gateway_user_plane.name(),
+            service_gateway_user_plane.metadata(), refs);
+    };
+
+    void notify(
+        const wt474_messages::v1::TrafficSteeringFunction& traffic_steering_function) override
+    {
+        std::vector<ref_t> refs;
+        update(wt474_upsf_service::v1::ItemType::traffic_steering_function, traffic_steering_function.name(),
+            traffic_steering_function.metadata(), refs);
+    };
+
+    void notify(
+        const wt474_messages::v1::NetworkConnection& network_connection) override
+    {
+        std::vector<ref_t> refs;
+        update(wt474_upsf_service::v1::ItemType::network_connection, network_connection.name(),
+            network_connection.metadata(), refs);
+    };
+
+    void notify(
+        const wt474_messages::v1::Shard& shard) override
+    {
+        std::vector<ref_t> refs;
+        refs.emplace_back(wt474_upsf_service::v1::ItemType::service_gateway_user_plane, &shard.spec().desired_state().service_gateway_user_plane());
+        refs.emplace_back(wt474_upsf_service::v1::ItemType::service_gateway_user_plane, &shard.status().current_state().service_gateway_user_plane());
+        for (const auto& nc : shard.spec().desired_state().network_connection()) {
+            refs.emplace_back(wt474_upsf_service::v1::ItemType::network_connection, &nc);
+        }
+        for (const auto& nc : shard.status().current_state().tsf_network_connection()) {
+            refs.emplace_back(wt474_upsf_service::v1::ItemType::network_connection, &nc.second);
+        }
+        update(wt474_upsf_service::v1::ItemType::shard, shard.name(), shard.metadata(), refs);
+    };
+
+    void notify(
+        const wt474_messages::v1::SessionContext& session_context) override
+    {
+        std::vector<ref_t> refs;
+        refs.emplace_back(wt474_upsf_service::v1::ItemType::shard, &session_context.spec().desired_state().shard());
+        refs.emplace_back(wt474_upsf_service::v1::ItemType::shard, &session_context.status().current_state().user_plane_shard());
+        refs.emplace_back(wt474_upsf_service::v1::ItemType::traffic_steering_function, &session_context.spec().traffic_steering_function());
+        update(wt474_upsf_service::v1::ItemType::session_context, session_context.name(),
+            session_context.metadata(), refs);
+    };
+
+public:
+    /**
+   * get id of a node, invalid if unknown
+   */
+    id_t id(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name) const
+    {
+        std::shared_lock lock(mutex);
+        return find(itemtype, name);
+    };
+
+    /**
+   * names of items of type from_type referring to item name of type to_type
+   */
+    std::vector<std::string> referrers(
+        wt474_upsf_service::v1::ItemType to_type,
+        const std::string& name,
+        wt474_upsf_service::v1::ItemType from_type) const
+    {
+        std::shared_lock lock(mutex);
+        std::vector<std::string> names;
+        id_t id = find(to_type, name);
+        if (id != invalid) {
+            collect(id, from_type, names);
+        }
+        return names;
+    };
+
+    /**
+   * names of items of type to_type referred to by item name of type from_type
+   */
+    std::vector<std::string> references(
+        wt474_upsf_service::v1::ItemType from_type,
+        const std::string& name,
+        wt474_upsf_service::v1::ItemType to_type) const
+    {
+        std::shared_lock lock(mutex);
+        std::vector<std::string> names;
+        id_t id = find(from_type, name);
+        if (id == invalid) {
+            return names;
+        }
+        for (const auto& edge : nodes[id].out) {
+            if (nodes[edge.node].itemtype == to_type) {
+                names.push_back(name_of(nodes[edge.node]));
+            }
+        }
+        return names;
+    };
+
+    /**
+   * all session contexts on shards of a service gateway user plane
+   */
+    std::vector<std::string> session_contexts_of_service_gateway_user_plane(
+        const std::string& name) const
+    {
+        return impact_of_drain(name).session_contexts;
+    };
+
+    /**
+   * all shards using a network connection
+   */
+    std::vector<std::string> shards_of_network_connection(
+        const std::string& name) const
+    {
+        return referrers(wt474_upsf_service::v1::ItemType::network_connection, name,
+            wt474_upsf_service::v1::ItemType::shard);
+    };
+
+    /**
+   * shards and session contexts affected by draining a service gateway
+   * user plane
+   */
+    Impact impact_of_drain(
+        const std::string& name) const
+    {
+        std::shared_lock lock(mutex);
+        Impact impact;
+        id_t id = find(wt474_upsf_service::v1::ItemType::service_gateway_user_plane, name);
+        if (id == invalid) {
+            return impact;
+        }
+        for (const auto& edge : nodes[id].in) {
+            const Node& shard = nodes[edge.node];
+            if (shard.itemtype != wt474_upsf_service::v1::ItemType::shard) {
+                continue;
+            }
+            impact.shards.push_back(name_of(shard));
+            collect(edge.node, wt474_upsf_service::v1::ItemType::session_context, impact.session_contexts);
+        }
+        return impact;
+    };
+
+    /**
+   * number of nodes including placeholders
+   */
+    size_t size() const
+    {
+        std::shared_lock lock(mutex);
+        return ids.size() + uninterned.size();
+    };
+
+    /**
+   * number of edges
+   */
+    size_t edges() const
+    {
+        std::shared_lock lock(mutex);
+        return num_edges;
+    };
+
+private:
+    typedef std::pair<wt474_upsf_service::v1::ItemType, const std::string*> ref_t;
+
+    struct Edge {
+        // adjacent node
+        id_t node;
+        // position of the reverse edge in the adjacent node's list
+        uint32_t pos;
+    };
+
+    struct Node {
+        // item type
+        wt474_upsf_service::v1::ItemType itemtype;
+        // interned item name, invalid if not interned
+        UpsfInterner::id_t name_id = UpsfInterner::invalid;
+        // item name if not interned
+        std::string name;
+        // item present, placeholder otherwise
+        bool present = false;
+        // nodes referred to
+        std::vector<Edge> out;
+        // nodes referring to this one
+        std::vector<Edge> in;
+    };
+
+    static uint64_t key_of(
+        wt474_upsf_service::v1::ItemType itemtype,
+        UpsfInterner::id_t name_id)
+    {
+        return (uint64_t(itemtype) << 32) | name_id;
+    };
+
+    static std::string key_of(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name)
+    {
+        std::string key(1, char(itemtype));
+        key.append(name);
+        return key;
+    };
+
+    /**
+   * session contexts are short-lived, their names are not interned
+   */
+    static bool interned(
+        wt474_upsf_service::v1::ItemType itemtype)
+    {
+        return itemtype != wt474_upsf_service::v1::ItemType::session_context;
+    };
+
+    static const std::string& name_of(
+        const Node& node)
+    {
+        return node.name_id == UpsfInterner::invalid ? node.name : UpsfInterner::global().str(node.name_id);
+    };
+
+    id_t find(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name) const
+    {
+        if (interned(itemtype)) {
+            UpsfInterner::id_t name_id = UpsfInterner::global().find(name);
+            if (name_id != UpsfInterner::invalid) {
+                auto it = ids.find(key_of(itemtype, name_id));
+                if (it != ids.end()) {
+                    return it->second;
+                }
+            }
+        }
+        auto it = uninterned.find(key_of(itemtype, name));
+        return it == uninterned.end() ? invalid : it->second;
+    };
+
+    /**
+   * get or create node id, names the interner has no id for are kept as
+   * strings
+   */
+    id_t intern(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name)
+    {
+        UpsfInterner::id_t name_id = interned(itemtype) ? UpsfInterner::global().intern(name) : UpsfInterner::invalid;
+        id_t* slot = nullptr;
+        if (name_id != UpsfInterner::invalid) {
+            auto result = ids.emplace(key_of(itemtype, name_id), invalid);
+            if (!result.second) {
+                return result.first->second;
+            }
+            slot = &result.first->second;
+        } else {
+            auto result = uninterned.emplace(key_of(itemtype, name), invalid);
+            if (!result.second) {
+                return result.first->second;
+            }
+            slot = &result.first->second;
+        }
+        id_t id;
+        if (!unused.empty()) {
+            id = unused.back();
+            unused.pop_back();
+        } else {
+            id = nodes.size();
+            nodes.emplace_back();
+        }
+        nodes[id].itemtype = itemtype;
+        nodes[id].name_id = name_id;
+        if (name_id == UpsfInterner::invalid) {
+            nodes[id].name = name;
+        }
+        *slot = id;
+        return id;
+    };
+
+    /**
+   * release a node neither present nor referred to
+   */
+    void release(
+        id_t id)
+    {
+        Node& node = nodes[id];
+        if (node.present || !node.in.empty()) {
+            return;
+        }
+        if (node.name_id != UpsfInterner::invalid) {
+            ids.erase(key_of(node.itemtype, node.name_id));
+        } else {
+            uninterned.erase(key_of(node.itemtype, node.name));
+        }
+        node.name_id = UpsfInterner::invalid;
+        node.name.clear();
+        node.name.shrink_to_fit();
+        unused.push_back(id);
+    };
+
+    void add_edge(
+        id_t from,
+        id_t to)
+    {
+        for (const auto& edge : nodes[from].out) {
+            if (edge.node == to) {
+                return;
+            }
+        }
+        nodes[from].out.push_back(Edge { to, uint32_t(nodes[to].in.size()) });
+        nodes[to].in.push_back(Edge { from, uint32_t(nodes[from].out.size() - 1) });
+        num_edges++;
+    };
+
+    /**
+   * remove the last out edge of a node in constant time
+   */
+    void remove_last_edge(
+        id_t from)
+    {
+        Edge edge = nodes[from].out.back();
+        nodes[from].out.pop_back();
+
+        std::vector<Edge>& in = nodes[edge.node].in;
+        if (edge.pos != in.size() - 1) {
+            in[edge.pos] = in.back();
+            nodes[in[edge.pos].node].out[in[edge.pos].pos].pos = edge.pos;
+        }
+        in.pop_back();
+        num_edges--;
+
+        release(edge.node);
+    };
+
+    /**
+   * replace node and its out edges
+   */
+    void update(
+        wt474_upsf_service::v1::ItemType itemtype,
+        const std::string& name,
+        const wt474_messages::v1::MetaData& metadata,
+        const std::vector<ref_t>& refs)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        std::unique_lock lock(mutex);
+
+        bool deleted = metadata.derived_state() == wt474_messages::v1::DerivedState::deleted;
+        id_t id = deleted ? find(itemtype, name) : intern(itemtype, name);
+        if (id == invalid) {
+            return;
+        }
+
+        /* pin node while edges are replaced */
+        nodes[id].present = true;
+        while (!nodes[id].out.empty()) {
+            remove_last_edge(id);
+        }
+
+        if (deleted) {
+            nodes[id].present = false;
+            release(id);
+            return;
+        }
+
+        for (const auto& ref : refs) {
+            if (!ref.second->empty()) {
+                add_edge(id, intern(ref.first, *ref.second));
+            }
+        }
+    };
+
+    /**
+   * append names of nodes of type from_type referring to id
+   */
+    void collect(
+        id_t id,
+        wt474_upsf_service::v1::ItemType from_type,
+        std::vector<std::string>& names) const
+    {
+        for (const auto& edge : nodes[id].in) {
+            if (nodes[edge.node].itemtype == from_type) {
+                names.push_back(name_of(nodes[edge.node]));
+            }
+        }
+    };
+
+    // nodes by id
+    std::vector<Node> nodes;
+    // ids by item type and interned name
+    std::unordered_map<uint64_t, id_t> ids;
+    // ids by item type and name not interned
+    std::unordered_map<std::string, id_t> uninterned;
+    // released ids
+    std::vector<id_t> unused;
+    // number of edges
+    size_t num_edges;
+    // rwlock for all of the above
+    mutable std::shared_mutex mutex;
+};
+
+}; // end namespace upsf
+
+#endif
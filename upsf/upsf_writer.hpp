@@ -0,0 +1,456 @@
+/* upsf_writer.hpp
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, bisdn GmbH
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef UPSF_WRITER_HPP
+#define UPSF_WRITER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "upsf.hpp"
+#include "upsf_hash.hpp"
+#include "upsf_item.hpp"
+
+namespace upsf {
+
+/**
+ * UpsfWriteBehind defers item updates and writes them to UPSF in the
+ * background:
+ *  - updates equal to the last state acknowledged by UPSF (or currently
+ *    being written) are dropped,
+ *  - updates of the same item within window are merged, only the latest
+ *    value is written once the window of its first update has expired.
+ *
+ * The written callback is invoked for each update acknowledged by UPSF,
+ * the failed callback once for each update finally failed. Writes failing
+ * with a transient status (UNAVAILABLE, DEADLINE_EXCEEDED) are retried
+ * after window up to max_retries times unless superseded by a newer update,
+ * other failures are not retried. flush() writes all pending updates
+ * immediately.
+ *
+ * Example:
+ *   upsf::UpsfWriteBehind writer(channel, std::chrono::milliseconds(50));
+ *   std::thread t([&]() { writer.run(); });
+ *   writer.update(shard);
+ *   ...
+ *   writer.stop();
+ *   t.join();
+ */
+class UpsfWriteBehind {
+
+public:
+    typedef std::chrono::steady_clock clock;
+
+    typedef std::function<void(const wt474_messages::v1::Item& request, const wt474_messages::v1::Item& reply)> written_cb_t;
+
+    typedef std::function<void(const wt474_messages::v1::Item& request)> failed_cb_t;
+
+    /**
+   * constructor
+   */
+    UpsfWriteBehind(
+        std::shared_ptr<grpc::Channel> channel,
+        std::chrono::milliseconds window,
+        unsigned max_retries = 5)
+        : client(channel)
+        , window(window)
+        , max_retries(max_retries)
+        , seq(0)
+        , stopped(false)
+        , updates(0)
+        , dropped(0)
+        , merged(0)
+        , written(0)
+        , retried(0)
+        , failed(0) {};
+
+    /**
+   * destructor
+   */
+    virtual ~UpsfWriteBehind()
+    {
+        stop();
+    };
+
+    /**
+   * set callbacks for acknowledged and failed writes, must be called
+   * before run()
+   */
+    void set_callbacks(
+        written_cb_t written_cb,
+        failed_cb_t failed_cb)
+    {
+        this->written_cb = written_cb;
+        this->failed_cb = failed_cb;
+    };
+
+    /**
+   * defer update of shard
+   */
+    void update(
+        const wt474_messages::v1::Shard& shard)
+    {
+        wt474_messages::v1::Item item;
+        *item.mutable_shard() = shard;
+        update(item);
+    };
+
+    /**
+   * defer update of service gateway user plane
+   */
+    void update(
+        const wt474_messages::v1::ServiceGatewayUserPlane& sgup)
+    {
+        wt474_messages::v1::Item item;
+        *item.mutable_service_gateway_user_plane() = sgup;
+        update(item);
+    };
+
+    /**
+   * defer update of item
+   */
+    void update(
+        const wt474_messages::v1::Item& item)
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        wt474_upsf_service::v1::ItemType itemtype;
+        if (!item_type(item, itemtype)) {
+            return;
+        }
+        key_t key(itemtype, item_name(item));
+
+        std::scoped_lock lock(mutex);
+        updates++;
+
+        /* compare against the value being written or last acknowledged */
+        const wt474_messages::v1::Item* current = nullptr;
+        auto it_inflight = inflight.find(key);
+        if (it_inflight != inflight.end()) {
+            current = &it_inflight->second;
+        } else {
+            auto it_acked = acked.find(key);
+            if (it_acked != acked.end()) {
+                current = &it_acked->second;
+            }
+        }
+
+        auto it = pending.find(key);
+        if (current && UpsfHashing::equal(*current, item)) {
+            /* reverts a pending update, if any */
+            if (it != pending.end()) {
+                pending.erase(it);
+            }
+            dropped++;
+            return;
+        }
+
+        if (it != pending.end()) {
+            it->second.item = item;
+            it->second.retries = 0;
+            merged++;
+            return;
+        }
+
+        pending[key] = pending_t { item, clock::now() + window, ++seq, 0 };
+        order.push_back(std::make_pair(key, seq));
+        cond.notify_all();
+    };
+
+    /**
+   * write all pending updates now, returns false if any write failed
+   */
+    bool flush()
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+        return write(true);
+    };
+
+    /**
+   * forget all acknowledged states, e.g. after items have been changed by
+   * other clients
+   */
+    void invalidate()
+    {
+        std::scoped_lock lock(mutex);
+        acked.clear();
+    };
+
+    /**
+   * write updates when due, blocks until stop() is called, pending updates
+   * are flushed before returning
+   */
+    void run()
+    {
+        VLOG(2) << "func: " << __PRETTY_FUNCTION__ << std::endl;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopped) {
+            if (order.empty()) {
+                cond.wait(lock, [this]() { return stopped || !order.empty(); });
+                continue;
+            }
+            auto it = pending.find(order.front().first);
+            if (it == pending.end() || it->second.seq != order.front().second) {
+                order.pop_front();
+                continue;
+            }
+            if (it->second.due > clock::now()) {
+                cond.wait_until(lock, it->second.due);
+                continue;
+            }
+            lock.unlock();
+            write(false);
+            lock.lock();
+        }
+        lock.unlock();
+
+        flush();
+    };
+
+    /**
+   * stop writing updates in the background
+   */
+    void stop()
+    {
+        std::scoped_lock lock(mutex);
+        stopped = true;
+        cond.notify_all();
+    };
+
+    /**
+   * get number of updates submitted
+   */
+    uint64_t get_updates() const
+    {
+        return updates;
+    };
+
+    /**
+   * get number of updates dropped as equal to the acknowledged state
+   */
+    uint64_t get_dropped() const
+    {
+        return dropped;
+    };
+
+    /**
+   * get number of updates merged with a pending update
+   */
+    uint64_t get_merged() const
+    {
+        return merged;
+    };
+
+    /**
+   * get number of updates acknowledged by UPSF
+   */
+    uint64_t get_written() const
+    {
+        return written;
+    };
+
+    /**
+   * get number of writes retried after a transient failure
+   */
+    uint64_t get_retried() const
+    {
+        return retried;
+    };
+
+    /**
+   * get number of updates finally failed
+   */
+    uint64_t get_failed() const
+    {
+        return failed;
+    };
+
+private:
+    typedef std::pair<wt474_upsf_service::v1::ItemType, std::string> key_t;
+
+    struct pending_t {
+        // latest value
+        wt474_messages::v1::Item item;
+        // time of write
+        clock::time_point due;
+        // sequence number of entry in order
+        uint64_t seq;
+        // failed writes of this value
+        unsigned retries;
+    };
+
+    /**
+   * failure worth a retry?
+   */
+    static bool is_transient(
+        const grpc::Status& status)
+    {
+        return status.error_code() == grpc::StatusCode::UNAVAILABLE
+            || status.error_code() == grpc::StatusCode::DEADLINE_EXCEEDED;
+    };
+
+    /**
+   * write due (or all) pending updates, writes are serialized so that
+   * updates of an item reach UPSF in order
+   */
+    bool write(
+        bool all)
+    {
+        std::scoped_lock wlock(write_mutex);
+
+        std::vector<std::pair<key_t, unsigned>> keys;
+        {
+            std::scoped_lock lock(mutex);
+            clock::time_point now = clock::now();
+            while (!order.empty()) {
+                auto it = pending.find(order.front().first);
+                if (it == pending.end() || it->second.seq != order.front().second) {
+                    order.pop_front();
+                    continue;
+                }
+                if (!all && it->second.due > now) {
+                    break;
+                }
+                inflight[it->first] = std::move(it->second.item);
+                keys.push_back(std::make_pair(it->first, it->second.retries));
+                pending.erase(it);
+                order.pop_front();
+            }
+        }
+
+        bool success = true;
+        for (auto& entry : keys) {
+            const key_t& key = entry.first;
+            wt474_upsf_service::v1::UpdateReq req;
+            wt474_messages::v1::Item reply;
+            grpc::Status status;
+            {
+                std::scoped_lock lock(mutex);
+                *req.mutable_item() = inflight[key];
+            }
+
+            if (client.UpdateV1(req, reply, status)) {
+                {
+                    std::scoped_lock lock(mutex);
+                    acked[key] = std::move(inflight[key]);
+                    inflight.erase(key);
+                    written++;
+                }
+                if (written_cb) {
+                    written_cb(req.item(), reply);
+                }
+                continue;
+            }
+
+            success = false;
+            bool retry = false;
+            {
+                std::scoped_lock lock(mutex);
+                inflight.erase(key);
+                retry = is_transient(status) && entry.second < max_retries && !stopped;
+                if (retry) {
+                    retried++;
+                    /* retry unless superseded */
+                    if (pending.find(key) == pending.end()) {
+                        pending[key] = pending_t { req.item(), clock::now() + window, ++seq, entry.second + 1 };
+                        order.push_back(std::make_pair(key, seq));
+                        cond.notify_all();
+                    }
+                } else {
+                    failed++;
+                }
+            }
+            if (retry) {
+                VLOG(1) << "libupsf: " << __PRETTY_FUNCTION__ << " update of " << key.second << " failed, retry " << entry.second + 1 << std::endl;
+                continue;
+            }
+
+            LOG(WARNING) << "libupsf: " << __PRETTY_FUNCTION__ << " update of " << key.second << " failed, code:" << status.error_code() << std::endl;
+            if (failed_cb) {
+                failed_cb(req.item());
+            }
+        }
+
+        return success;
+    };
+
+    // client for writing updates
+    UpsfClient client;
+    // merge window
+    std::chrono::milliseconds window;
+    // max. retries of a transient failure
+    unsigned max_retries;
+    // callbacks
+    written_cb_t written_cb;
+    failed_cb_t failed_cb;
+    // pending updates by item type and name
+    std::map<key_t, pending_t> pending;
+    // pending updates in order of their due time
+    std::deque<std::pair<key_t, uint64_t>> order;
+    // updates being written
+    std::map<key_t, wt474_messages::v1::Item> inflight;
+    // last acknowledged updates
+    std::map<key_t, wt474_messages::v1::Item> acked;
+    // last sequence number
+    uint64_t seq;
+    // mutex and condition for all of the above
+    std::mutex mutex;
+    std::condition_variable cond;
+    // serializes writes
+    std::mutex write_mutex;
+    // stopped
+    bool stopped;
+    // statistics
+    std::atomic<uint64_t> updates;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> merged;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> retried;
+    std::atomic<uint64_t> failed;
+};
+
+}; // end namespace upsf
+
+#endif